@@ -0,0 +1,222 @@
+# SPDX-License-Identifier: Beerware
+#
+# @file      budget.py
+# @brief     RAM and flash budget report
+# @details   PlatformIO post-link script.  Parses the linker map file,
+#            prints the RAM and flash usage per module (object file or
+#            library) and fails the build if a budget configured in
+#            platformio.ini is exceeded:
+#
+#            custom_budget_ram    = <byte>  Total RAM (incl. stack and
+#                                           heap reserved by the linker
+#                                           script)
+#            custom_budget_flash  = <byte>  Total flash
+#            custom_budget_module =         RAM per module, one
+#                <module> = <byte>          assignment per line
+#            custom_budget_stack  =         Worst-case depth of a task
+#                <symbol> = <byte>          stack, one assignment per
+#                                           line; the stack array needs
+#                                           its own input section
+#                                           (-fdata-sections)
+#
+#            Can also be run stand-alone: python budget.py firmware.map
+# @author    Michael Fitzmayer
+# @copyright "THE BEER-WARE LICENCE" (Revision 42)
+
+import os
+import re
+import sys
+
+FLASH_START = 0x08000000
+RAM_START   = 0x20000000
+MEMORY_END  = 0x40000000
+RESERVED    = "(stack/heap)"
+
+# Input section with address, size and object on the same line or, if the
+# section name is too long, on the next line
+_SECTION      = re.compile(r"^ (\.\S+|COMMON)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$")
+_CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+_ADDRESS      = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+
+# Output section reserved by the linker script (main stack and heap)
+_RESERVED     = re.compile(r"^(\._user_heap_stack)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+).*)?$")
+
+
+def module_name(obj):
+    """Get module name of an object file or archive member."""
+    match = re.match(r"(.*)\((.*)\)$", obj)
+    if match:
+        # Archive member, group by library
+        name = os.path.basename(match.group(1))
+        if name.startswith("lib"):
+            name = name[3:]
+        return os.path.splitext(name)[0]
+
+    return os.path.splitext(os.path.basename(obj))[0]
+
+
+def parse_map(path, sections=None):
+    """Sum up RAM and flash usage per module; returns {module: [ram, flash]}.
+
+    If given, the size of every RAM input section is stored in sections.
+    """
+    usage   = {}
+    started = False
+    pending = None
+
+    with open(path, "r", errors="replace") as handle:
+        for line in handle:
+            line = line.rstrip("\n")
+
+            if not started:
+                # Skip discarded input sections
+                started = line.startswith("Linker script and memory map")
+                continue
+
+            if pending is not None:
+                section, module = pending
+                pending         = None
+                match           = _CONTINUATION.match(line) or _ADDRESS.match(line)
+                if match:
+                    if module is None:
+                        module = module_name(match.group(3))
+                    _account(usage, module, section, int(match.group(1), 16), int(match.group(2), 16), sections)
+                continue
+
+            match = _RESERVED.match(line)
+            if match:
+                if match.group(2) is None:
+                    pending = (match.group(1), RESERVED)
+                else:
+                    _account(usage, RESERVED, match.group(1), int(match.group(2), 16), int(match.group(3), 16))
+                continue
+
+            match = _SECTION.match(line)
+            if not match:
+                continue
+
+            if match.group(2) is None:
+                pending = (match.group(1), None)
+            else:
+                _account(usage, module_name(match.group(4)), match.group(1), int(match.group(2), 16), int(match.group(3), 16), sections)
+
+    return usage
+
+
+def _account(usage, module, section, address, size, sections=None):
+    """Account section to RAM and/or flash by its address."""
+    if (0 == size) or (FLASH_START > address) or (MEMORY_END <= address):
+        return
+
+    entry = usage.setdefault(module, [0, 0])
+
+    if RAM_START <= address:
+        entry[0] += size
+        if sections is not None:
+            sections[section] = sections.get(section, 0) + size
+        # Initialised data is copied from flash
+        if section.startswith(".data"):
+            entry[1] += size
+    else:
+        entry[1] += size
+
+
+def report(usage, budget_ram=0, budget_flash=0, budget_module=None):
+    """Print report and return list of exceeded budgets."""
+    budget_module = budget_module or {}
+    exceeded      = []
+    total_ram     = sum(entry[0] for entry in usage.values())
+    total_flash   = sum(entry[1] for entry in usage.values())
+
+    print("%-28s %8s %8s" % ("Module", "RAM", "Flash"))
+    for module, entry in sorted(usage.items(), key=lambda item: (-item[1][0], -item[1][1], item[0])):
+        limit = budget_module.get(module)
+        note  = ""
+        if limit is not None:
+            note = "  (budget %d)" % limit
+            if entry[0] > limit:
+                exceeded.append("%s RAM %d > %d" % (module, entry[0], limit))
+        print("%-28s %8d %8d%s" % (module, entry[0], entry[1], note))
+
+    print("%-28s %8d %8d" % ("Total", total_ram, total_flash))
+
+    if budget_ram:
+        print("%-28s %8d" % ("RAM budget", budget_ram))
+        if total_ram > budget_ram:
+            exceeded.append("RAM %d > %d" % (total_ram, budget_ram))
+
+    if budget_flash:
+        print("%-28s %8s %8d" % ("Flash budget", "", budget_flash))
+        if total_flash > budget_flash:
+            exceeded.append("Flash %d > %d" % (total_flash, budget_flash))
+
+    for module in budget_module:
+        if module not in usage:
+            print("Warning: budget for unknown module %s" % module)
+
+    return exceeded
+
+
+def report_stacks(sections, budget_stack):
+    """Print task stack sizes against their worst-case depth and return list of exceeded budgets."""
+    exceeded = []
+
+    if not budget_stack:
+        return exceeded
+
+    print("%-28s %8s %8s" % ("Task stack", "Size", "Depth"))
+    for symbol, depth in sorted(budget_stack.items()):
+        size = sections.get(".bss." + symbol)
+        if size is None:
+            print("Warning: stack %s not found, needs -fdata-sections" % symbol)
+            continue
+        print("%-28s %8d %8d" % (symbol, size, depth))
+        if size < depth:
+            exceeded.append("%s %d < depth %d" % (symbol, size, depth))
+
+    return exceeded
+
+
+def parse_modules(option):
+    """Parse per-module budgets ("<module> = <byte>" per line)."""
+    budget = {}
+    for line in option.splitlines():
+        line = line.strip()
+        if not line:
+            continue
+        module, _, size = line.partition("=")
+        budget[module.strip()] = int(size.strip(), 0)
+
+    return budget
+
+
+if "__main__" == __name__:
+    if 2 != len(sys.argv):
+        sys.exit("Usage: %s firmware.map" % sys.argv[0])
+
+    sys.exit(1 if report(parse_map(sys.argv[1])) else 0)
+else:
+    Import("env")
+
+    _map = os.path.join(env.subst("$BUILD_DIR"), env.subst("$PROGNAME") + ".map")
+    env.Append(LINKFLAGS=["-Wl,-Map=" + _map])
+
+    def _check_budget(source, target, env):
+        sections = {}
+        exceeded = report(
+            parse_map(_map, sections),
+            int(env.GetProjectOption("custom_budget_ram", "0"), 0),
+            int(env.GetProjectOption("custom_budget_flash", "0"), 0),
+            parse_modules(env.GetProjectOption("custom_budget_module", "")))
+        exceeded += report_stacks(
+            sections,
+            parse_modules(env.GetProjectOption("custom_budget_stack", "")))
+
+        if exceeded:
+            for message in exceeded:
+                print("Error: budget exceeded: " + message)
+            # Force relinking, so the check runs again on the next build
+            os.remove(target[0].get_abspath())
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", _check_budget)
@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Analog.c
+ * @brief     Battery and ambient light measurement
+ * @details   ADC1 scans the battery voltage divider on PB0 (IN8) and the
+ *            ambient light sensor on PB1 (IN9) twice each on every TIM3
+ *            update (65.5 ms).  The DMA writes the results to a circular
+ *            buffer; each half of it holds @ref ANALOG_OVERSAMPLING (16)
+ *            samples per channel, which are summed up when the half is
+ *            complete, i.e. after 8 TIM3 updates or about every 0.5 s.
+ *            The sum spans four additional bits (see
+ *            @ref ANALOG_FULL_SCALE); by oversampling, about two of them
+ *            are effective resolution, the rest averages out noise.
+ *
+ *            The sums are passed to the task through a lock-free message
+ *            queue (see @ref Message.c); @ref Analog_Process low-pass
+ *            filters them and publishes the values for the application.
+ *
+ *            A low battery is detected by the analog watchdog, which
+ *            checks every battery conversion in hardware and only
+ *            interrupts when the threshold is crossed.  Nothing is
+ *            measured while the MCU is in STOP mode.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_ANALOG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "Analog.h"
+#include "MCAL.h"
+#include "Message.h"
+
+#define ANALOG_CHANNELS     2U                                          ///< Battery and ambient light
+#define ANALOG_RING         (2U * ANALOG_CHANNELS * ANALOG_OVERSAMPLING) ///< DMA buffer length
+#define ANALOG_FILTER_SHIFT 2U                                          ///< Low-pass filter, weight of a new value 1/4
+#define ANALOG_BLOCKS       4U                                          ///< Sums pending for the task, a power of two
+
+/**
+ * @struct AnalogSum
+ * @brief  Sums of one half of the DMA buffer
+ */
+typedef struct
+{
+    uint32_t u32Battery; ///< Sum of the battery samples
+    uint32_t u32Light;   ///< Sum of the light samples
+
+} AnalogSum;
+
+/**
+ * @brief Convert battery voltage in mV to a single conversion result
+ */
+#define ANALOG_BATTERY_RAW(u32Mv) \
+    (uint16_t)(((u32Mv) * 4095UL) / (ANALOG_VREF_MV * ANALOG_BATTERY_DIVIDER))
+
+/**
+ * @struct AnalogData
+ * @brief  Analog measurement data
+ */
+typedef struct
+{
+    uint16_t          au16Ring[ANALOG_RING];    ///< DMA buffer, battery and light interleaved
+    AnalogSum         astBlock[ANALOG_BLOCKS];  ///< Sum blocks
+    void*             apvFree[ANALOG_BLOCKS];   ///< Free block slots
+    void*             apvQueue[ANALOG_BLOCKS];  ///< Sum queue slots
+    MessagePool       stPool;                   ///< Sum blocks, allocated by the interrupt handler
+    MessageQueue      stQueue;                  ///< Sums, from the interrupt handler to the task
+    uint16_t          u16Battery;               ///< Filtered battery value (0 to ANALOG_FULL_SCALE)
+    uint16_t          u16Light;                 ///< Filtered light value (0 to ANALOG_FULL_SCALE)
+    volatile bool     bLow;                     ///< Battery voltage is low
+    bool              bPrimed;                  ///< Filters hold a value
+
+} AnalogData;
+
+/**
+ * @var   _stAnalog
+ * @brief Analog measurement private data
+ */
+static AnalogData _stAnalog;
+
+static uint16_t _Filter(uint16_t u16Value, uint32_t u32Sum);
+
+/**
+ * @brief  Get ambient light
+ * @return Filtered light value (0: dark to @ref ANALOG_FULL_SCALE)
+ */
+uint16_t Analog_GetAmbientLight(void)
+{
+    return _stAnalog.u16Light;
+}
+
+/**
+ * @brief  Get battery voltage
+ * @return Filtered battery voltage in mV
+ */
+uint16_t Analog_GetBatteryVoltage(void)
+{
+    return (uint16_t)(((uint32_t)_stAnalog.u16Battery * ANALOG_VREF_MV * ANALOG_BATTERY_DIVIDER) / ANALOG_FULL_SCALE);
+}
+
+/**
+ * @brief  Initialise battery and ambient light measurement
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Analog_Init(void)
+{
+    _stAnalog.bLow    = false;
+    _stAnalog.bPrimed = false;
+
+    if (0 != Message_InitPool(&_stAnalog.stPool, _stAnalog.apvFree, _stAnalog.astBlock, ANALOG_BLOCKS, sizeof(AnalogSum)))
+    {
+        return -1;
+    }
+
+    if (0 != Message_InitQueue(&_stAnalog.stQueue, _stAnalog.apvQueue, ANALOG_BLOCKS))
+    {
+        return -1;
+    }
+
+    if (0 != ADC_Start(_stAnalog.au16Ring, ANALOG_RING))
+    {
+        return -1;
+    }
+
+    ADC_SetWatchdog(ANALOG_BATTERY_RAW(ANALOG_BATTERY_LOW_MV), 4095);
+
+    return 0;
+}
+
+/**
+ * @brief  Check if the battery voltage is low
+ * @return Boolean state
+ */
+bool Analog_IsBatteryLow(void)
+{
+    return _stAnalog.bLow;
+}
+
+/**
+ * @brief Filter the sums passed by the interrupt handler
+ * @note  Call periodically from the task reading the values.
+ */
+void Analog_Process(void)
+{
+    void*    apvSum[ANALOG_BLOCKS];
+    uint16_t u16Count = Message_Drain(&_stAnalog.stQueue, apvSum, ANALOG_BLOCKS);
+
+    for (uint16_t u16Idx = 0; u16Idx < u16Count; u16Idx++)
+    {
+        const AnalogSum* pstSum = (const AnalogSum*)apvSum[u16Idx];
+
+        if (! _stAnalog.bPrimed)
+        {
+            _stAnalog.u16Battery = (uint16_t)pstSum->u32Battery;
+            _stAnalog.u16Light   = (uint16_t)pstSum->u32Light;
+            _stAnalog.bPrimed    = true;
+        }
+        else
+        {
+            _stAnalog.u16Battery = _Filter(_stAnalog.u16Battery, pstSum->u32Battery);
+            _stAnalog.u16Light   = _Filter(_stAnalog.u16Light,   pstSum->u32Light);
+        }
+
+        Message_Free(&_stAnalog.stPool, apvSum[u16Idx]);
+    }
+}
+
+/**
+ * @brief Decimate half of the DMA buffer
+ * @note  Called from the DMA half and full transfer interrupt.  The
+ *        sum is dropped while all blocks are pending.
+ * @param bSecondHalf
+ *        true: second half is complete, false: first half
+ */
+void Analog_Update(bool bSecondHalf)
+{
+    const uint16_t* pu16Half = &_stAnalog.au16Ring[bSecondHalf ? (ANALOG_RING / 2U) : 0];
+    AnalogSum*      pstSum   = (AnalogSum*)Message_Alloc(&_stAnalog.stPool);
+
+    if (NULL == pstSum)
+    {
+        return;
+    }
+
+    pstSum->u32Battery = 0;
+    pstSum->u32Light   = 0;
+
+    for (uint8_t u8Idx = 0; u8Idx < (ANALOG_RING / 2U); u8Idx += ANALOG_CHANNELS)
+    {
+        pstSum->u32Battery += pu16Half[u8Idx];
+        pstSum->u32Light   += pu16Half[u8Idx + 1U];
+    }
+
+    (void)Message_Put(&_stAnalog.stQueue, pstSum);
+}
+
+/**
+ * @brief Analog watchdog handler
+ * @note  Called from the ADC interrupt.  The window is moved, so the
+ *        next interrupt occurs when the battery voltage crosses the
+ *        threshold in the opposite direction.
+ */
+void Analog_Watchdog(void)
+{
+    if (_stAnalog.bLow)
+    {
+        _stAnalog.bLow = false;
+        ADC_SetWatchdog(ANALOG_BATTERY_RAW(ANALOG_BATTERY_LOW_MV), 4095);
+    }
+    else
+    {
+        _stAnalog.bLow = true;
+        ADC_SetWatchdog(0, ANALOG_BATTERY_RAW(ANALOG_BATTERY_LOW_MV + ANALOG_BATTERY_HYST_MV));
+    }
+}
+
+/**
+ * @brief  Low-pass filter
+ * @param  u16Value
+ *         Current value
+ * @param  u32Sum
+ *         New sum of samples
+ * @return New value
+ */
+static uint16_t _Filter(uint16_t u16Value, uint32_t u32Sum)
+{
+    int32_t s32Delta = (int32_t)u32Sum - (int32_t)u16Value;
+
+    return (uint16_t)((int32_t)u16Value + (s32Delta / (1 << ANALOG_FILTER_SHIFT)));
+}
+
+#endif // USE_ANALOG
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Analog.h
+ * @brief Battery and ambient light measurement
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef ANALOG_VREF_MV
+    #define ANALOG_VREF_MV         3300U ///< ADC reference voltage in mV
+#endif
+#ifndef ANALOG_BATTERY_DIVIDER
+    #define ANALOG_BATTERY_DIVIDER 2U    ///< Battery voltage divider ratio (PB0)
+#endif
+#ifndef ANALOG_BATTERY_LOW_MV
+    #define ANALOG_BATTERY_LOW_MV  3500U ///< Low battery threshold in mV
+#endif
+#ifndef ANALOG_BATTERY_HYST_MV
+    #define ANALOG_BATTERY_HYST_MV 100U  ///< Hysteresis of the low battery threshold in mV
+#endif
+
+#define ANALOG_OVERSAMPLING 16U                           ///< Samples per channel summed up per value
+#define ANALOG_FULL_SCALE   (4095U * ANALOG_OVERSAMPLING) ///< Max. value, 12 + 4 bits
+
+#ifdef USE_ANALOG
+uint16_t Analog_GetAmbientLight(void);
+uint16_t Analog_GetBatteryVoltage(void);
+int      Analog_Init(void);
+bool     Analog_IsBatteryLow(void);
+void     Analog_Process(void);
+void     Analog_Update(bool bSecondHalf);
+void     Analog_Watchdog(void);
+#endif
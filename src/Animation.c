@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "Animation.h"
+#include "Profile.h"
 
 static void _AddIconToBuffer(const IconID eID, uint8_t u8IconOffset);
 
@@ -3077,6 +3078,8 @@ void Animation_Update(void)
 {
     static uint8_t u8IconOffset = 0;
 
+    PROFILE_SCOPE(PROFILE_ANIMATION_UPDATE);
+
     AnimID   eID       = _stAnimation.eAnim;
     uint16_t u16Offset = _stAnimation.astSet[eID].u16Offset;
 
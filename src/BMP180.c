@@ -14,6 +14,14 @@
 #include <stdint.h>
 #include "BMP180.h"
 #include "MCAL.h"
+#include "Profile.h"
+#include "Timer.h"
+
+#ifdef USE_RECORD
+#include "Record.h"
+#endif
+
+#define BMP180_CONVERSION_TIME 4500U ///< Max. temperature conversion time in µs
 
 /**
  * @enum  BMP180_Register
@@ -136,6 +144,8 @@ int BMP180_ReadTemperature(int8_t* ps8Temp)
     int32_t s32UT      = 0;
     int32_t s32T       = 0;
 
+    PROFILE_SCOPE(PROFILE_BMP180_READ);
+
     // Trigger temperature conversion
     nError = I2C_Transmit(BMP180_ADDRESS_WRITE, CTRL_MEAS, I2C_MEMSIZE_8BIT, &u8RegValue, 1);
     if (0 != nError)
@@ -145,7 +155,7 @@ int BMP180_ReadTemperature(int8_t* ps8Temp)
     I2C_WaitUntilReady(BMP180_ADDRESS_READ);
 
     // Wait until conversion is complete
-    MCAL_Sleep(5);
+    Timer_Delay(BMP180_CONVERSION_TIME);
 
     // Read uncompensated temperature value
     nError = _BMP180_ReadRegister(OUT_MSB, (int16_t*)&s32UT);
@@ -160,6 +170,10 @@ int BMP180_ReadTemperature(int8_t* ps8Temp)
 
     *ps8Temp = (int8_t)(s32T);
 
+    #ifdef USE_RECORD
+    Record_Temperature(*ps8Temp);
+    #endif
+
     return 0;
 }
 
@@ -0,0 +1,377 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Button.c
+ * @brief     Button input
+ * @details   Three active-low buttons on EXTI lines.  Debouncing works
+ *            on the leading edge: the first edge of a button is
+ *            reported at once and its EXTI line is masked for
+ *            @ref BUTTON_DEBOUNCE_TIME.  A one-shot compare on TIM3 (see
+ *            @ref MCAL_StartDebounce) then re-enters @ref Button_Update,
+ *            which unmasks the line and picks up a level change missed
+ *            during the lockout.  The same timer checks held buttons
+ *            for long presses.
+ *
+ *            Gestures are passed to the task through a lock-free
+ *            message queue (see @ref Message.c) with the events in a
+ *            pool of blocks; a binary semaphore wakes the task:
+ *
+ *            - Short press: a single button was released before
+ *              @ref BUTTON_LONG_PRESS_TIME.
+ *            - Long press: a single button has been held down for
+ *              @ref BUTTON_LONG_PRESS_TIME; sent while it is still
+ *              held.
+ *            - Combination: several buttons were held down at the same
+ *              time; sent once the first of them is released.
+ *
+ *            TIM3 stops in STOP mode, so the MCU stays out of it while a
+ *            button is held down or locked out, see
+ *            @ref Button_IsBusy.  A press wakes the MCU via EXTI.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_BUTTONS
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Button.h"
+#include "FreeRTOS.h"
+#include "MCAL.h"
+#include "Message.h"
+#include "Profile.h"
+#include "semphr.h"
+
+#ifdef USE_RECORD
+#include "Record.h"
+#endif
+
+#define BUTTON_COUNT           3       ///< Number of buttons
+#define BUTTON_QUEUE_LENGTH    8       ///< Max. number of pending events, a power of two
+#define BUTTON_DEBOUNCE_TIME   20000U  ///< Lockout after an edge in µs
+#define BUTTON_LONG_PRESS_TIME 800000U ///< Long press threshold in µs
+#define BUTTON_MIN_TIMEOUT     100U    ///< Min. timeout in µs
+#define BUTTON_MAX_TIMEOUT     60000U  ///< Max. timeout of the 16-bit timer in µs
+
+/**
+ * @struct ButtonData
+ * @brief  Button data
+ */
+typedef struct
+{
+    ButtonEvent       astBlock[BUTTON_QUEUE_LENGTH];   ///< Event blocks
+    void*             apvFree[BUTTON_QUEUE_LENGTH];    ///< Free block slots
+    void*             apvQueue[BUTTON_QUEUE_LENGTH];   ///< Event queue slots
+    MessagePool       stPool;                          ///< Event blocks, allocated by the interrupt handler
+    MessageQueue      stQueue;                         ///< Events, from the interrupt handler to the task
+    StaticSemaphore_t stSignal;                        ///< Wake-up semaphore control block
+    SemaphoreHandle_t hSignal;                         ///< Wake-up semaphore, given on every event
+    uint32_t          au32Down[BUTTON_COUNT];          ///< Press time stamps in µs
+    uint32_t          u32LockedAt;                     ///< Start of the lockout in µs
+    uint8_t           u8State;                         ///< Debounced state (pressed buttons)
+    uint8_t           u8Locked;                        ///< Buttons in lockout
+    uint8_t           u8Session;                       ///< Buttons pressed since all were released
+    uint8_t           u8Long;                          ///< Buttons which have sent a long press
+    bool              bComboSent;                      ///< Combination of the session has been sent
+
+} ButtonData;
+
+/**
+ * @var   _stButton
+ * @brief Button private data
+ */
+static ButtonData _stButton = { 0 };
+
+/**
+ * @var   _au16Pin
+ * @brief Button pins
+ */
+static const uint16_t _au16Pin[BUTTON_COUNT] = {
+    BUTTON_A_Pin,
+    BUTTON_B_Pin,
+    BUTTON_C_Pin
+};
+
+static void     _Gesture(uint8_t u8Changed, uint32_t u32Now, uint32_t u32Ticks, BaseType_t* pxWoken);
+static uint16_t _PinMask(uint8_t u8Buttons);
+static uint8_t  _Read(void);
+static void     _Send(ButtonGesture eGesture, uint8_t u8Buttons, uint32_t u32Ticks, BaseType_t* pxWoken);
+
+/**
+ * @brief  Get next button event
+ * @param  pstEvent
+ *         Pointer to event
+ * @param  u32TimeoutInMs
+ *         Time to wait for an event in ms (0: do not block,
+ *         portMAX_DELAY: wait forever)
+ * @return Event received
+ */
+bool Button_GetEvent(ButtonEvent* pstEvent, uint32_t u32TimeoutInMs)
+{
+    TickType_t xTimeout = portMAX_DELAY;
+    void*      pvBlock;
+
+    if (portMAX_DELAY != u32TimeoutInMs)
+    {
+        xTimeout = pdMS_TO_TICKS(u32TimeoutInMs);
+    }
+
+    // A signal left from events taken earlier only repeats the check
+    while (0 == Message_Drain(&_stButton.stQueue, &pvBlock, 1))
+    {
+        if (pdTRUE != xSemaphoreTake(_stButton.hSignal, xTimeout))
+        {
+            return false;
+        }
+    }
+
+    *pstEvent = *(ButtonEvent*)pvBlock;
+    Message_Free(&_stButton.stPool, pvBlock);
+
+    #ifdef USE_RECORD
+    Record_Log(RECORD_BUTTON, ((uint32_t)pstEvent->u8Gesture << 8) | pstEvent->u8Buttons);
+    #endif
+
+    return true;
+}
+
+/**
+ * @brief  Initialise button input
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Button_Init(void)
+{
+    SemaphoreHandle_t hSignal;
+
+    if (0 != Message_InitPool(&_stButton.stPool, _stButton.apvFree, _stButton.astBlock, BUTTON_QUEUE_LENGTH, sizeof(ButtonEvent)))
+    {
+        return -1;
+    }
+
+    if (0 != Message_InitQueue(&_stButton.stQueue, _stButton.apvQueue, BUTTON_QUEUE_LENGTH))
+    {
+        return -1;
+    }
+
+    hSignal = xSemaphoreCreateBinaryStatic(&_stButton.stSignal);
+    if (NULL == hSignal)
+    {
+        return -1;
+    }
+
+    taskENTER_CRITICAL();
+    _stButton.u8State = _Read();
+    _stButton.hSignal = hSignal;
+    taskEXIT_CRITICAL();
+
+    return 0;
+}
+
+/**
+ * @brief  Check if the debounce timer is needed
+ * @return A button is held down or locked out
+ */
+bool Button_IsBusy(void)
+{
+    return ((0 != _stButton.u8Locked) || (0 != _stButton.u8Session));
+}
+
+/**
+ * @brief Button interrupt handler
+ * @note  Called on every button edge and when the debounce timer
+ *        elapses; must run at an interrupt priority that may call the
+ *        FreeRTOS ISR API.
+ */
+void Button_Update(void)
+{
+    BaseType_t xWoken     = pdFALSE;
+    uint32_t   u32Ticks   = PROFILE_TICKS();
+    uint32_t   u32Now     = MCAL_GetMicroseconds();
+    uint32_t   u32Timeout = BUTTON_MAX_TIMEOUT;
+    bool       bTimeout   = false;
+    uint8_t    u8Changed;
+
+    if (NULL == _stButton.hSignal)
+    {
+        return;
+    }
+
+    if ((0 != _stButton.u8Locked) && (BUTTON_DEBOUNCE_TIME <= (u32Now - _stButton.u32LockedAt)))
+    {
+        GPIO_EnableInterrupt(_PinMask(_stButton.u8Locked));
+        _stButton.u8Locked = 0;
+    }
+
+    // Report the leading edge, ignore bouncing lines
+    u8Changed = (_Read() ^ _stButton.u8State) & ~_stButton.u8Locked;
+    if (0 != u8Changed)
+    {
+        GPIO_DisableInterrupt(_PinMask(u8Changed));
+        _stButton.u8State     ^= u8Changed;
+        _stButton.u8Locked    |= u8Changed;
+        _stButton.u32LockedAt  = u32Now;
+
+        _Gesture(u8Changed, u32Now, u32Ticks, &xWoken);
+    }
+
+    if (0 != _stButton.u8Locked)
+    {
+        u32Timeout = BUTTON_DEBOUNCE_TIME - (u32Now - _stButton.u32LockedAt);
+        bTimeout   = true;
+    }
+
+    // Long press of a single button
+    if ((1 == __builtin_popcount(_stButton.u8Session)) && (0 != (_stButton.u8Session & _stButton.u8State)) && (0 == _stButton.u8Long))
+    {
+        uint8_t  u8Idx   = (uint8_t)__builtin_ctz(_stButton.u8Session);
+        uint32_t u32Held = u32Now - _stButton.au32Down[u8Idx];
+
+        if (BUTTON_LONG_PRESS_TIME <= u32Held)
+        {
+            _Send(BUTTON_LONG, _stButton.u8Session, u32Ticks, &xWoken);
+            _stButton.u8Long = _stButton.u8Session;
+        }
+        else
+        {
+            if ((BUTTON_LONG_PRESS_TIME - u32Held) < u32Timeout)
+            {
+                u32Timeout = BUTTON_LONG_PRESS_TIME - u32Held;
+            }
+            bTimeout = true;
+        }
+    }
+
+    if (bTimeout)
+    {
+        if (BUTTON_MIN_TIMEOUT > u32Timeout)
+        {
+            u32Timeout = BUTTON_MIN_TIMEOUT;
+        }
+        MCAL_StartDebounce((uint16_t)u32Timeout);
+    }
+
+    portYIELD_FROM_ISR(xWoken);
+}
+
+/**
+ * @brief Detect gestures
+ * @param u8Changed
+ *        Buttons which have changed their debounced state
+ * @param u32Now
+ *        Current time in µs
+ * @param u32Ticks
+ *        Profiling time stamp
+ * @param pxWoken
+ *        Set if a higher priority task has been woken
+ */
+static void _Gesture(uint8_t u8Changed, uint32_t u32Now, uint32_t u32Ticks, BaseType_t* pxWoken)
+{
+    uint8_t u8Pressed  = u8Changed & _stButton.u8State;
+    uint8_t u8Released = u8Changed & ~_stButton.u8State;
+
+    for (uint8_t u8Idx = 0; u8Idx < BUTTON_COUNT; u8Idx++)
+    {
+        if (u8Pressed & (1U << u8Idx))
+        {
+            _stButton.au32Down[u8Idx] = u32Now;
+        }
+    }
+
+    _stButton.u8Session |= u8Pressed;
+
+    if (0 != u8Released)
+    {
+        if (1 < __builtin_popcount(_stButton.u8Session))
+        {
+            if ((! _stButton.bComboSent) && (0 == _stButton.u8Long))
+            {
+                _Send(BUTTON_COMBO, _stButton.u8Session, u32Ticks, pxWoken);
+                _stButton.bComboSent = true;
+            }
+        }
+        else if (0 == (u8Released & _stButton.u8Long))
+        {
+            _Send(BUTTON_SHORT, u8Released, u32Ticks, pxWoken);
+        }
+    }
+
+    if (0 == _stButton.u8State)
+    {
+        _stButton.u8Session  = 0;
+        _stButton.u8Long     = 0;
+        _stButton.bComboSent = false;
+    }
+}
+
+/**
+ * @brief  Get pin mask of buttons
+ * @param  u8Buttons
+ *         Buttons
+ * @return Pin mask
+ */
+static uint16_t _PinMask(uint8_t u8Buttons)
+{
+    uint16_t u16PinMask = 0;
+
+    for (uint8_t u8Idx = 0; u8Idx < BUTTON_COUNT; u8Idx++)
+    {
+        if (u8Buttons & (1U << u8Idx))
+        {
+            u16PinMask |= _au16Pin[u8Idx];
+        }
+    }
+
+    return u16PinMask;
+}
+
+/**
+ * @brief  Read button pins
+ * @return Pressed buttons
+ */
+static uint8_t _Read(void)
+{
+    uint8_t u8Buttons = 0;
+
+    for (uint8_t u8Idx = 0; u8Idx < BUTTON_COUNT; u8Idx++)
+    {
+        // Active low
+        if (! GPIO_IsSet(BUTTON_GPIO_Port, _au16Pin[u8Idx]))
+        {
+            u8Buttons |= (1U << u8Idx);
+        }
+    }
+
+    return u8Buttons;
+}
+
+/**
+ * @brief Send event; dropped if all blocks are in use
+ * @param eGesture
+ *        Gesture
+ * @param u8Buttons
+ *        Buttons involved
+ * @param u32Ticks
+ *        Profiling time stamp
+ * @param pxWoken
+ *        Set if a higher priority task has been woken
+ */
+static void _Send(ButtonGesture eGesture, uint8_t u8Buttons, uint32_t u32Ticks, BaseType_t* pxWoken)
+{
+    ButtonEvent* pstEvent = (ButtonEvent*)Message_Alloc(&_stButton.stPool);
+
+    if (NULL == pstEvent)
+    {
+        return;
+    }
+
+    pstEvent->u32Ticks  = u32Ticks;
+    pstEvent->u8Gesture = (uint8_t)eGesture;
+    pstEvent->u8Buttons = u8Buttons;
+
+    // Every block is either free or queued, the queue cannot overflow
+    (void)Message_Put(&_stButton.stQueue, pstEvent);
+    xSemaphoreGiveFromISR(_stButton.hSignal, pxWoken);
+}
+
+#endif // USE_BUTTONS
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Button.h
+ * @brief Button input
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "MCAL.h"
+
+#ifndef BUTTON_A_Pin
+    #define BUTTON_A_Pin     GPIO_PIN_12 ///< Button A pin
+#endif
+#ifndef BUTTON_B_Pin
+    #define BUTTON_B_Pin     GPIO_PIN_13 ///< Button B pin
+#endif
+#ifndef BUTTON_C_Pin
+    #define BUTTON_C_Pin     GPIO_PIN_14 ///< Button C pin
+#endif
+#ifndef BUTTON_GPIO_Port
+    #define BUTTON_GPIO_Port GPIO_PORT_B ///< Button GPIO port
+#endif
+
+#define BUTTON_A 0x01 ///< Button A mask
+#define BUTTON_B 0x02 ///< Button B mask
+#define BUTTON_C 0x04 ///< Button C mask
+
+/**
+ * @enum  ButtonGesture
+ * @brief Button gestures
+ */
+typedef enum
+{
+    BUTTON_SHORT = 0, ///< Single button pressed and released
+    BUTTON_LONG,      ///< Single button held down
+    BUTTON_COMBO      ///< Several buttons held down at the same time
+
+} ButtonGesture;
+
+/**
+ * @struct ButtonEvent
+ * @brief  Button event
+ */
+typedef struct
+{
+    uint32_t u32Ticks;  ///< Profiling time stamp of the triggering edge
+    uint8_t  u8Gesture; ///< Gesture (@ref ButtonGesture)
+    uint8_t  u8Buttons; ///< Buttons involved (BUTTON_A, BUTTON_B, BUTTON_C)
+
+} ButtonEvent;
+
+#ifdef USE_BUTTONS
+bool Button_GetEvent(ButtonEvent* pstEvent, uint32_t u32TimeoutInMs);
+int  Button_Init(void);
+bool Button_IsBusy(void);
+void Button_Update(void);
+#endif
@@ -8,14 +8,19 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include "Clock.h"
+#include "Font.h"
 #include "MCAL.h"
+#include "Profile.h"
 
 #ifdef USE_BMP180
 #include <stdlib.h>
 #include "BMP180.h"
 #endif
 
+#define CLOCK_MARQUEE_STEP_MS 30 ///< Marquee scroll step (33 fps)
+
 /**
  * @struct ClockData
  * @brief  Clock handler data
@@ -32,6 +37,10 @@ typedef struct
 
     uint8_t      au8Buffer[64]; ///< Buffer for current clock-face
 
+    FontMarquee  stMarquee;     ///< Message scrolling over the clock-face
+    uint32_t     u32Step;       ///< System tick of the last marquee step
+    bool         bMarquee;      ///< A message is being shown
+
 } ClockData;
 
 /**
@@ -41,16 +50,26 @@ typedef struct
 static ClockData _stClock = { 0 };
 
 /**
- * @var   _au8ClockFont
- * @brief 6x6 Clock font
+ * @var   _stTimeRegion
+ * @brief Clock-face region of hours and minutes
+ */
+#ifndef USE_BMP180
+static const FontRegion _stTimeRegion = { 0, 5, 32, 5 };
+#else
+static const FontRegion _stTimeRegion = { 0, 2, 32, 5 };
+
+/**
+ * @var   _stTempRegion
+ * @brief Clock-face region of the temperature
  */
-static const uint8_t _au8ClockFont[50] = {
-    0b01111100, 0b00001000, 0b01111000, 0b01111100, 0b01000000, 0b01111100, 0b01111100, 0b01111100, 0b01111100, 0b01111100,
-    0b01001100, 0b00011000, 0b00000100, 0b00000100, 0b01000000, 0b01000000, 0b01000000, 0b00000100, 0b01000100, 0b01000100,
-    0b01010100, 0b00001000, 0b00111000, 0b01111000, 0b01010000, 0b01111000, 0b01111100, 0b00001000, 0b01111100, 0b01111100,
-    0b01100100, 0b00001000, 0b01000000, 0b00000100, 0b01111100, 0b00000100, 0b01000100, 0b00010000, 0b01000100, 0b00000100,
-    0b01111100, 0b00011100, 0b01111100, 0b01111100, 0b00010000, 0b01111000, 0b01111100, 0b00010000, 0b01111100, 0b01111100,
-};
+static const FontRegion _stTempRegion = { 8, 9, 16, 5 };
+#endif
+
+/**
+ * @var   _stMessageRegion
+ * @brief Region of scrolling messages
+ */
+static const FontRegion _stMessageRegion = { 0, 5, 32, 5 };
 
 /**
  * @brief  Get address of image buffer
@@ -62,71 +81,70 @@ uint8_t* Clock_GetBufferAddr(void)
 }
 
 /**
- * @brief Update clock-face buffer
+ * @brief  Scroll a message over the clock-face once
+ * @param  pacText
+ *         Zero-terminated text; replaces a message being shown
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error, text too long
  */
-void Clock_Update(void)
+int Clock_ShowText(const char* pacText)
 {
-    int8_t  s8Idx;
-    uint8_t u8Temp;
-    uint8_t u8Offset;
-    uint8_t u8Digit[6] = { 0 };
-
-    // Fetch current time from RTC
-    RTC_GetTime(&_stClock.u8Hours, &_stClock.u8Minutes, &_stClock.u8Seconds);
-
-    // Extract digits
-    #ifdef USE_BMP180
-    u8Temp = abs(_stClock.s8Temperature);
-    for (s8Idx = 5; s8Idx >= 4; s8Idx--)
+    if (0 != Font_SetMarquee(&_stClock.stMarquee, FONT_SMALL, pacText, &_stMessageRegion))
     {
-        u8Digit[s8Idx]  = u8Temp % 10;
-        u8Temp         /= 10;
+        return -1;
     }
-    #endif
 
-    u8Temp = _stClock.u8Minutes;
-    for (s8Idx = 3; s8Idx >= 2; s8Idx--)
-    {
-        u8Digit[s8Idx]  = u8Temp % 10;
-        u8Temp         /= 10;
-    }
+    memset(_stClock.au8Buffer, 0, sizeof(_stClock.au8Buffer));
+    _stClock.u32Step  = MCAL_GetTick() - CLOCK_MARQUEE_STEP_MS;
+    _stClock.bMarquee = true;
 
-    u8Temp = _stClock.u8Hours;
-    for (s8Idx = 1; s8Idx >= 0; s8Idx--)
-    {
-        u8Digit[s8Idx]  = u8Temp % 10;
-        u8Temp         /= 10;
-    }
+    return 0;
+}
 
-    // Write digits to clock-face buffer
-    for (uint8_t u8Dig = 0; u8Dig < 4; u8Dig++)
-    {
-        uint8_t u8IdxStart = 20;
-        uint8_t u8IdxEnd   = 38;
-        #ifdef USE_BMP180
-        u8IdxStart =  8;
-        u8IdxEnd   = 26;
-        #endif
+/**
+ * @brief Update clock-face buffer
+ */
+void Clock_Update(void)
+{
+    char acTime[5];
 
-        u8Offset = u8Digit[u8Dig];
+    PROFILE_SCOPE(PROFILE_CLOCK_UPDATE);
 
-        for (uint8_t u8Idx = u8IdxStart + u8Dig; u8Idx <= u8IdxEnd + u8Dig; u8Idx += 4)
+    if (_stClock.bMarquee)
+    {
+        if (CLOCK_MARQUEE_STEP_MS <= (MCAL_GetTick() - _stClock.u32Step))
         {
-            _stClock.au8Buffer[u8Idx] = _au8ClockFont[u8Offset];
-            u8Offset += 10;
+            _stClock.u32Step += CLOCK_MARQUEE_STEP_MS;
+
+            if (Font_StepMarquee(&_stClock.stMarquee, _stClock.au8Buffer))
+            {
+                _stClock.bMarquee = false;
+            }
         }
+        return;
     }
 
+    // Fetch current time from RTC
+    RTC_GetTime(&_stClock.u8Hours, &_stClock.u8Minutes, &_stClock.u8Seconds);
+
+    acTime[0] = (char)('0' + (_stClock.u8Hours   / 10));
+    acTime[1] = (char)('0' + (_stClock.u8Hours   % 10));
+    acTime[2] = (char)('0' + (_stClock.u8Minutes / 10));
+    acTime[3] = (char)('0' + (_stClock.u8Minutes % 10));
+    acTime[4] = '\0';
+
+    Font_DrawText(FONT_CLOCK, acTime, _stClock.au8Buffer, &_stTimeRegion, 1);
+
     #ifdef USE_BMP180
-    for (uint8_t u8Dig = 4; u8Dig < 6; u8Dig++)
     {
-        u8Offset = u8Digit[u8Dig];
+        uint8_t u8Temp = abs(_stClock.s8Temperature);
 
-        for (uint8_t u8Idx = 33 + u8Dig; u8Idx <= 51 + u8Dig; u8Idx += 4)
-        {
-            _stClock.au8Buffer[u8Idx] = _au8ClockFont[u8Offset];
-            u8Offset += 10;
-        }
+        acTime[0] = (char)('0' + ((u8Temp / 10) % 10));
+        acTime[1] = (char)('0' + (u8Temp % 10));
+        acTime[2] = '\0';
+
+        Font_DrawText(FONT_CLOCK, acTime, _stClock.au8Buffer, &_stTempRegion, 1);
     }
     #endif
 
@@ -150,6 +168,10 @@ void Clock_Update(void)
         _stClock.au8Buffer[44] |= 1 << 0;
         _stClock.au8Buffer[44] |= 1 << 1;
     }
+    else
+    {
+        _stClock.au8Buffer[44] &= ~((1 << 0) | (1 << 1));
+    }
     #endif
 }
 
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 uint8_t* Clock_GetBufferAddr(void);
+int      Clock_ShowText(const char* pacText);
 void     Clock_Update(void);
 
 #ifdef USE_BMP180
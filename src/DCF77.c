@@ -0,0 +1,487 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      DCF77.c
+ * @brief     DCF77 time signal decoder
+ * @details   The receiver output is sampled by TIM3 input capture on
+ *            PB4, so the CPU only runs on signal edges: two per second
+ *            plus noise.  Every second except the last one of a minute
+ *            starts with a pulse of 100 ms (0) or 200 ms (1).  The
+ *            missing pulse marks the start of the next minute.
+ *
+ *            Pulses are classified when the next one starts.  Their
+ *            width is the time the signal is high within
+ *            @ref DCF77_PULSE_MAX of the start, so drop-outs and spikes
+ *            only change it by their own length.  A spike ahead of a
+ *            pulse is dropped if a gap of at least @ref DCF77_GAP_MIN
+ *            follows, pulses shorter than @ref DCF77_PULSE_MIN are
+ *            ignored as spikes.  A frame is
+ *            accepted if the timing, the parity bits and the value
+ *            ranges are valid and it is exactly one minute after the
+ *            previous frame.  The RTC is then set by the update thread,
+ *            see @ref DCF77_Synchronise.
+ *
+ *            The decoder itself is plain C, so it can be tested on the
+ *            host with synthesised pulse trains (DCF77Sim.c).
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_DCF77
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "DCF77.h"
+
+#ifndef HOST_BUILD
+#include "FreeRTOS.h"
+#include "LifeCycle.h"
+#include "MCAL.h"
+#include "task.h"
+#endif
+
+#ifdef USE_RECORD
+#include "Record.h"
+#endif
+
+#define DCF77_NO_SYNC         0xFF     ///< Bit counter while waiting for a minute mark
+#define DCF77_SECOND          1000000U ///< Nominal pulse interval in µs
+#define DCF77_TOLERANCE       150000U  ///< Tolerance of the pulse interval in µs
+#define DCF77_PULSE_MIN       40000U   ///< Shorter pulses are spikes (µs)
+#define DCF77_PULSE_ONE       150000U  ///< Threshold between 0 and 1 (µs)
+#define DCF77_PULSE_MAX       300000U  ///< Pulse window, longer pulses are interference (µs)
+#define DCF77_GAP_MIN         50000U   ///< Min. gap after a spike ahead of a pulse (µs)
+#define DCF77_MAX_AGE         5000U    ///< Max. age of a frame when applied (ms)
+#define DCF77_SECONDS_PER_DAY 86400L   ///< Seconds per day
+
+static bool    _Check(const DCF77Decoder* pstDecoder, const DCF77Time* pstTime);
+static bool    _Classify(DCF77Decoder* pstDecoder, DCF77Time* pstTime);
+static bool    _Decode(uint64_t u64Bits, DCF77Time* pstTime);
+static uint8_t _GetBCD(uint64_t u64Bits, uint8_t u8First, uint8_t u8Width);
+
+#ifndef HOST_BUILD
+/**
+ * @struct DCF77Data
+ * @brief  DCF77 receiver data
+ */
+typedef struct
+{
+    DCF77Decoder  stDecoder; ///< Decoder state (capture interrupt only)
+    DCF77Time     stFrame;   ///< Frame to be applied
+    uint32_t      u32Tick;   ///< System tick when the frame was received
+    volatile bool bFrame;    ///< Frame is pending, owned by the update thread
+
+} DCF77Data;
+
+/**
+ * @var   _stDCF77
+ * @brief DCF77 receiver private data
+ */
+static DCF77Data _stDCF77;
+#endif
+
+/**
+ * @brief  Process signal edge
+ * @param  pstDecoder
+ *         Pointer to decoder state
+ * @param  bPulse
+ *         Signal level after the edge (true: pulse)
+ * @param  u32TimeInUs
+ *         Time stamp of the edge in µs (may wrap around)
+ * @param  pstTime
+ *         Pointer to time, set if a frame has been accepted
+ * @return A frame has been accepted
+ */
+bool DCF77_Edge(DCF77Decoder* pstDecoder, bool bPulse, uint32_t u32TimeInUs, DCF77Time* pstTime)
+{
+    bool bAccepted = false;
+
+    if (bPulse == pstDecoder->bPulse)
+    {
+        return false;
+    }
+    pstDecoder->bPulse = bPulse;
+
+    if (! bPulse)
+    {
+        pstDecoder->u32Width += u32TimeInUs - pstDecoder->u32Edge;
+        pstDecoder->u32End    = u32TimeInUs;
+        return false;
+    }
+
+    pstDecoder->u32Edge = u32TimeInUs;
+
+    if (pstDecoder->bPending)
+    {
+        if (DCF77_PULSE_MAX > (u32TimeInUs - pstDecoder->u32Start))
+        {
+            // Drop-out or spike within the pulse; a spike ahead of it is dropped
+            if ((DCF77_PULSE_MIN > pstDecoder->u32Width) && (DCF77_GAP_MIN <= (u32TimeInUs - pstDecoder->u32End)))
+            {
+                pstDecoder->u32Start = u32TimeInUs;
+                pstDecoder->u32Width = 0;
+            }
+            return false;
+        }
+
+        bAccepted = _Classify(pstDecoder, pstTime);
+    }
+
+    pstDecoder->u32Start = u32TimeInUs;
+    pstDecoder->u32Width = 0;
+    pstDecoder->bPending = true;
+
+    return bAccepted;
+}
+
+/**
+ * @brief Reset decoder state
+ * @param pstDecoder
+ *        Pointer to decoder state
+ */
+void DCF77_Reset(DCF77Decoder* pstDecoder)
+{
+    pstDecoder->u64Bits    = 0;
+    pstDecoder->u32Start   = 0;
+    pstDecoder->u32Edge    = 0;
+    pstDecoder->u32End     = 0;
+    pstDecoder->u32Width   = 0;
+    pstDecoder->u32Second  = 0;
+    pstDecoder->u8Bits     = DCF77_NO_SYNC;
+    pstDecoder->bPulse     = false;
+    pstDecoder->bPending   = false;
+    pstDecoder->bLastValid = false;
+}
+
+#ifndef HOST_BUILD
+/**
+ * @brief Input capture handler
+ * @note  Called from the TIM3 interrupt, which runs above the FreeRTOS
+ *        syscall priority; must not use the FreeRTOS API.
+ */
+void DCF77_Capture(void)
+{
+    DCF77Time stTime;
+    bool      bRising;
+    bool      bLevel;
+    uint32_t  u32Time = MCAL_GetCapture(&bRising);
+
+    if (DCF77_Edge(&_stDCF77.stDecoder, (bRising != DCF77_INVERTED), u32Time, &stTime))
+    {
+        if (! _stDCF77.bFrame)
+        {
+            _stDCF77.stFrame = stTime;
+            _stDCF77.u32Tick = MCAL_GetTick();
+            _stDCF77.bFrame  = true;
+        }
+    }
+
+    // The opposite edge of a spike may have passed already
+    bLevel = GPIO_IsSet(DCF77_GPIO_Port, DCF77_Pin);
+    if (bLevel != bRising)
+    {
+        DCF77_Edge(&_stDCF77.stDecoder, (bLevel != DCF77_INVERTED), MCAL_GetMicroseconds(), &stTime);
+    }
+}
+
+/**
+ * @brief Initialise DCF77 receiver
+ */
+void DCF77_Init(void)
+{
+    DCF77_Reset(&_stDCF77.stDecoder);
+    MCAL_StartCapture();
+}
+
+/**
+ * @brief   Set RTC to the last received frame
+ * @details The RTC is only written if it is off by at least a second;
+ *          the adjustment is passed on to the life cycle, so it does
+ *          not count as elapsed time.  Frames which have been received
+ *          before STOP mode are discarded, the microsecond clock does
+ *          not run there.
+ * @note    Call periodically from a task.
+ * @return  true: a valid frame has been taken, false: none
+ */
+bool DCF77_Synchronise(void)
+{
+    DCF77Time stTime;
+    bool      bFrame;
+    uint32_t  u32Tick;
+    uint32_t  u32Age;
+    uint32_t  u32New;
+    int32_t   s32Offset = 0;
+    uint8_t   u8Hours;
+    uint8_t   u8Minutes;
+    uint8_t   u8Seconds;
+
+    // The capture interrupt runs above the syscall priority
+    __disable_irq();
+    bFrame          = _stDCF77.bFrame;
+    stTime          = _stDCF77.stFrame;
+    u32Tick         = _stDCF77.u32Tick;
+    _stDCF77.bFrame = false;
+    __enable_irq();
+
+    if (! bFrame)
+    {
+        return false;
+    }
+
+    u32Age = MCAL_GetTick() - u32Tick;
+
+    if (DCF77_MAX_AGE < u32Age)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    u32New  = (stTime.u8Hour * 3600UL) + (stTime.u8Minute * 60UL);
+    u32New += (MCAL_GetMicroseconds() - stTime.u32Mark) / DCF77_SECOND;
+    u32New %= DCF77_SECONDS_PER_DAY;
+
+    if (0 == RTC_GetTime(&u8Hours, &u8Minutes, &u8Seconds))
+    {
+        s32Offset = (int32_t)u32New - (int32_t)((u8Hours * 3600UL) + (u8Minutes * 60UL) + u8Seconds);
+        if ((DCF77_SECONDS_PER_DAY / 2) < s32Offset)
+        {
+            s32Offset -= DCF77_SECONDS_PER_DAY;
+        }
+        else if (-(DCF77_SECONDS_PER_DAY / 2) >= s32Offset)
+        {
+            s32Offset += DCF77_SECONDS_PER_DAY;
+        }
+
+        if ((0 != s32Offset) && (0 == RTC_SetTime(u32New / 3600, (u32New / 60) % 60, u32New % 60)))
+        {
+            LifeCycle_AdjustClock(s32Offset);
+        }
+        else
+        {
+            s32Offset = 0;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    #ifdef USE_RECORD
+    if (0 != s32Offset)
+    {
+        Record_Log(RECORD_CLOCK, (uint32_t)s32Offset & 0x00FFFFFFUL);
+    }
+    #endif
+
+    return true;
+}
+#endif
+
+/**
+ * @brief  Check frame against the previous one
+ * @param  pstDecoder
+ *         Pointer to decoder state
+ * @param  pstTime
+ *         Pointer to decoded time
+ * @return Frame is exactly one minute after the previous one
+ */
+static bool _Check(const DCF77Decoder* pstDecoder, const DCF77Time* pstTime)
+{
+    const DCF77Time* pstLast     = &pstDecoder->stLast;
+    uint16_t         u16Expected = ((pstLast->u8Hour * 60U) + pstLast->u8Minute + 1U) % 1440U;
+    uint16_t         u16Now      = (pstTime->u8Hour * 60U) + pstTime->u8Minute;
+
+    if (! pstDecoder->bLastValid)
+    {
+        return false;
+    }
+
+    // The change between CET and CEST has to be announced by the
+    // previous frame and happens at 02:00 CET (to 03:00 CEST) or at
+    // 03:00 CEST (to 02:00 CET)
+    if (pstLast->bSummerTime != pstTime->bSummerTime)
+    {
+        if (! pstLast->bChange)
+        {
+            return false;
+        }
+
+        if (pstTime->bSummerTime && (120U == u16Expected))
+        {
+            u16Expected += 60U;
+        }
+        else if ((! pstTime->bSummerTime) && (180U == u16Expected))
+        {
+            u16Expected -= 60U;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (u16Expected != u16Now)
+    {
+        return false;
+    }
+
+    // Date changes at midnight only
+    if (0 != u16Now)
+    {
+        if ((pstLast->u8Day   != pstTime->u8Day)   ||
+            (pstLast->u8Month != pstTime->u8Month) ||
+            (pstLast->u8Year  != pstTime->u8Year))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief  Classify the pending pulse
+ * @param  pstDecoder
+ *         Pointer to decoder state
+ * @param  pstTime
+ *         Pointer to time, set if a frame has been accepted
+ * @return A frame has been accepted
+ */
+static bool _Classify(DCF77Decoder* pstDecoder, DCF77Time* pstTime)
+{
+    uint32_t u32Width    = pstDecoder->u32Width;
+    uint32_t u32Interval = pstDecoder->u32Start - pstDecoder->u32Second;
+    uint64_t u64Bit;
+    bool     bAccepted   = false;
+
+    if (DCF77_PULSE_MIN > u32Width)
+    {
+        // Spike
+        return false;
+    }
+
+    if (DCF77_PULSE_MAX < u32Width)
+    {
+        // Interference
+        pstDecoder->u8Bits = DCF77_NO_SYNC;
+        return false;
+    }
+
+    u64Bit                = (DCF77_PULSE_ONE <= u32Width) ? 1U : 0U;
+    pstDecoder->u32Second = pstDecoder->u32Start;
+
+    // Interval within +/- tolerance of one or two seconds
+    if ((2 * DCF77_TOLERANCE) >= (uint32_t)(u32Interval - (DCF77_SECOND - DCF77_TOLERANCE)))
+    {
+        // Next second
+        if ((DCF77_NO_SYNC != pstDecoder->u8Bits) && (60 > pstDecoder->u8Bits))
+        {
+            pstDecoder->u64Bits |= u64Bit << pstDecoder->u8Bits;
+            pstDecoder->u8Bits++;
+        }
+    }
+    else if ((2 * DCF77_TOLERANCE) >= (uint32_t)(u32Interval - ((2 * DCF77_SECOND) - DCF77_TOLERANCE)))
+    {
+        // Minute mark; second 59 (and the leap second) has no pulse
+        bool bLeap = (0 != ((pstDecoder->u64Bits >> 19) & 1U));
+
+        if ((59 == pstDecoder->u8Bits) || ((60 == pstDecoder->u8Bits) && bLeap))
+        {
+            if (_Decode(pstDecoder->u64Bits, pstTime))
+            {
+                pstTime->u32Mark       = pstDecoder->u32Start;
+                bAccepted              = _Check(pstDecoder, pstTime);
+                pstDecoder->stLast     = *pstTime;
+                pstDecoder->bLastValid = true;
+            }
+            else
+            {
+                pstDecoder->bLastValid = false;
+            }
+        }
+        else
+        {
+            pstDecoder->bLastValid = false;
+        }
+
+        pstDecoder->u64Bits = u64Bit;
+        pstDecoder->u8Bits  = 1;
+    }
+    else
+    {
+        pstDecoder->u8Bits = DCF77_NO_SYNC;
+    }
+
+    return bAccepted;
+}
+
+/**
+ * @brief  Decode frame and check parity and value ranges
+ * @param  u64Bits
+ *         Bits 0 to 58 of the frame
+ * @param  pstTime
+ *         Pointer to decoded time
+ * @return Frame is valid
+ */
+static bool _Decode(uint64_t u64Bits, DCF77Time* pstTime)
+{
+    // Start of minute (0), start of time (1), exactly one of CEST/CET
+    if ((0 != (u64Bits & 1U)) || (0 == ((u64Bits >> 20) & 1U)))
+    {
+        return false;
+    }
+
+    if (((u64Bits >> 17) & 1U) == ((u64Bits >> 18) & 1U))
+    {
+        return false;
+    }
+
+    // Even parity over minute, hour and date including the parity bit
+    if (__builtin_parityll(u64Bits & (0xFFULL << 21)) ||
+        __builtin_parityll(u64Bits & (0x7FULL << 29)) ||
+        __builtin_parityll(u64Bits & (0x7FFFFFULL << 36)))
+    {
+        return false;
+    }
+
+    pstTime->u8Minute    = _GetBCD(u64Bits, 21, 7);
+    pstTime->u8Hour      = _GetBCD(u64Bits, 29, 6);
+    pstTime->u8Day       = _GetBCD(u64Bits, 36, 6);
+    pstTime->u8Weekday   = _GetBCD(u64Bits, 42, 3);
+    pstTime->u8Month     = _GetBCD(u64Bits, 45, 5);
+    pstTime->u8Year      = _GetBCD(u64Bits, 50, 8);
+    pstTime->bSummerTime = (0 != ((u64Bits >> 17) & 1U));
+    pstTime->bChange     = (0 != ((u64Bits >> 16) & 1U));
+
+    if ((59 < pstTime->u8Minute) ||
+        (23 < pstTime->u8Hour) ||
+        (1 > pstTime->u8Day) || (31 < pstTime->u8Day) ||
+        (1 > pstTime->u8Weekday) || (7 < pstTime->u8Weekday) ||
+        (1 > pstTime->u8Month) || (12 < pstTime->u8Month) ||
+        (99 < pstTime->u8Year))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief  Get BCD value
+ * @param  u64Bits
+ *         Frame
+ * @param  u8First
+ *         First bit (LSB)
+ * @param  u8Width
+ *         Number of bits
+ * @return Value, 0xFF if a digit is invalid
+ */
+static uint8_t _GetBCD(uint64_t u64Bits, uint8_t u8First, uint8_t u8Width)
+{
+    uint8_t u8Raw = (uint8_t)((u64Bits >> u8First) & ((1U << u8Width) - 1U));
+
+    if (9 < (u8Raw & 0x0F))
+    {
+        return 0xFF;
+    }
+
+    return (uint8_t)(((u8Raw >> 4) * 10U) + (u8Raw & 0x0F));
+}
+
+#endif // USE_DCF77
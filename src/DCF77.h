@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  DCF77.h
+ * @brief DCF77 time signal decoder
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "MCAL.h"
+
+#ifndef DCF77_Pin
+    #define DCF77_Pin       GPIO_PIN_4  ///< DCF77 receiver pin (TIM3_CH1, partial remap)
+#endif
+#ifndef DCF77_GPIO_Port
+    #define DCF77_GPIO_Port GPIO_PORT_B ///< DCF77 receiver GPIO port
+#endif
+#ifndef DCF77_INVERTED
+    #define DCF77_INVERTED  false       ///< Receiver output is low during a pulse
+#endif
+
+/**
+ * @struct DCF77Time
+ * @brief  Decoded time (local time, CET or CEST)
+ */
+typedef struct
+{
+    uint32_t u32Mark;     ///< Start of the minute in µs (time stamp of the edge)
+    uint8_t  u8Minute;    ///< Minute (0 to 59)
+    uint8_t  u8Hour;      ///< Hour (0 to 23)
+    uint8_t  u8Day;       ///< Day of month (1 to 31)
+    uint8_t  u8Weekday;   ///< Day of week (1: Monday to 7: Sunday)
+    uint8_t  u8Month;     ///< Month (1 to 12)
+    uint8_t  u8Year;      ///< Year of century (0 to 99)
+    bool     bSummerTime; ///< Central European Summer Time (CEST)
+    bool     bChange;     ///< Change between CET and CEST announced (bit 16)
+
+} DCF77Time;
+
+/**
+ * @struct DCF77Decoder
+ * @brief  Decoder state
+ */
+typedef struct
+{
+    uint64_t  u64Bits;    ///< Bits received in the current minute
+    DCF77Time stLast;     ///< Last frame which passed the checks
+    uint32_t  u32Start;   ///< Start of the pending pulse in µs
+    uint32_t  u32Edge;    ///< Last rising edge in µs
+    uint32_t  u32End;     ///< Last falling edge in µs
+    uint32_t  u32Width;   ///< Time the pending pulse has been high in µs
+    uint32_t  u32Second;  ///< Start of the last second pulse in µs
+    uint8_t   u8Bits;     ///< Number of bits received, DCF77_NO_SYNC: wait for minute mark
+    bool      bPulse;     ///< Signal level (pulse active)
+    bool      bPending;   ///< A pulse is pending classification
+    bool      bLastValid; ///< stLast is valid
+
+} DCF77Decoder;
+
+bool DCF77_Edge(DCF77Decoder* pstDecoder, bool bPulse, uint32_t u32TimeInUs, DCF77Time* pstTime);
+void DCF77_Reset(DCF77Decoder* pstDecoder);
+
+#ifndef HOST_BUILD
+#ifdef USE_DCF77
+void DCF77_Capture(void);
+void DCF77_Init(void);
+bool DCF77_Synchronise(void);
+#endif
+#endif
@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      DCF77Sim.c
+ * @brief     Host DCF77 decoder simulator
+ * @details   Synthesises the DCF77 pulse train of consecutive minutes,
+ *            disturbs it with spikes, drop-outs and timing jitter and
+ *            feeds its edges into the decoder.  Every accepted frame is
+ *            compared against the transmitted time.  Fails if a wrong
+ *            time has been accepted.  The change between CET and CEST
+ *            is transmitted on the last Sundays of March and October,
+ *            announced during the hour before.
+ *
+ *            The signal is generated at a resolution of 100 µs; the
+ *            time stamps wrap around like the microsecond clock on the
+ *            target.
+ * @code{.unparsed}
+ * Usage: program [-m minutes] [-g spikes/s] [-d drop-outs/s] [-j jitter in ms] [-s seed]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_DCF77SIM
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "DCF77.h"
+
+#define DCF77SIM_RESOLUTION 100                            ///< Sample period in µs
+#define DCF77SIM_SAMPLES    (60000000 / DCF77SIM_RESOLUTION) ///< Samples per minute
+#define DCF77SIM_SPIKE_MAX  200                            ///< Max. spike length in samples
+#define DCF77SIM_DROP_MAX   300                            ///< Max. drop-out length in samples
+
+/**
+ * @struct SimData
+ * @brief  Simulator data
+ */
+typedef struct
+{
+    uint8_t      au8Level[DCF77SIM_SAMPLES]; ///< Signal of the current minute
+    DCF77Decoder stDecoder;                  ///< Decoder under test
+    uint64_t     u64Rng;                     ///< PRNG state
+    uint64_t     u64Edges;                   ///< Number of edges fed
+    uint32_t     u32Accepted;                ///< Number of accepted frames
+    uint32_t     u32Wrong;                   ///< Number of wrong frames
+    uint32_t     u32FirstSync;               ///< Minute of the first accepted frame
+
+} SimData;
+
+/**
+ * @var   _stSim
+ * @brief Simulator private data
+ */
+static SimData _stSim;
+
+static uint64_t _Encode(const DCF77Time* pstTime);
+static void     _Next(DCF77Time* pstTime);
+static uint64_t _PutBCD(uint8_t u8Value, uint8_t u8First);
+static uint32_t _Random(uint64_t* pu64State);
+static void     _Synthesise(uint64_t u64Bits, double dSpikes, double dDrops, uint32_t u32Jitter);
+
+/**
+ * @brief  DCF77 simulator entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    DCF77Time stNow     = { 0, 55, 23, 28, 6, 2, 26, false, false };
+    DCF77Time stDecoded;
+    uint32_t  u32Minutes = 1440;
+    uint32_t  u32Jitter  = 0;
+    double    dSpikes    = 0.0;
+    double    dDrops     = 0.0;
+    uint64_t  u64Time    = 0;
+    bool      bLevel     = false;
+    int       nOpt;
+
+    _stSim.u64Rng       = 1;
+    _stSim.u32FirstSync = UINT32_MAX;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "m:g:d:j:s:")))
+    {
+        switch (nOpt)
+        {
+            case 'm':
+                u32Minutes = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'g':
+                dSpikes = strtod(optarg, NULL);
+                break;
+            case 'd':
+                dDrops = strtod(optarg, NULL);
+                break;
+            case 'j':
+                u32Jitter = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                _stSim.u64Rng = strtoull(optarg, NULL, 0) | 1;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-m minutes] [-g spikes/s] [-d drop-outs/s] [-j jitter in ms] [-s seed]\n", apcArgv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    DCF77_Reset(&_stSim.stDecoder);
+
+    for (uint32_t u32Minute = 0; u32Minute < u32Minutes; u32Minute++)
+    {
+        DCF77Time stNext = stNow;
+
+        // The frame sent during a minute holds the time of the next one
+        _Next(&stNext);
+        _Synthesise(_Encode(&stNext), dSpikes, dDrops, u32Jitter);
+
+        for (uint32_t u32Idx = 0; u32Idx < DCF77SIM_SAMPLES; u32Idx++)
+        {
+            uint32_t u32Stamp;
+
+            if (bLevel == (bool)_stSim.au8Level[u32Idx])
+            {
+                continue;
+            }
+
+            bLevel   = ! bLevel;
+            u32Stamp = (uint32_t)(u64Time + (u32Idx * DCF77SIM_RESOLUTION) + (_Random(&_stSim.u64Rng) % DCF77SIM_RESOLUTION));
+            _stSim.u64Edges++;
+
+            if (DCF77_Edge(&_stSim.stDecoder, bLevel, u32Stamp, &stDecoded))
+            {
+                uint32_t u32Mark = (uint32_t)u64Time;
+
+                _stSim.u32Accepted++;
+                if (UINT32_MAX == _stSim.u32FirstSync)
+                {
+                    _stSim.u32FirstSync = u32Minute;
+                }
+
+                // Classified one second late, in the current minute
+                stDecoded.u32Mark -= u32Mark;
+                if ((stNow.u8Minute  != stDecoded.u8Minute)  ||
+                    (stNow.u8Hour    != stDecoded.u8Hour)    ||
+                    (stNow.u8Day     != stDecoded.u8Day)     ||
+                    (stNow.u8Weekday != stDecoded.u8Weekday) ||
+                    (stNow.u8Month   != stDecoded.u8Month)   ||
+                    (stNow.u8Year    != stDecoded.u8Year)    ||
+                    ((200000U < stDecoded.u32Mark) && (UINT32_MAX - 200000U > stDecoded.u32Mark)))
+                {
+                    _stSim.u32Wrong++;
+                    printf("Minute %u: expected %02u:%02u %02u.%02u.%02u, got %02u:%02u %02u.%02u.%02u\n",
+                           u32Minute,
+                           stNow.u8Hour, stNow.u8Minute, stNow.u8Day, stNow.u8Month, stNow.u8Year,
+                           stDecoded.u8Hour, stDecoded.u8Minute, stDecoded.u8Day, stDecoded.u8Month, stDecoded.u8Year);
+                }
+            }
+        }
+
+        u64Time += 60000000ULL;
+        stNow    = stNext;
+    }
+
+    printf("%u minutes, %u frames accepted (%.1f%%), %u wrong, first after %u min, %.2f edges/s\n",
+           u32Minutes,
+           _stSim.u32Accepted,
+           (0 != u32Minutes) ? (100.0 * _stSim.u32Accepted / u32Minutes) : 0.0,
+           _stSim.u32Wrong,
+           (UINT32_MAX == _stSim.u32FirstSync) ? 0 : _stSim.u32FirstSync,
+           (0 != u32Minutes) ? ((double)_stSim.u64Edges / (u32Minutes * 60.0)) : 0.0);
+
+    return (0 == _stSim.u32Wrong) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief  Encode frame
+ * @param  pstTime
+ *         Pointer to time
+ * @return Bits 0 to 58 of the frame
+ */
+static uint64_t _Encode(const DCF77Time* pstTime)
+{
+    uint64_t u64Bits = 1ULL << 20;
+
+    u64Bits |= pstTime->bSummerTime ? (1ULL << 17) : (1ULL << 18);
+    u64Bits |= pstTime->bChange ? (1ULL << 16) : 0;
+    u64Bits |= _PutBCD(pstTime->u8Minute,  21);
+    u64Bits |= _PutBCD(pstTime->u8Hour,    29);
+    u64Bits |= _PutBCD(pstTime->u8Day,     36);
+    u64Bits |= _PutBCD(pstTime->u8Weekday, 42);
+    u64Bits |= _PutBCD(pstTime->u8Month,   45);
+    u64Bits |= _PutBCD(pstTime->u8Year,    50);
+
+    // Even parity
+    u64Bits |= (uint64_t)__builtin_parityll(u64Bits & (0x7FULL    << 21)) << 28;
+    u64Bits |= (uint64_t)__builtin_parityll(u64Bits & (0x3FULL    << 29)) << 35;
+    u64Bits |= (uint64_t)__builtin_parityll(u64Bits & (0x3FFFFFULL << 36)) << 58;
+
+    return u64Bits;
+}
+
+/**
+ * @brief Advance time by one minute
+ * @param pstTime
+ *        Pointer to time
+ */
+static void _Next(DCF77Time* pstTime)
+{
+    static const uint8_t au8Days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    uint8_t              u8Days      = au8Days[pstTime->u8Month - 1];
+
+    if ((2 == pstTime->u8Month) && (0 == (pstTime->u8Year % 4)))
+    {
+        u8Days++;
+    }
+
+    if (60 <= ++pstTime->u8Minute)
+    {
+        pstTime->u8Minute = 0;
+
+        if (pstTime->bChange)
+        {
+            // 02:00 CET is 03:00 CEST, 03:00 CEST is 02:00 CET
+            pstTime->u8Hour      = pstTime->bSummerTime ? 2 : 3;
+            pstTime->bSummerTime = ! pstTime->bSummerTime;
+        }
+        else if (24 <= ++pstTime->u8Hour)
+        {
+            pstTime->u8Hour    = 0;
+            pstTime->u8Weekday = (pstTime->u8Weekday % 7) + 1;
+
+            if (u8Days < ++pstTime->u8Day)
+            {
+                pstTime->u8Day = 1;
+
+                if (12 < ++pstTime->u8Month)
+                {
+                    pstTime->u8Month = 1;
+                    pstTime->u8Year  = (pstTime->u8Year + 1) % 100;
+                }
+            }
+        }
+    }
+
+    // Last Sunday of March 01:00 to 01:59 CET, last Sunday of October
+    // 02:00 to 02:59 CEST
+    pstTime->bChange = (7 == pstTime->u8Weekday) && (24 < pstTime->u8Day) &&
+                       (((3 == pstTime->u8Month) && (! pstTime->bSummerTime) && (1 == pstTime->u8Hour)) ||
+                        ((10 == pstTime->u8Month) && pstTime->bSummerTime && (2 == pstTime->u8Hour)));
+}
+
+/**
+ * @brief  Encode BCD value
+ * @param  u8Value
+ *         Value (0 to 99)
+ * @param  u8First
+ *         First bit (LSB)
+ * @return Bits
+ */
+static uint64_t _PutBCD(uint8_t u8Value, uint8_t u8First)
+{
+    return (uint64_t)(((u8Value / 10) << 4) | (u8Value % 10)) << u8First;
+}
+
+/**
+ * @brief  xorshift64* pseudo random number generator
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return Random number
+ */
+static uint32_t _Random(uint64_t* pu64State)
+{
+    *pu64State ^= *pu64State >> 12;
+    *pu64State ^= *pu64State << 25;
+    *pu64State ^= *pu64State >> 27;
+
+    return (uint32_t)((*pu64State * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief Synthesise signal of one minute
+ * @param u64Bits
+ *        Frame (bits 0 to 58)
+ * @param dSpikes
+ *        Mean number of spikes per second
+ * @param dDrops
+ *        Mean number of drop-outs per second
+ * @param u32Jitter
+ *        Max. jitter of the pulse edges in ms
+ */
+static void _Synthesise(uint64_t u64Bits, double dSpikes, double dDrops, uint32_t u32Jitter)
+{
+    uint32_t u32Spikes = (uint32_t)(dSpikes * 60.0);
+    uint32_t u32Drops  = (uint32_t)(dDrops * 60.0);
+    uint32_t u32Range  = (u32Jitter * 1000U) / DCF77SIM_RESOLUTION;
+
+    memset(_stSim.au8Level, 0, sizeof(_stSim.au8Level));
+
+    // Second 59 has no pulse
+    for (uint32_t u32Second = 0; u32Second < 59; u32Second++)
+    {
+        uint32_t u32Start = (u32Second * 10000U) + ((0 != u32Range) ? (_Random(&_stSim.u64Rng) % u32Range) : 0);
+        uint32_t u32Width = ((u64Bits >> u32Second) & 1U) ? 2000U : 1000U;
+
+        if (0 != u32Range)
+        {
+            u32Width += _Random(&_stSim.u64Rng) % u32Range;
+            u32Width -= u32Range / 2;
+        }
+
+        memset(&_stSim.au8Level[u32Start], 1, u32Width);
+    }
+
+    for (uint32_t u32Idx = 0; u32Idx < u32Spikes; u32Idx++)
+    {
+        uint32_t u32Length = 1 + (_Random(&_stSim.u64Rng) % DCF77SIM_SPIKE_MAX);
+        uint32_t u32Start  = _Random(&_stSim.u64Rng) % (DCF77SIM_SAMPLES - u32Length);
+
+        memset(&_stSim.au8Level[u32Start], 1, u32Length);
+    }
+
+    for (uint32_t u32Idx = 0; u32Idx < u32Drops; u32Idx++)
+    {
+        uint32_t u32Length = 1 + (_Random(&_stSim.u64Rng) % DCF77SIM_DROP_MAX);
+        uint32_t u32Start  = _Random(&_stSim.u64Rng) % (DCF77SIM_SAMPLES - u32Length);
+
+        memset(&_stSim.au8Level[u32Start], 0, u32Length);
+    }
+}
+
+#endif // USE_DCF77SIM
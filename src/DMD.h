@@ -6,6 +6,7 @@
  */
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "MCAL.h"
 
@@ -21,26 +22,217 @@
 #ifndef DMD_B_Pin
     #define DMD_B_Pin     GPIO_PIN_0  ///< DMD B pin
 #endif
+#ifndef DMD_C_Pin
+    #define DMD_C_Pin     GPIO_PIN_4  ///< DMD C pin, 1/8 and 1/16 scan only
+#endif
+#ifndef DMD_D_Pin
+    #define DMD_D_Pin     GPIO_PIN_9  ///< DMD D pin, 1/16 scan only
+#endif
 #ifndef DMD_GPIO_Port
-    #define DMD_GPIO_Port GPIO_PORT_A ///< DMD GPIO port
+    #define DMD_GPIO_Port GPIO_PORT_A ///< DMD GPIO port, shared by OE and all address lines
+#endif
+
+/*
+ * Experimental: USE_DMD_EXPERIMENTAL_UPSCALE doubles the 32x16 frame
+ * buffers for a 64x32 chain with a single data line.  No such panel has
+ * been verified, so there is no default geometry; DMD_SCANLINES and
+ * DMD_SCAN_ORDER have to be given for the panel.  P4/P5 panels of 64x32
+ * pixels are HUB75 (two RGB data line sets, upper and lower half, 1/16
+ * scan) and are not supported by this driver.
+ */
+#ifdef USE_DMD_EXPERIMENTAL_UPSCALE
+    #define DMD_UPSCALE    2 ///< Panel pixels per frame buffer pixel (64x32 chain)
+    #if !defined(DMD_SCANLINES) || !defined(DMD_SCAN_ORDER)
+        #error "USE_DMD_EXPERIMENTAL_UPSCALE requires DMD_SCANLINES and DMD_SCAN_ORDER of the panel"
+    #endif
+#else
+    #define DMD_UPSCALE    1 ///< Panel pixels per frame buffer pixel (32x16 panel)
+#endif
+
+#ifndef DMD_SCANLINES
+    #define DMD_SCANLINES 4 ///< Scan rate of the panel (1/n): 4, 8 or 16
+#endif
+
+#define DMD_WIDTH          32    ///< Display width in pixels, 8 pixels per byte (MSB left)
+#define DMD_HEIGHT         16    ///< Display height in pixels
+#define DMD_SCANLINE_US    1000U ///< Nominal time between DMD_Update() calls in µs
+#define DMD_PANEL_WIDTH    (DMD_WIDTH * DMD_UPSCALE)                             ///< Panel width in pixels
+#define DMD_PANEL_HEIGHT   (DMD_HEIGHT * DMD_UPSCALE)                            ///< Panel height in pixels
+#define DMD_ROW_BYTES      (DMD_PANEL_WIDTH / 8)                                 ///< Bytes per panel row
+#define DMD_SCAN_BYTES     ((DMD_PANEL_HEIGHT / DMD_SCANLINES) * DMD_ROW_BYTES) ///< Bytes shifted out per scanline
+#define DMD_BRIGHTNESS_MIN 8U    ///< Lowest brightness level
+#define DMD_BRIGHTNESS_MAX 255U  ///< Full brightness, rows are never blanked
+
+#ifndef DMD_SELFTEST_PERIOD
+    #define DMD_SELFTEST_PERIOD 1000U ///< Scanlines between two readback tests (USE_DMD_SELFTEST)
+#endif
+
+/*
+ * Scan geometry.  Scanline n lights rows n, n + DMD_SCANLINES, ...; it
+ * is selected by the binary value n on the address lines A (LSB) to D.
+ *
+ * DMD_SCAN_ORDER lists the panel buffer bytes in the order they are
+ * shifted out for one scanline, as offsets from the first byte of row
+ * n.  The defaults match the common P10 modules: per 8-pixel column,
+ * the rows lit by the scanline from bottom to top.  Modules wired
+ * differently can override it with an initialiser of DMD_SCAN_BYTES
+ * entries.
+ *
+ * With USE_DMD_EXPERIMENTAL_UPSCALE, the 32x16 frame buffers are shown
+ * doubled in both directions, see DMD_Update().
+ */
+#if (2 == DMD_UPSCALE)
+    #if (8 == DMD_SCANLINES)
+        #define DMD_ADDRESS_Pins (DMD_A_Pin | DMD_B_Pin | DMD_C_Pin) ///< Address lines in use
+    #elif (16 == DMD_SCANLINES)
+        #define DMD_ADDRESS_Pins (DMD_A_Pin | DMD_B_Pin | DMD_C_Pin | DMD_D_Pin) ///< Address lines in use
+    #else
+        #error "DMD_SCANLINES must be 8 or 16 on 64x32 panels"
+    #endif
+#elif (4 == DMD_SCANLINES)
+    #define DMD_ADDRESS_Pins (DMD_A_Pin | DMD_B_Pin) ///< Address lines in use
+    #ifndef DMD_SCAN_ORDER
+        #define DMD_SCAN_ORDER { \
+            48, 32, 16, 0,       \
+            49, 33, 17, 1,       \
+            50, 34, 18, 2,       \
+            51, 35, 19, 3 }
+    #endif
+#elif (8 == DMD_SCANLINES)
+    #define DMD_ADDRESS_Pins (DMD_A_Pin | DMD_B_Pin | DMD_C_Pin) ///< Address lines in use
+    #ifndef DMD_SCAN_ORDER
+        #define DMD_SCAN_ORDER { 32, 0, 33, 1, 34, 2, 35, 3 }
+    #endif
+#elif (16 == DMD_SCANLINES)
+    #define DMD_ADDRESS_Pins (DMD_A_Pin | DMD_B_Pin | DMD_C_Pin | DMD_D_Pin) ///< Address lines in use
+    #ifndef DMD_SCAN_ORDER
+        #define DMD_SCAN_ORDER { 0, 1, 2, 3 }
+    #endif
+#else
+    #error "DMD_SCANLINES must be 4, 8 or 16"
 #endif
 
 /**
- * @enum  DMDRows
- * @brief Dot Matrix Display rows
+ * @enum  DMDHealthState
+ * @brief Result of a panel readback test
  */
 typedef enum
 {
-    DMD_ROWS_1_5_9_13 = 0, ///< DMD rows 1, 5, 9 and 13
-    DMD_ROWS_2_6_10_14,    ///< DMD rows 2, 6, 10 and 14
-    DMD_ROWS_3_7_11_15,    ///< DMD rows 3, 7, 11 and 15
-    DMD_ROWS_4_8_12_16     ///< DMD rows 4, 8, 12 and 16
+    DMD_HEALTH_UNKNOWN = 0, ///< No test run yet
+    DMD_HEALTH_OK,          ///< Chain returned the shifted data
+    DMD_HEALTH_BIT_ERRORS,  ///< Chain returned corrupted data
+    DMD_HEALTH_NO_SIGNAL    ///< Chain output stuck low or high: dead panel or open chain
+
+} DMDHealthState;
+
+/**
+ * @struct DMDHealth
+ * @brief  Panel health counters
+ * @note   One record for the whole chain; the readback cannot tell
+ *         which panel is at fault.
+ */
+typedef struct
+{
+    uint32_t       u32Tests;     ///< Readback tests run
+    uint32_t       u32Failures;  ///< Tests with at least one wrong bit
+    uint32_t       u32BitErrors; ///< Wrong bits in total
+    uint32_t       u32NoSignal;  ///< Failed tests with a stuck chain output
+    uint16_t       u16Streak;    ///< Failed tests in a row, 0: last test passed
+    DMDHealthState eState;       ///< Result of the last test
+
+} DMDHealth;
 
-} DMDRows;
+/**
+ * @brief Frame buffer byte holding a pixel
+ */
+#define DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y) (&(pu8Buffer)[((u8Y) * (DMD_WIDTH / 8)) + ((u8X) >> 3)])
 
+/**
+ * @brief Bit number of a pixel within its byte (MSB left)
+ */
+#define DMD_PIXEL_BIT(u8X) (7U - ((u8X) & 7U))
+
+/**
+ * @brief  Get pixel
+ * @note   Coordinates are not checked.
+ * @param  pu8Buffer
+ *         Pointer to frame buffer (in SRAM)
+ * @param  u8X
+ *         Column (0 to @ref DMD_WIDTH - 1)
+ * @param  u8Y
+ *         Row (0 to @ref DMD_HEIGHT - 1)
+ * @return Pixel state
+ */
+static inline bool DMD_GetPixel(const uint8_t* pu8Buffer, uint8_t u8X, uint8_t u8Y)
+{
+#ifndef HOST_BUILD
+    return (0 != *SRAM_BITBAND(DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y), DMD_PIXEL_BIT(u8X)));
+#else
+    return (0 != (*DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y) & (1U << DMD_PIXEL_BIT(u8X))));
+#endif
+}
+
+/**
+ * @brief Set pixel
+ * @note  A single store to the bit-band alias; neighbouring pixels in
+ *        the same byte can be drawn concurrently, e.g. from an
+ *        interrupt, without a critical section.  Coordinates are not
+ *        checked.
+ * @param pu8Buffer
+ *        Pointer to frame buffer (in SRAM)
+ * @param u8X
+ *        Column (0 to @ref DMD_WIDTH - 1)
+ * @param u8Y
+ *        Row (0 to @ref DMD_HEIGHT - 1)
+ * @param bOn
+ *        Pixel state
+ */
+static inline void DMD_SetPixel(uint8_t* pu8Buffer, uint8_t u8X, uint8_t u8Y, bool bOn)
+{
+#ifndef HOST_BUILD
+    *SRAM_BITBAND(DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y), DMD_PIXEL_BIT(u8X)) = bOn;
+#else
+    if (bOn)
+    {
+        *DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y) |= (uint8_t)(1U << DMD_PIXEL_BIT(u8X));
+    }
+    else
+    {
+        *DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y) &= (uint8_t)~(1U << DMD_PIXEL_BIT(u8X));
+    }
+#endif
+}
+
+/**
+ * @brief Toggle pixel
+ * @note  Reads and writes the bit-band alias; the other pixels of the
+ *        byte are not touched, but two writers of the same pixel still
+ *        race.  Coordinates are not checked.
+ * @param pu8Buffer
+ *        Pointer to frame buffer (in SRAM)
+ * @param u8X
+ *        Column (0 to @ref DMD_WIDTH - 1)
+ * @param u8Y
+ *        Row (0 to @ref DMD_HEIGHT - 1)
+ */
+static inline void DMD_TogglePixel(uint8_t* pu8Buffer, uint8_t u8X, uint8_t u8Y)
+{
+#ifndef HOST_BUILD
+    volatile uint32_t* pu32Pixel = SRAM_BITBAND(DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y), DMD_PIXEL_BIT(u8X));
+
+    *pu32Pixel = *pu32Pixel ^ 1U;
+#else
+    *DMD_PIXEL_BYTE(pu8Buffer, u8X, u8Y) ^= (uint8_t)(1U << DMD_PIXEL_BIT(u8X));
+#endif
+}
+
+#ifdef USE_DMD_SELFTEST
+void DMD_GetHealth(DMDHealth* pstHealth);
+#endif
 void DMD_Latch(void);
-void DMD_LightRows(DMDRows eRows);
+void DMD_LightRows(uint8_t u8Scanline);
 void DMD_OE_RowsOff(void);
 void DMD_OE_RowsOn(void);
+void DMD_SetBrightness(uint8_t u8Level);
 void DMD_SetBuffer(uint8_t* pucBuffer);
 void DMD_Update(void);
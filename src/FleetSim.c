@@ -0,0 +1,556 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      FleetSim.c
+ * @brief     Host fleet simulator
+ * @details   Simulates a large number of virtual pets over their full
+ *            lifetimes using the real life cycle engine, in order to
+ *            balance care thresholds and evolution odds.  Pets are
+ *            distributed over all cores by a work-stealing pool: every
+ *            worker owns a range of pet indices, takes small chunks
+ *            from its front and steals half of another worker's
+ *            remaining range from the back once its own is exhausted.
+ *
+ *            Every pet uses its own PRNG seeded from the pet index, so
+ *            results do not depend on the number of threads.
+ * @code{.unparsed}
+ * Usage: program [-n pets] [-t threads] [-p policy] [-s seed]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_FLEETSIM
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "LifeCycle.h"
+
+#define FLEETSIM_MAX_THREADS  64  ///< Maximum number of worker threads
+#define FLEETSIM_MAX_DAYS     40  ///< Simulation limit and lifetime histogram size in days
+#define FLEETSIM_MAX_MISTAKES 32  ///< Care mistake histogram size
+#define FLEETSIM_CHUNK        256 ///< Number of pets a worker takes at once
+
+/**
+ * @struct CarePolicy
+ * @brief  Owner behaviour
+ */
+typedef struct
+{
+    const char* pacName;      ///< Policy name
+    uint32_t    u32Interval;  ///< Mean seconds between two checks
+    uint8_t     u8Response;   ///< Probability to care when checking, in percent
+    uint8_t     u8Scold;      ///< Probability to scold when checking, in percent
+    uint8_t     u8Wakeup;     ///< Hour the owner gets up
+    uint8_t     u8Bedtime;    ///< Hour the owner goes to bed
+
+} CarePolicy;
+
+/**
+ * @struct FleetResult
+ * @brief  Aggregated simulation results
+ */
+typedef struct
+{
+    uint64_t au64Reached[NUM_OF_EVOLUTIONS];        ///< Pets that reached an evolution
+    uint64_t au64Final[NUM_OF_EVOLUTIONS];          ///< Final evolution before death
+    uint64_t au64Lifetime[FLEETSIM_MAX_DAYS + 1];   ///< Lifetime in days, last bin: survived
+    uint64_t au64Mistakes[FLEETSIM_MAX_MISTAKES];   ///< Total care mistakes, last bin: more
+    uint64_t u64Pets;                               ///< Number of simulated pets
+
+} FleetResult;
+
+/**
+ * @struct FleetWorker
+ * @brief  Worker thread data
+ */
+typedef struct
+{
+    _Alignas(64) _Atomic uint64_t u64Range; ///< Remaining pet indices, begin (high) and end (low)
+    pthread_t                     hThread;  ///< Thread handle
+    uint32_t                      u32Index; ///< Worker index
+    FleetResult                   stResult; ///< Results of this worker
+
+} FleetWorker;
+
+/**
+ * @struct FleetSimData
+ * @brief  Fleet simulator data
+ */
+typedef struct
+{
+    FleetWorker       astWorker[FLEETSIM_MAX_THREADS]; ///< Workers
+    uint32_t          u32Threads;                      ///< Number of workers
+    uint64_t          u64Seed;                         ///< Base seed
+    const CarePolicy* pstPolicy;                       ///< Care policy
+
+} FleetSimData;
+
+/**
+ * @var   _stFleet
+ * @brief Fleet simulator private data
+ */
+static FleetSimData _stFleet = { 0 };
+
+/**
+ * @var   _astPolicy
+ * @brief Available care policies
+ */
+static const CarePolicy _astPolicy[] = {
+    { "perfect",     600, 100,  0, 7, 23 },
+    { "attentive",  1800,  95, 10, 7, 23 },
+    { "casual",     3600,  80, 20, 8, 22 },
+    { "busy",       7200,  60, 20, 7, 22 },
+    { "neglectful", 14400, 40, 50, 9, 21 }
+};
+
+/**
+ * @var   _apacEvolution
+ * @brief Evolution names, indexed by @ref Evolution
+ */
+static const char* _apacEvolution[NUM_OF_EVOLUTIONS] = {
+    "Egg", "Babytchi", "Marutchi", "Tamatchi", "Kuchitamatchi",
+    "Mametchi", "Ginjirotchi", "Maskutchi", "Kuchipatchi",
+    "Nyorotchi", "Tarakotchi", "Oyajitchi", "Obaketchi"
+};
+
+static uint64_t _PackRange(uint32_t u32Begin, uint32_t u32End);
+static uint32_t _Random(uint64_t* pu64State);
+static void     _Report(const FleetResult* pstResult, double dSeconds);
+static void     _SimulatePet(uint32_t u32Pet, FleetResult* pstResult);
+static bool     _Steal(FleetWorker* pstThief, uint32_t* pu32Begin, uint32_t* pu32End);
+static bool     _Take(FleetWorker* pstWorker, uint32_t* pu32Begin, uint32_t* pu32End);
+static void*    _WorkerThread(void* pArg);
+
+/**
+ * @brief  Fleet simulator entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    FleetResult     stTotal   = { 0 };
+    struct timespec stStart;
+    struct timespec stEnd;
+    uint32_t        u32Pets   = 1000000;
+    long            lCores    = sysconf(_SC_NPROCESSORS_ONLN);
+    int             nOpt;
+
+    _stFleet.u32Threads = (0 < lCores) ? (uint32_t)lCores : 1;
+    _stFleet.u64Seed    = 0x54616D61676F0000ULL;
+    _stFleet.pstPolicy  = &_astPolicy[2];
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "n:t:p:s:")))
+    {
+        switch (nOpt)
+        {
+            case 'n':
+                u32Pets = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                _stFleet.u32Threads = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                _stFleet.u64Seed = strtoull(optarg, NULL, 0);
+                break;
+            case 'p':
+                _stFleet.pstPolicy = NULL;
+                for (size_t uIdx = 0; uIdx < sizeof(_astPolicy) / sizeof(_astPolicy[0]); uIdx++)
+                {
+                    if (0 == strcmp(optarg, _astPolicy[uIdx].pacName))
+                    {
+                        _stFleet.pstPolicy = &_astPolicy[uIdx];
+                    }
+                }
+                if (NULL == _stFleet.pstPolicy)
+                {
+                    fprintf(stderr, "Unknown policy: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n pets] [-t threads] [-p policy] [-s seed]\n", apcArgv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if ((0 == _stFleet.u32Threads) || (FLEETSIM_MAX_THREADS < _stFleet.u32Threads))
+    {
+        _stFleet.u32Threads = FLEETSIM_MAX_THREADS;
+    }
+
+    // Distribute pets evenly; stealing balances the rest
+    for (uint32_t u32Idx = 0; u32Idx < _stFleet.u32Threads; u32Idx++)
+    {
+        uint32_t u32Begin = (uint32_t)(((uint64_t)u32Pets *  u32Idx)      / _stFleet.u32Threads);
+        uint32_t u32End   = (uint32_t)(((uint64_t)u32Pets * (u32Idx + 1)) / _stFleet.u32Threads);
+
+        _stFleet.astWorker[u32Idx].u32Index = u32Idx;
+        atomic_init(&_stFleet.astWorker[u32Idx].u64Range, _PackRange(u32Begin, u32End));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stStart);
+
+    for (uint32_t u32Idx = 0; u32Idx < _stFleet.u32Threads; u32Idx++)
+    {
+        if (0 != pthread_create(&_stFleet.astWorker[u32Idx].hThread, NULL, _WorkerThread, &_stFleet.astWorker[u32Idx]))
+        {
+            fprintf(stderr, "Could not create worker thread.\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (uint32_t u32Idx = 0; u32Idx < _stFleet.u32Threads; u32Idx++)
+    {
+        const FleetResult* pstResult = &_stFleet.astWorker[u32Idx].stResult;
+
+        pthread_join(_stFleet.astWorker[u32Idx].hThread, NULL);
+
+        for (int nIdx = 0; nIdx < NUM_OF_EVOLUTIONS; nIdx++)
+        {
+            stTotal.au64Reached[nIdx] += pstResult->au64Reached[nIdx];
+            stTotal.au64Final[nIdx]   += pstResult->au64Final[nIdx];
+        }
+        for (int nIdx = 0; nIdx <= FLEETSIM_MAX_DAYS; nIdx++)
+        {
+            stTotal.au64Lifetime[nIdx] += pstResult->au64Lifetime[nIdx];
+        }
+        for (int nIdx = 0; nIdx < FLEETSIM_MAX_MISTAKES; nIdx++)
+        {
+            stTotal.au64Mistakes[nIdx] += pstResult->au64Mistakes[nIdx];
+        }
+        stTotal.u64Pets += pstResult->u64Pets;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stEnd);
+
+    _Report(&stTotal,
+            (double)(stEnd.tv_sec - stStart.tv_sec) + ((double)(stEnd.tv_nsec - stStart.tv_nsec) / 1e9));
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief  Pack a range of pet indices into one atomic word
+ * @param  u32Begin
+ *         First pet index
+ * @param  u32End
+ *         Pet index past the last one
+ * @return Packed range
+ */
+static uint64_t _PackRange(uint32_t u32Begin, uint32_t u32End)
+{
+    return ((uint64_t)u32Begin << 32) | u32End;
+}
+
+/**
+ * @brief  xorshift64* pseudo random number generator
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return Random number
+ */
+static uint32_t _Random(uint64_t* pu64State)
+{
+    *pu64State ^= *pu64State >> 12;
+    *pu64State ^= *pu64State << 25;
+    *pu64State ^= *pu64State >> 27;
+
+    return (uint32_t)((*pu64State * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief Print simulation results
+ * @param pstResult
+ *        Pointer to results
+ * @param dSeconds
+ *        Wall-clock time in seconds
+ */
+static void _Report(const FleetResult* pstResult, double dSeconds)
+{
+    uint64_t u64Max = 1;
+    double   dPets  = (0 != pstResult->u64Pets) ? (double)pstResult->u64Pets : 1.0;
+
+    printf("Policy: %s, %llu pets, %u threads\n\n",
+           _stFleet.pstPolicy->pacName,
+           (unsigned long long)pstResult->u64Pets,
+           _stFleet.u32Threads);
+
+    printf("%-14s %10s %8s %10s %8s\n", "Evolution", "Reached", "%", "Final", "%");
+    for (int nIdx = 0; nIdx < NUM_OF_EVOLUTIONS; nIdx++)
+    {
+        printf("%-14s %10llu %7.2f%% %10llu %7.2f%%\n",
+               _apacEvolution[nIdx],
+               (unsigned long long)pstResult->au64Reached[nIdx],
+               100.0 * (double)pstResult->au64Reached[nIdx] / dPets,
+               (unsigned long long)pstResult->au64Final[nIdx],
+               100.0 * (double)pstResult->au64Final[nIdx] / dPets);
+    }
+
+    for (int nIdx = 0; nIdx <= FLEETSIM_MAX_DAYS; nIdx++)
+    {
+        if (pstResult->au64Lifetime[nIdx] > u64Max)
+        {
+            u64Max = pstResult->au64Lifetime[nIdx];
+        }
+    }
+
+    printf("\nLifetime (days)\n");
+    for (int nIdx = 0; nIdx <= FLEETSIM_MAX_DAYS; nIdx++)
+    {
+        int nBar = (int)((50 * pstResult->au64Lifetime[nIdx]) / u64Max);
+
+        if (0 == pstResult->au64Lifetime[nIdx])
+        {
+            continue;
+        }
+
+        if (FLEETSIM_MAX_DAYS == nIdx)
+        {
+            printf("  >=%2d", nIdx);
+        }
+        else
+        {
+            printf("    %2d", nIdx);
+        }
+        printf(" %10llu %.*s\n",
+               (unsigned long long)pstResult->au64Lifetime[nIdx],
+               nBar,
+               "##################################################");
+    }
+
+    printf("\nCare mistakes\n");
+    for (int nIdx = 0; nIdx < FLEETSIM_MAX_MISTAKES; nIdx++)
+    {
+        if (0 != pstResult->au64Mistakes[nIdx])
+        {
+            printf("  %s%2d %10llu\n",
+                   (FLEETSIM_MAX_MISTAKES - 1 == nIdx) ? ">=" : "  ",
+                   nIdx,
+                   (unsigned long long)pstResult->au64Mistakes[nIdx]);
+        }
+    }
+
+    printf("\n%.3f s, %.0f pets/s\n", dSeconds, (double)pstResult->u64Pets / dSeconds);
+}
+
+/**
+ * @brief Simulate a pet's whole life under the selected care policy
+ * @param u32Pet
+ *        Pet index
+ * @param pstResult
+ *        Pointer to results to update
+ */
+static void _SimulatePet(uint32_t u32Pet, FleetResult* pstResult)
+{
+    const CarePolicy* pstPolicy  = _stFleet.pstPolicy;
+    uint64_t          u64Rng     = (_stFleet.u64Seed ^ ((uint64_t)u32Pet * 0x9E3779B97F4A7C15ULL)) | 1;
+    uint32_t          u32Limit   = FLEETSIM_MAX_DAYS * 86400UL;
+    uint16_t          u16Reached = 0;
+    Evolution         eFinal     = EGG;
+    Stats             stPet;
+
+    LifeCycle_Reset(&stPet, _Random(&u64Rng) % 86400UL);
+    u16Reached |= 1 << EGG;
+
+    while ((OBAKETCHI != stPet.eEvolution) && (u32Limit > stPet.u32Age))
+    {
+        // Time until the owner's next check, uniformly around the mean
+        uint32_t u32Wait = 1 + (_Random(&u64Rng) % (2 * pstPolicy->u32Interval));
+        uint8_t  u8Hour;
+
+        LifeCycle_Advance(&stPet, u32Wait);
+
+        if (OBAKETCHI != stPet.eEvolution)
+        {
+            eFinal = stPet.eEvolution;
+        }
+        u16Reached |= 1 << stPet.eEvolution;
+
+        u8Hour = (uint8_t)(stPet.u32TimeOfDay / 3600U);
+        if ((u8Hour < pstPolicy->u8Wakeup) || (u8Hour >= pstPolicy->u8Bedtime))
+        {
+            continue;
+        }
+
+        if ((_Random(&u64Rng) % 100) >= pstPolicy->u8Response)
+        {
+            continue;
+        }
+
+        while (LIFECYCLE_METER_FULL > stPet.u32Hunger)
+        {
+            uint32_t u32Before = stPet.u32Hunger;
+            LifeCycle_Feed(&stPet);
+            if (u32Before == stPet.u32Hunger)
+            {
+                break;
+            }
+        }
+
+        while (LIFECYCLE_METER_FULL > stPet.u32Happiness)
+        {
+            uint32_t u32Before = stPet.u32Happiness;
+            LifeCycle_Play(&stPet);
+            if (u32Before == stPet.u32Happiness)
+            {
+                break;
+            }
+        }
+
+        LifeCycle_Clean(&stPet);
+        LifeCycle_Heal(&stPet);
+
+        if ((_Random(&u64Rng) % 100) < pstPolicy->u8Scold)
+        {
+            LifeCycle_Scold(&stPet);
+        }
+    }
+
+    // Babytchi may be shorter than the check interval, but every child
+    // has been one
+    if (u16Reached & ~((1 << EGG) | (1 << BABYTCHI) | (1 << OBAKETCHI)))
+    {
+        u16Reached |= 1 << BABYTCHI;
+    }
+
+    for (int nIdx = 0; nIdx < NUM_OF_EVOLUTIONS; nIdx++)
+    {
+        if ((u16Reached >> nIdx) & 1)
+        {
+            pstResult->au64Reached[nIdx]++;
+        }
+    }
+
+    pstResult->au64Final[eFinal]++;
+    pstResult->au64Lifetime[(OBAKETCHI == stPet.eEvolution) ? (stPet.u32Age / 86400UL) : FLEETSIM_MAX_DAYS]++;
+    pstResult->au64Mistakes[(FLEETSIM_MAX_MISTAKES > stPet.u16CareMistages) ? stPet.u16CareMistages : (FLEETSIM_MAX_MISTAKES - 1)]++;
+    pstResult->u64Pets++;
+}
+
+/**
+ * @brief  Steal half of the remaining pets of another worker
+ * @param  pstThief
+ *         Pointer to the stealing worker
+ * @param  pu32Begin
+ *         Pointer to first stolen pet index
+ * @param  pu32End
+ *         Pointer to pet index past the last stolen one
+ * @return Result
+ * @retval true: Pets stolen
+ * @retval false: All workers are empty
+ */
+static bool _Steal(FleetWorker* pstThief, uint32_t* pu32Begin, uint32_t* pu32End)
+{
+    for (uint32_t u32Offset = 1; u32Offset < _stFleet.u32Threads; u32Offset++)
+    {
+        FleetWorker* pstVictim = &_stFleet.astWorker[(pstThief->u32Index + u32Offset) % _stFleet.u32Threads];
+        uint64_t     u64Range  = atomic_load(&pstVictim->u64Range);
+
+        while (1)
+        {
+            uint32_t u32Begin = (uint32_t)(u64Range >> 32);
+            uint32_t u32End   = (uint32_t)u64Range;
+            uint32_t u32Split;
+
+            if (u32Begin >= u32End)
+            {
+                break;
+            }
+
+            u32Split = u32End - ((u32End - u32Begin + 1) / 2);
+
+            if (atomic_compare_exchange_weak(&pstVictim->u64Range, &u64Range, _PackRange(u32Begin, u32Split)))
+            {
+                *pu32Begin = u32Split;
+                *pu32End   = u32End;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief  Take a chunk of pets from the front of a worker's own range
+ * @param  pstWorker
+ *         Pointer to worker
+ * @param  pu32Begin
+ *         Pointer to first pet index
+ * @param  pu32End
+ *         Pointer to pet index past the last one
+ * @return Result
+ * @retval true: Chunk taken
+ * @retval false: Range is empty
+ */
+static bool _Take(FleetWorker* pstWorker, uint32_t* pu32Begin, uint32_t* pu32End)
+{
+    uint64_t u64Range = atomic_load(&pstWorker->u64Range);
+
+    while (1)
+    {
+        uint32_t u32Begin = (uint32_t)(u64Range >> 32);
+        uint32_t u32End   = (uint32_t)u64Range;
+        uint32_t u32Take;
+
+        if (u32Begin >= u32End)
+        {
+            return false;
+        }
+
+        u32Take = u32End - u32Begin;
+        if (FLEETSIM_CHUNK < u32Take)
+        {
+            u32Take = FLEETSIM_CHUNK;
+        }
+
+        if (atomic_compare_exchange_weak(&pstWorker->u64Range, &u64Range, _PackRange(u32Begin + u32Take, u32End)))
+        {
+            *pu32Begin = u32Begin;
+            *pu32End   = u32Begin + u32Take;
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief  Worker thread
+ * @param  pArg
+ *         Pointer to worker data
+ * @return Unused
+ */
+static void* _WorkerThread(void* pArg)
+{
+    FleetWorker* pstWorker = (FleetWorker*)pArg;
+    uint32_t     u32Begin;
+    uint32_t     u32End;
+
+    while (1)
+    {
+        if (! _Take(pstWorker, &u32Begin, &u32End))
+        {
+            if (! _Steal(pstWorker, &u32Begin, &u32End))
+            {
+                break;
+            }
+
+            // Keep the loot stealable by others
+            atomic_store(&pstWorker->u64Range, _PackRange(u32Begin, u32End));
+            continue;
+        }
+
+        for (uint32_t u32Pet = u32Begin; u32Pet < u32End; u32Pet++)
+        {
+            _SimulatePet(u32Pet, &pstWorker->stResult);
+        }
+    }
+
+    return NULL;
+}
+
+#endif // USE_FLEETSIM
@@ -0,0 +1,435 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Font.c
+ * @brief     Bitmap font renderer
+ * @details   Glyphs are stored column by column (bit 0 is the top row)
+ *            with their own width; pairs of glyphs which fit into each
+ *            other are moved closer by a kerning table.  Text is
+ *            rendered into rows of 32-bit words, which are written to a
+ *            region of the frame buffer with a mask, so the pixels
+ *            around the region stay untouched.
+ *
+ *            A marquee renders its text once into a strip of words per
+ *            row.  Each scroll step extracts one word per row at the
+ *            current bit offset; nothing is rendered again.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "DMD.h"
+#include "Font.h"
+
+#if 32 != DMD_WIDTH
+#error "Font renderer expects one 32-bit word per frame buffer row"
+#endif
+
+#define FONT_ROW_BYTES (DMD_WIDTH / 8) ///< Frame buffer bytes per row
+
+/**
+ * @struct FontGlyph
+ * @brief  Glyph
+ */
+typedef struct
+{
+    uint16_t u16Offset; ///< Offset of the first column
+    uint8_t  u8Width;   ///< Width in pixels
+
+} FontGlyph;
+
+/**
+ * @struct FontKerning
+ * @brief  Kerning pair
+ */
+typedef struct
+{
+    char   cLeft;    ///< Left glyph
+    char   cRight;   ///< Right glyph
+    int8_t s8Adjust; ///< Added to the spacing in pixels
+
+} FontKerning;
+
+/**
+ * @struct Font
+ * @brief  Font
+ */
+typedef struct
+{
+    const uint8_t*     pu8Columns;  ///< Glyph columns, bit 0 is the top row
+    const FontGlyph*   pastGlyph;   ///< Glyphs from cFirst to cLast
+    const FontKerning* pastKerning; ///< Kerning pairs
+    uint8_t            u8Kernings;  ///< Number of kerning pairs
+    char               cFirst;      ///< First character
+    char               cLast;       ///< Last character
+    char               cDefault;    ///< Substitute for missing characters, 0: skip
+    uint8_t            u8Height;    ///< Height in pixels
+    uint8_t            u8Spacing;   ///< Space between glyphs in pixels
+    bool               bUpperCase;  ///< Lower case letters are drawn as upper case
+
+} Font;
+
+/**
+ * @var   _au8SmallColumns
+ * @brief Small font glyph columns
+ */
+static const uint8_t _au8SmallColumns[190] = {
+    0x00, 0x00, 0x17, 0x03, 0x00, 0x03, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x12,
+    0x1F, 0x09, 0x19, 0x04, 0x13, 0x0A, 0x15, 0x0A, 0x10, 0x03, 0x0E, 0x11,
+    0x11, 0x0E, 0x05, 0x02, 0x05, 0x04, 0x0E, 0x04, 0x10, 0x08, 0x04, 0x04,
+    0x04, 0x10, 0x18, 0x04, 0x03, 0x1F, 0x11, 0x1F, 0x02, 0x1F, 0x1D, 0x15,
+    0x17, 0x11, 0x15, 0x1F, 0x07, 0x04, 0x1F, 0x17, 0x15, 0x1D, 0x1F, 0x15,
+    0x1D, 0x01, 0x01, 0x1F, 0x1F, 0x15, 0x1F, 0x17, 0x15, 0x1F, 0x0A, 0x10,
+    0x0A, 0x04, 0x0A, 0x11, 0x0A, 0x0A, 0x0A, 0x11, 0x0A, 0x04, 0x01, 0x15,
+    0x07, 0x0E, 0x11, 0x15, 0x06, 0x1E, 0x05, 0x1E, 0x1F, 0x15, 0x0A, 0x0E,
+    0x11, 0x11, 0x1F, 0x11, 0x0E, 0x1F, 0x15, 0x11, 0x1F, 0x05, 0x01, 0x0E,
+    0x11, 0x1D, 0x1F, 0x04, 0x1F, 0x11, 0x1F, 0x11, 0x08, 0x10, 0x0F, 0x1F,
+    0x04, 0x1B, 0x1F, 0x10, 0x10, 0x1F, 0x02, 0x04, 0x02, 0x1F, 0x1F, 0x02,
+    0x04, 0x1F, 0x0E, 0x11, 0x11, 0x0E, 0x1F, 0x05, 0x02, 0x0E, 0x11, 0x09,
+    0x16, 0x1F, 0x05, 0x1A, 0x12, 0x15, 0x09, 0x01, 0x1F, 0x01, 0x1F, 0x10,
+    0x1F, 0x0F, 0x10, 0x0F, 0x1F, 0x08, 0x04, 0x08, 0x1F, 0x1B, 0x04, 0x1B,
+    0x03, 0x1C, 0x03, 0x19, 0x15, 0x13, 0x1F, 0x11, 0x03, 0x04, 0x18, 0x11,
+    0x1F, 0x02, 0x01, 0x02, 0x10, 0x10, 0x10, 0x02, 0x05, 0x02
+};
+
+/**
+ * @var   _astSmallGlyph
+ * @brief Small font glyphs (' ' to '`')
+ */
+static const FontGlyph _astSmallGlyph[65] = {
+    {   0, 2 }, {   2, 1 }, {   3, 3 }, {   6, 5 }, {  11, 3 }, {  14, 3 }, {  17, 4 }, {  21, 1 }, // ' ' to '''
+    {  22, 2 }, {  24, 2 }, {  26, 3 }, {  29, 3 }, {  32, 2 }, {  34, 3 }, {  37, 1 }, {  38, 3 }, // '(' to '/'
+    {  41, 3 }, {  44, 2 }, {  46, 3 }, {  49, 3 }, {  52, 3 }, {  55, 3 }, {  58, 3 }, {  61, 3 }, // '0' to '7'
+    {  64, 3 }, {  67, 3 }, {  70, 1 }, {  71, 2 }, {  73, 3 }, {  76, 3 }, {  79, 3 }, {  82, 3 }, // '8' to '?'
+    {  85, 4 }, {  89, 3 }, {  92, 3 }, {  95, 3 }, {  98, 3 }, { 101, 3 }, { 104, 3 }, { 107, 3 }, // '@' to 'G'
+    { 110, 3 }, { 113, 3 }, { 116, 3 }, { 119, 3 }, { 122, 3 }, { 125, 5 }, { 130, 4 }, { 134, 4 }, // 'H' to 'O'
+    { 138, 3 }, { 141, 4 }, { 145, 3 }, { 148, 3 }, { 151, 3 }, { 154, 3 }, { 157, 3 }, { 160, 5 }, // 'P' to 'W'
+    { 165, 3 }, { 168, 3 }, { 171, 3 }, { 174, 2 }, { 176, 3 }, { 179, 2 }, { 181, 3 }, { 184, 3 }, // 'X' to '_'
+    { 187, 3 }                                                                                      // '`' (degree)
+};
+
+/**
+ * @var   _astSmallKerning
+ * @brief Small font kerning pairs
+ */
+static const FontKerning _astSmallKerning[] = {
+    { 'F', ',', -1 }, { 'F', '.', -1 }, { 'L', 'T', -1 }, { 'L', 'V', -1 },
+    { 'L', 'Y', -1 }, { 'P', ',', -1 }, { 'P', '.', -1 }, { 'T', ',', -1 },
+    { 'T', '.', -1 }, { 'T', 'A', -1 }, { 'T', 'J', -1 }, { 'Y', '.', -1 }
+};
+
+/**
+ * @var   _au8ClockColumns
+ * @brief Clock font glyph columns
+ */
+static const uint8_t _au8ClockColumns[50] = {
+    0x1F, 0x19, 0x15, 0x13, 0x1F, 0x00, 0x00, 0x12, 0x1F, 0x10,
+    0x19, 0x15, 0x15, 0x15, 0x12, 0x15, 0x15, 0x15, 0x15, 0x1B,
+    0x0F, 0x08, 0x1C, 0x08, 0x08, 0x17, 0x15, 0x15, 0x15, 0x09,
+    0x1F, 0x15, 0x15, 0x15, 0x1D, 0x01, 0x01, 0x19, 0x05, 0x03,
+    0x1F, 0x15, 0x15, 0x15, 0x1F, 0x17, 0x15, 0x15, 0x15, 0x1F
+};
+
+/**
+ * @var   _astClockGlyph
+ * @brief Clock font glyphs ('0' to '9'), fixed width
+ */
+static const FontGlyph _astClockGlyph[10] = {
+    {  0, 5 }, {  5, 5 }, { 10, 5 }, { 15, 5 }, { 20, 5 },
+    { 25, 5 }, { 30, 5 }, { 35, 5 }, { 40, 5 }, { 45, 5 }
+};
+
+/**
+ * @var   _astFont
+ * @brief Font table
+ */
+static const Font _astFont[NUM_OF_FONTS] = {
+    {
+        _au8SmallColumns, _astSmallGlyph,
+        _astSmallKerning, sizeof(_astSmallKerning) / sizeof(FontKerning),
+        ' ', '`', '?', 5, 1, true
+    },
+    {
+        _au8ClockColumns, _astClockGlyph,
+        NULL, 0,
+        '0', '9', 0, 5, 3, false
+    }
+};
+
+static void     _Blit(uint8_t* pu8Buffer, uint8_t u8Row, uint32_t u32Bits, uint32_t u32Mask);
+static uint32_t _GetMask(const FontRegion* pstRegion);
+static uint16_t _Render(const Font* pstFont, const char* pacText, uint32_t* pu32Rows, uint8_t u8Stride, int16_t s16X, uint16_t u16Limit);
+
+/**
+ * @brief  Draw text into a frame buffer region
+ * @note   The whole region is redrawn; pixels outside of the text are
+ *         cleared.
+ * @param  eID
+ *         Font ID
+ * @param  pacText
+ *         Zero-terminated text
+ * @param  pu8Buffer
+ *         Pointer to frame buffer
+ * @param  pstRegion
+ *         Pointer to region; the text is clipped to it
+ * @param  s16X
+ *         Text position relative to the region, may be negative
+ * @return Text width in pixels
+ */
+uint16_t Font_DrawText(FontID eID, const char* pacText, uint8_t* pu8Buffer, const FontRegion* pstRegion, int16_t s16X)
+{
+    uint32_t au32Rows[FONT_MAX_HEIGHT] = { 0 };
+    uint32_t u32Mask;
+    uint16_t u16Width;
+
+    if (NUM_OF_FONTS <= eID)
+    {
+        return 0;
+    }
+
+    u16Width = _Render(&_astFont[eID], pacText, au32Rows, 1, s16X, pstRegion->u8Width);
+    u32Mask  = _GetMask(pstRegion);
+
+    for (uint8_t u8Row = 0; u8Row < pstRegion->u8Height; u8Row++)
+    {
+        uint32_t u32Bits = (u8Row < _astFont[eID].u8Height) ? au32Rows[u8Row] : 0;
+
+        _Blit(pu8Buffer, pstRegion->u8Y + u8Row, u32Bits >> pstRegion->u8X, u32Mask);
+    }
+
+    return u16Width;
+}
+
+/**
+ * @brief  Get text width
+ * @param  eID
+ *         Font ID
+ * @param  pacText
+ *         Zero-terminated text
+ * @return Text width in pixels
+ */
+uint16_t Font_GetTextWidth(FontID eID, const char* pacText)
+{
+    if (NUM_OF_FONTS <= eID)
+    {
+        return 0;
+    }
+
+    return _Render(&_astFont[eID], pacText, NULL, 0, 0, 0);
+}
+
+/**
+ * @brief  Set up marquee
+ * @details The text scrolls in from the right and out to the left.
+ * @param  pstMarquee
+ *         Pointer to marquee
+ * @param  eID
+ *         Font ID
+ * @param  pacText
+ *         Zero-terminated text
+ * @param  pstRegion
+ *         Pointer to region
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error, text too long
+ */
+int Font_SetMarquee(FontMarquee* pstMarquee, FontID eID, const char* pacText, const FontRegion* pstRegion)
+{
+    uint16_t u16Width;
+
+    if (NUM_OF_FONTS <= eID)
+    {
+        return -1;
+    }
+
+    // One pass and a word to read ahead
+    u16Width = Font_GetTextWidth(eID, pacText);
+    if ((pstRegion->u8Width + u16Width + 32U) > (FONT_MARQUEE_WORDS * 32U))
+    {
+        return -1;
+    }
+
+    memset(pstMarquee->au32Strip, 0, sizeof(pstMarquee->au32Strip));
+
+    // Starts with a blank region, so the end wraps around seamlessly
+    _Render(&_astFont[eID], pacText, &pstMarquee->au32Strip[0][0], FONT_MARQUEE_WORDS, pstRegion->u8Width, FONT_MARQUEE_WORDS * 32U);
+
+    pstMarquee->stRegion  = *pstRegion;
+    // The last step shows the blank column after the text
+    pstMarquee->u16Period = pstRegion->u8Width + u16Width + 1U;
+    pstMarquee->u16Offset = 0;
+    pstMarquee->u8Height  = _astFont[eID].u8Height;
+
+    return 0;
+}
+
+/**
+ * @brief  Draw marquee and scroll it by one pixel
+ * @param  pstMarquee
+ *         Pointer to marquee
+ * @param  pu8Buffer
+ *         Pointer to frame buffer
+ * @return A pass is complete, the region is blank
+ */
+bool Font_StepMarquee(FontMarquee* pstMarquee, uint8_t* pu8Buffer)
+{
+    uint8_t  u8Word  = (uint8_t)(pstMarquee->u16Offset >> 5);
+    uint8_t  u8Shift = (uint8_t)(pstMarquee->u16Offset & 31U);
+    uint32_t u32Mask = _GetMask(&pstMarquee->stRegion);
+
+    for (uint8_t u8Row = 0; u8Row < pstMarquee->stRegion.u8Height; u8Row++)
+    {
+        uint32_t u32Bits = 0;
+
+        if (u8Row < pstMarquee->u8Height)
+        {
+            const uint32_t* pu32Strip = &pstMarquee->au32Strip[u8Row][u8Word];
+
+            u32Bits = pu32Strip[0] << u8Shift;
+            if (0 != u8Shift)
+            {
+                u32Bits |= pu32Strip[1] >> (32U - u8Shift);
+            }
+        }
+
+        _Blit(pu8Buffer, pstMarquee->stRegion.u8Y + u8Row, u32Bits >> pstMarquee->stRegion.u8X, u32Mask);
+    }
+
+    pstMarquee->u16Offset++;
+    if (pstMarquee->u16Offset >= pstMarquee->u16Period)
+    {
+        pstMarquee->u16Offset = 0;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Write masked row to frame buffer
+ * @param pu8Buffer
+ *        Pointer to frame buffer
+ * @param u8Row
+ *        Row
+ * @param u32Bits
+ *        Pixels, MSB left
+ * @param u32Mask
+ *        Pixels to be written
+ */
+static void _Blit(uint8_t* pu8Buffer, uint8_t u8Row, uint32_t u32Bits, uint32_t u32Mask)
+{
+    uint8_t* pu8Row = &pu8Buffer[u8Row * FONT_ROW_BYTES];
+
+    for (uint8_t u8Idx = 0; u8Idx < FONT_ROW_BYTES; u8Idx++)
+    {
+        uint8_t u8Shift = (uint8_t)(24U - (8U * u8Idx));
+        uint8_t u8Mask  = (uint8_t)(u32Mask >> u8Shift);
+
+        if (0 != u8Mask)
+        {
+            pu8Row[u8Idx] = (pu8Row[u8Idx] & ~u8Mask) | ((uint8_t)(u32Bits >> u8Shift) & u8Mask);
+        }
+    }
+}
+
+/**
+ * @brief  Get row mask of a region
+ * @param  pstRegion
+ *         Pointer to region
+ * @return Mask, MSB left
+ */
+static uint32_t _GetMask(const FontRegion* pstRegion)
+{
+    uint32_t u32Mask = 0xFFFFFFFFUL;
+
+    if (32U > pstRegion->u8Width)
+    {
+        u32Mask = ~(0xFFFFFFFFUL >> pstRegion->u8Width);
+    }
+
+    return u32Mask >> pstRegion->u8X;
+}
+
+/**
+ * @brief  Render text into rows of words
+ * @param  pstFont
+ *         Pointer to font
+ * @param  pacText
+ *         Zero-terminated text
+ * @param  pu32Rows
+ *         Pointer to rows (MSB left) or NULL to measure only
+ * @param  u8Stride
+ *         Words per row
+ * @param  s16X
+ *         Text position in pixels, may be negative
+ * @param  u16Limit
+ *         Pixels per row; the text is clipped to it
+ * @return Text width in pixels
+ */
+static uint16_t _Render(const Font* pstFont, const char* pacText, uint32_t* pu32Rows, uint8_t u8Stride, int16_t s16X, uint16_t u16Limit)
+{
+    int16_t s16Pos = 0;
+    char    cLast  = 0;
+
+    for (; '\0' != *pacText; pacText++)
+    {
+        const FontGlyph* pstGlyph;
+        char             cChar = *pacText;
+
+        if (pstFont->bUpperCase && ('a' <= cChar) && ('z' >= cChar))
+        {
+            cChar = (char)(cChar - 'a' + 'A');
+        }
+
+        if ((pstFont->cFirst > cChar) || (pstFont->cLast < cChar))
+        {
+            cChar = pstFont->cDefault;
+            if (0 == cChar)
+            {
+                continue;
+            }
+        }
+
+        if (0 != cLast)
+        {
+            s16Pos += pstFont->u8Spacing;
+
+            for (uint8_t u8Idx = 0; u8Idx < pstFont->u8Kernings; u8Idx++)
+            {
+                if ((cLast == pstFont->pastKerning[u8Idx].cLeft) && (cChar == pstFont->pastKerning[u8Idx].cRight))
+                {
+                    s16Pos += pstFont->pastKerning[u8Idx].s8Adjust;
+                    break;
+                }
+            }
+        }
+
+        pstGlyph = &pstFont->pastGlyph[cChar - pstFont->cFirst];
+
+        for (uint8_t u8Col = 0; (NULL != pu32Rows) && (u8Col < pstGlyph->u8Width); u8Col++)
+        {
+            int16_t  s16Col  = s16X + s16Pos + u8Col;
+            uint8_t  u8Bits  = pstFont->pu8Columns[pstGlyph->u16Offset + u8Col];
+            uint32_t u32Mask = 0x80000000UL >> (s16Col & 31);
+
+            if ((0 > s16Col) || (u16Limit <= s16Col))
+            {
+                continue;
+            }
+
+            for (uint8_t u8Row = 0; 0 != u8Bits; u8Row++, u8Bits >>= 1)
+            {
+                if (u8Bits & 1U)
+                {
+                    pu32Rows[(u8Row * u8Stride) + (s16Col >> 5)] |= u32Mask;
+                }
+            }
+        }
+
+        s16Pos += pstGlyph->u8Width;
+        cLast   = cChar;
+    }
+
+    return (uint16_t)s16Pos;
+}
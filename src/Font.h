@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Font.h
+ * @brief Bitmap font renderer
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FONT_MAX_HEIGHT    8   ///< Max. glyph height in pixels
+#define FONT_MARQUEE_WORDS 8   ///< Marquee strip length in 32-bit words
+#define FONT_DEGREE        "`" ///< Degree sign (FONT_SMALL)
+
+/**
+ * @enum  FontID
+ * @brief Font IDs
+ */
+typedef enum
+{
+    FONT_SMALL = 0, ///< ID, Proportional 5 pixel font, upper case
+    FONT_CLOCK,     ///< ID, Clock digits, 5x5 pixels
+    NUM_OF_FONTS    ///< Total number of fonts
+
+} FontID;
+
+/**
+ * @struct FontRegion
+ * @brief  Region of a frame buffer (@ref DMD_WIDTH x @ref DMD_HEIGHT)
+ */
+typedef struct
+{
+    uint8_t u8X;      ///< Left column
+    uint8_t u8Y;      ///< Top row
+    uint8_t u8Width;  ///< Width in pixels (1 to DMD_WIDTH - u8X)
+    uint8_t u8Height; ///< Height in pixels (1 to DMD_HEIGHT - u8Y)
+
+} FontRegion;
+
+/**
+ * @struct FontMarquee
+ * @brief  Scrolling text
+ * @note   The text is rendered once; each step only shifts the strip.
+ */
+typedef struct
+{
+    uint32_t   au32Strip[FONT_MAX_HEIGHT][FONT_MARQUEE_WORDS]; ///< Rendered text, MSB left
+    FontRegion stRegion;                                       ///< Target region
+    uint16_t   u16Period;                                      ///< Steps per pass (region width, text and a blank column)
+    uint16_t   u16Offset;                                      ///< Current scroll position in pixels
+    uint8_t    u8Height;                                       ///< Font height in pixels
+
+} FontMarquee;
+
+uint16_t Font_DrawText(FontID eID, const char* pacText, uint8_t* pu8Buffer, const FontRegion* pstRegion, int16_t s16X);
+uint16_t Font_GetTextWidth(FontID eID, const char* pacText);
+int      Font_SetMarquee(FontMarquee* pstMarquee, FontID eID, const char* pacText, const FontRegion* pstRegion);
+bool     Font_StepMarquee(FontMarquee* pstMarquee, uint8_t* pu8Buffer);
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      FontTest.c
+ * @brief     Host test of the marquee
+ * @details   Scrolls random texts through random regions of a frame
+ *            buffer filled with random pixels, one full pass each.
+ *            Fails if a pixel of the region is still lit once
+ *            @ref Font_StepMarquee reports the pass as complete, or if
+ *            a pixel outside the region has been changed.
+ * @code{.unparsed}
+ * Usage: program [-n texts] [-s seed]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_FONTTEST
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "DMD.h"
+#include "Font.h"
+
+#define TEST_BUFFER_SIZE ((DMD_WIDTH / 8) * DMD_HEIGHT) ///< Frame buffer size in bytes
+#define TEST_MAX_TEXT    24                            ///< Max. text length in characters
+
+static uint32_t _Random(uint64_t* pu64State);
+static bool     _RunText(uint32_t u32Text, uint64_t* pu64State);
+
+/**
+ * @brief  Font test entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    uint32_t u32Texts = 10000;
+    uint64_t u64State = 0x5CA1AB1EULL;
+    int      nOpt;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "n:s:")))
+    {
+        switch (nOpt)
+        {
+            case 'n':
+                u32Texts = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                u64State = strtoull(optarg, NULL, 0) | 1U;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n texts] [-s seed]\n", apcArgv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for (uint32_t u32Text = 0; u32Text < u32Texts; u32Text++)
+    {
+        if (! _RunText(u32Text, &u64State))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%u texts: marquee region blank after every pass\n", u32Texts);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief  xorshift64* pseudo random number generator
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return Random number
+ */
+static uint32_t _Random(uint64_t* pu64State)
+{
+    *pu64State ^= *pu64State >> 12;
+    *pu64State ^= *pu64State << 25;
+    *pu64State ^= *pu64State >> 27;
+
+    return (uint32_t)((*pu64State * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief  Scroll one random text for a full pass
+ * @param  u32Text
+ *         Text index
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return true: region blank, outside unchanged; false: error
+ */
+static bool _RunText(uint32_t u32Text, uint64_t* pu64State)
+{
+    uint8_t     au8Buffer[TEST_BUFFER_SIZE];
+    uint8_t     au8Before[TEST_BUFFER_SIZE];
+    char        acText[TEST_MAX_TEXT + 1];
+    FontMarquee stMarquee;
+    FontRegion  stRegion;
+    uint32_t    u32Length = 1U + (_Random(pu64State) % TEST_MAX_TEXT);
+    uint32_t    u32Steps  = 0;
+
+    // Upper case, digits, punctuation and the degree sign
+    for (uint32_t u32Idx = 0; u32Idx < u32Length; u32Idx++)
+    {
+        acText[u32Idx] = (char)(' ' + (_Random(pu64State) % 65U));
+    }
+    acText[u32Length] = '\0';
+
+    stRegion.u8X      = (uint8_t)(_Random(pu64State) % DMD_WIDTH);
+    stRegion.u8Y      = (uint8_t)(_Random(pu64State) % DMD_HEIGHT);
+    stRegion.u8Width  = (uint8_t)(1U + (_Random(pu64State) % (DMD_WIDTH - stRegion.u8X)));
+    stRegion.u8Height = (uint8_t)(1U + (_Random(pu64State) % (DMD_HEIGHT - stRegion.u8Y)));
+
+    if (0 != Font_SetMarquee(&stMarquee, FONT_SMALL, acText, &stRegion))
+    {
+        // Too long for the strip
+        return true;
+    }
+
+    for (uint32_t u32Idx = 0; u32Idx < TEST_BUFFER_SIZE; u32Idx++)
+    {
+        au8Buffer[u32Idx] = (uint8_t)_Random(pu64State);
+    }
+    memcpy(au8Before, au8Buffer, sizeof(au8Buffer));
+
+    while (! Font_StepMarquee(&stMarquee, au8Buffer))
+    {
+        u32Steps++;
+    }
+
+    for (uint8_t u8Y = 0; u8Y < DMD_HEIGHT; u8Y++)
+    {
+        for (uint8_t u8X = 0; u8X < DMD_WIDTH; u8X++)
+        {
+            bool bInside = (u8X >= stRegion.u8X) && (u8X < (stRegion.u8X + stRegion.u8Width)) &&
+                           (u8Y >= stRegion.u8Y) && (u8Y < (stRegion.u8Y + stRegion.u8Height));
+            bool bPixel  = DMD_GetPixel(au8Buffer, u8X, u8Y);
+
+            if ((bInside && bPixel) || ((! bInside) && (bPixel != DMD_GetPixel(au8Before, u8X, u8Y))))
+            {
+                fprintf(stderr, "Text %u \"%s\", region %u,%u %ux%u: pixel %u,%u %s after %u steps\n",
+                        u32Text, acText,
+                        stRegion.u8X, stRegion.u8Y, stRegion.u8Width, stRegion.u8Height,
+                        u8X, u8Y, bInside ? "still lit" : "changed", u32Steps + 1U);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+#endif // USE_FONTTEST
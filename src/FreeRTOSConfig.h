@@ -50,17 +50,23 @@
 #if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
   #include <stdint.h>
   extern uint32_t SystemCoreClock;
+  extern uint32_t MCAL_GetMicroseconds(void);
+  #ifdef USE_TRACE
+  extern void Trace_TaskCreate(void* pvTCB, const char* pacName);
+  extern void Trace_TaskSwitchedIn(void* pvTCB);
+  #endif
 #endif
 #define configUSE_PREEMPTION                     1
 #define configSUPPORT_STATIC_ALLOCATION          1
-#define configSUPPORT_DYNAMIC_ALLOCATION         1
-#define configUSE_IDLE_HOOK                      0
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
+#define configUSE_IDLE_HOOK                      1
 #define configUSE_TICK_HOOK                      0
+#define configUSE_TICKLESS_IDLE                  2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP    20
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 7 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)3072)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
@@ -81,6 +87,23 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil             0
 #define INCLUDE_vTaskDelay                  1
 #define INCLUDE_xTaskGetSchedulerState      1
+#define INCLUDE_xTaskGetCurrentTaskHandle   1
+
+/* Run-time statistics (debug builds only), counted by the TIM3
+microsecond clock which is started by System_Init(). */
+#ifdef USE_RUNTIME_STATS
+#define configGENERATE_RUN_TIME_STATS            1
+#define configUSE_TRACE_FACILITY                 1
+#define INCLUDE_uxTaskGetStackHighWaterMark      1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()         MCAL_GetMicroseconds()
+#endif
+
+/* Event trace (debug builds only), see Trace.c. */
+#ifdef USE_TRACE
+#define traceTASK_CREATE(pxNewTCB)               Trace_TaskCreate((pxNewTCB), (pxNewTCB)->pcTaskName)
+#define traceTASK_SWITCHED_IN()                  Trace_TaskSwitchedIn(pxCurrentTCB)
+#endif
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
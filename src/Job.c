@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Job.c
+ * @brief     Stackless cooperative jobs
+ * @details   Light periodic work runs as jobs inside a single task
+ *            instead of a task each, so they share one stack.  A job is
+ *            a function which is re-entered from the top and jumps to
+ *            where it yielded last (see @ref JOB_BEGIN); it costs
+ *            only its @ref Job entry, compared to a control block and
+ *            @ref configMINIMAL_STACK_SIZE words of stack per task.
+ *
+ *            The job task runs every job which is due and then blocks
+ *            until the earliest wake-up, so the MCU may enter STOP mode
+ *            in between.  Jobs must not block for long; a job which
+ *            does delays all others.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "Job.h"
+#include "cmsis_os.h"
+#include "task.h"
+
+#define JOB_STACK_SIZE 192U ///< Job thread stack size in words, see custom_budget_stack
+
+/**
+ * @struct JobData
+ * @brief  Job runner data
+ */
+typedef struct
+{
+    Job* pstHead; ///< Run list
+
+} JobData;
+
+/**
+ * @var   _stJob
+ * @brief Job runner private data
+ */
+static JobData _stJob = { 0 };
+
+static TaskHandle_t _hJobThread;                          ///< Job thread handle
+static StaticTask_t _stJobThreadTCB;                      ///< Job thread control block
+static StackType_t  _au32JobThreadStack[JOB_STACK_SIZE]; ///< Job thread stack
+
+static bool _IsDue(const Job* pstJob, TickType_t xNow);
+static void _JobThread(void* pArg);
+
+/**
+ * @brief  Add job
+ * @note   The job is started with the next run of the job thread.
+ * @param  pstJob
+ *         Pointer to job entry, must stay valid until the job is done
+ * @param  pfnRun
+ *         Job function
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Job_Add(Job* pstJob, JobFunction pfnRun)
+{
+    if ((NULL == pstJob) || (NULL == pfnRun))
+    {
+        return -1;
+    }
+
+    pstJob->pfnRun  = pfnRun;
+    pstJob->u16Line = 0;
+    pstJob->u32Wake = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    pstJob->pstNext = _stJob.pstHead;
+    _stJob.pstHead  = pstJob;
+    taskEXIT_CRITICAL();
+
+    if (NULL != _hJobThread)
+    {
+        xTaskNotifyGive(_hJobThread);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief  Initialise job runner
+ * @note   Must be called before any job is added.
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Job_Init(void)
+{
+    _hJobThread = xTaskCreateStatic(
+        _JobThread,
+        "Jobs",
+        JOB_STACK_SIZE,
+        NULL,
+        osPriorityNormal,
+        _au32JobThreadStack,
+        &_stJobThreadTCB);
+
+    if (NULL == _hJobThread)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Set the time until the job is resumed
+ * @note  Used by @ref JOB_DELAY; only to be called by the job itself.
+ * @param pstJob
+ *        Pointer to job entry
+ * @param u32DelayInMs
+ *        Delay in ms
+ */
+void Job_SetDelay(Job* pstJob, uint32_t u32DelayInMs)
+{
+    pstJob->u32Wake = xTaskGetTickCount() + pdMS_TO_TICKS(u32DelayInMs);
+}
+
+/**
+ * @brief Resume job with the next run of the job thread
+ * @note  Ends a @ref JOB_DELAY early.  Must not be called from an
+ *        interrupt.
+ * @param pstJob
+ *        Pointer to job entry
+ */
+void Job_Wake(Job* pstJob)
+{
+    pstJob->u32Wake = xTaskGetTickCount();
+    xTaskNotifyGive(_hJobThread);
+}
+
+/**
+ * @brief  Check if a job is due
+ * @param  pstJob
+ *         Pointer to job entry
+ * @param  xNow
+ *         Current tick
+ * @return Boolean state
+ */
+static bool _IsDue(const Job* pstJob, TickType_t xNow)
+{
+    return (0 <= (int32_t)(xNow - pstJob->u32Wake));
+}
+
+/**
+ * @brief   Job thread
+ * @details Runs every due job once and blocks until the next one is
+ *          due or a job is woken up.
+ * @param   pArg: Unused
+ */
+static void _JobThread(void* pArg)
+{
+    while (1)
+    {
+        TickType_t xNow     = xTaskGetTickCount();
+        TickType_t xTimeout = portMAX_DELAY;
+        TickType_t xElapsed;
+        Job**      ppstLink = &_stJob.pstHead;
+
+        while (NULL != *ppstLink)
+        {
+            Job* pstJob = *ppstLink;
+
+            if (_IsDue(pstJob, xNow))
+            {
+                // Default for JOB_YIELD and JOB_WAIT_UNTIL: next tick
+                pstJob->u32Wake = xNow + 1U;
+
+                if (JOB_DONE == pstJob->pfnRun(pstJob))
+                {
+                    taskENTER_CRITICAL();
+                    // Jobs added meanwhile are in front of this one
+                    while (pstJob != *ppstLink)
+                    {
+                        ppstLink = &(*ppstLink)->pstNext;
+                    }
+                    *ppstLink = pstJob->pstNext;
+                    taskEXIT_CRITICAL();
+                    continue;
+                }
+            }
+
+            if ((TickType_t)(pstJob->u32Wake - xNow) < xTimeout)
+            {
+                xTimeout = (TickType_t)(pstJob->u32Wake - xNow);
+            }
+            ppstLink = &pstJob->pstNext;
+        }
+
+        // Time has passed while the jobs were running
+        xElapsed = xTaskGetTickCount() - xNow;
+        if (portMAX_DELAY != xTimeout)
+        {
+            xTimeout = (xTimeout > xElapsed) ? (xTimeout - xElapsed) : 0;
+        }
+
+        ulTaskNotifyTake(pdTRUE, xTimeout);
+    }
+}
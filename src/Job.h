@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Job.h
+ * @brief Stackless cooperative jobs
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @enum  JobState
+ * @brief Job states, returned by the job function
+ */
+typedef enum
+{
+    JOB_WAITING = 0, ///< Job has yielded and is resumed later
+    JOB_DONE         ///< Job has finished and is removed
+
+} JobState;
+
+struct Job;
+
+/**
+ * @brief Job function
+ * @note  Local variables are lost at every JOB_ macro which yields;
+ *        state has to be kept in static or module data.  The resume
+ *        points are line numbers, so at most one JOB_ macro per line.
+ */
+typedef JobState (*JobFunction)(struct Job* pstJob);
+
+/**
+ * @struct Job
+ * @brief  Job, allocated by the caller
+ */
+typedef struct Job
+{
+    struct Job* pstNext; ///< Next job in the run list
+    JobFunction pfnRun;  ///< Job function
+    uint32_t    u32Wake; ///< Tick at which the job is resumed
+    uint16_t    u16Line; ///< Resume point, 0: start
+
+} Job;
+
+/**
+ * @brief Start of a job function
+ */
+#define JOB_BEGIN(pstJob) switch ((pstJob)->u16Line) { case 0:
+
+/**
+ * @brief End of a job function; the job is removed
+ */
+#define JOB_END(pstJob) } (pstJob)->u16Line = 0; return JOB_DONE
+
+/**
+ * @brief Yield; the job is resumed with the next tick
+ */
+#define JOB_YIELD(pstJob)                 \
+    do                                    \
+    {                                     \
+        (pstJob)->u16Line = __LINE__;     \
+        return JOB_WAITING;               \
+        case __LINE__:;                   \
+    } while (0)
+
+/**
+ * @brief Yield for the given time in ms, or until @ref Job_Wake
+ */
+#define JOB_DELAY(pstJob, u32DelayInMs)              \
+    do                                               \
+    {                                                \
+        Job_SetDelay((pstJob), (u32DelayInMs));      \
+        (pstJob)->u16Line = __LINE__;                \
+        return JOB_WAITING;                          \
+        case __LINE__:;                              \
+    } while (0)
+
+/**
+ * @brief Yield until the condition is true; it is checked every tick
+ */
+#define JOB_WAIT_UNTIL(pstJob, bCondition) \
+    do                                     \
+    {                                      \
+        case __LINE__:                     \
+        if (! (bCondition))                \
+        {                                  \
+            (pstJob)->u16Line = __LINE__;  \
+            return JOB_WAITING;            \
+        }                                  \
+    } while (0)
+
+int  Job_Add(Job* pstJob, JobFunction pfnRun);
+int  Job_Init(void);
+void Job_SetDelay(Job* pstJob, uint32_t u32DelayInMs);
+void Job_Wake(Job* pstJob);
@@ -2,14 +2,69 @@
 /**
  * @file      LifeCycle.c
  * @brief     Life cycle handler
+ * @details   Allocation-free simulation engine.  All meters use Q16.16
+ *            fixed-point arithmetic and every evolution is described by
+ *            constant tables, so one simulated second costs a bounded
+ *            number of cycles and the engine builds for the host, too
+ *            (HOST_BUILD).
  * @author    Michael Fitzmayer
  * @copyright "THE BEER-WARE LICENCE" (Revision 42)
  */
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "Button.h"
 #include "LifeCycle.h"
 
-static void _LifeCycleThread(void* pArg);
+#ifndef HOST_BUILD
+#include "FreeRTOS.h"
+#include "Job.h"
+#include "MCAL.h"
+#include "cmsis_os.h"
+#include "task.h"
+#endif
+
+#define LIFECYCLE_SECONDS_PER_DAY 86400UL ///< Seconds per day
+#define LIFECYCLE_CALL_TIMEOUT      900U  ///< Seconds until an ignored call is a care mistake
+#define LIFECYCLE_DIRT_TIMEOUT     3600U  ///< Seconds until uncleaned poo makes sick
+#define LIFECYCLE_SICK_TIMEOUT    43200U  ///< Seconds until untreated sickness is fatal
+#define LIFECYCLE_TIRED_WINDOW     1800U  ///< Seconds before bedtime the pet is tired
+#define LIFECYCLE_DISCIPLINE_STEP    25U  ///< Discipline gained per scolding
+#define LIFECYCLE_MAX_SUBSCRIBERS      2U  ///< Max. number of change subscribers
+
+#define LIFECYCLE_RATE(s) ((uint16_t)(LIFECYCLE_HEART / (s)))    ///< Decay of one heart per s seconds
+#define LIFECYCLE_DAYS(d) ((uint32_t)(d) * LIFECYCLE_SECONDS_PER_DAY) ///< Days in seconds
+
+/**
+ * @struct LifeCycleStage
+ * @brief  Evolution properties
+ */
+typedef struct
+{
+    uint32_t u32Duration;        ///< Seconds until evolving (0: never)
+    uint32_t u32MaxAge;          ///< Age in seconds the pet dies at (0: never)
+    uint16_t u16HungerRate;      ///< Hunger decay per second, Q16.16
+    uint16_t u16HappyRate;       ///< Happiness decay per second, Q16.16
+    uint16_t u16PooInterval;     ///< Seconds between poos (0: never)
+    uint8_t  u8Bedtime;          ///< Hour the pet falls asleep
+    uint8_t  u8Wakeup;           ///< Hour the pet wakes up (bedtime: never sleeps)
+    uint8_t  u8Transition;       ///< Index of first transition
+    uint8_t  u8NumOfTransitions; ///< Number of transitions
+
+} LifeCycleStage;
+
+/**
+ * @struct LifeCycleTransition
+ * @brief  Evolution transition, first matching entry is taken
+ */
+typedef struct
+{
+    Evolution eTo;             ///< Target evolution
+    uint8_t   u8MaxMistakes;   ///< Max. care mistakes in current evolution
+    uint8_t   u8MaxDiscipline; ///< Max. discipline in percent
+
+} LifeCycleTransition;
 
 /**
  * @struct LifeCycleData
@@ -17,7 +72,17 @@ static void _LifeCycleThread(void* pArg);
  */
 typedef struct
 {
-    Stats stStats; ///< Statistics
+    Stats        stStats;                                  ///< Statistics
+    #ifndef HOST_BUILD
+    TaskHandle_t ahSubscriber[LIFECYCLE_MAX_SUBSCRIBERS]; ///< Tasks notified on changes
+    uint16_t     u16Flags;                                 ///< Last published status flags
+    uint16_t     u16CareMistages;                          ///< Last published care mistakes
+    Evolution    eEvolution;                               ///< Last published evolution
+    uint32_t     u32ClockOffset;                           ///< Pending RTC adjustment in seconds (modulo one day)
+    uint32_t     u32Last;                                  ///< Time of day of the last run
+    uint32_t     u32Revision;                              ///< Incremented on every change outside the job
+    Job          stJob;                                    ///< Life cycle job
+    #endif
 
 } LifeCycleData;
 
@@ -27,12 +92,88 @@ typedef struct
  */
 static LifeCycleData _stLifeCycle = { 0 };
 
+/**
+ * @var   _astTransition
+ * @brief Evolution transitions, grouped by evolution
+ */
+static const LifeCycleTransition _astTransition[] = {
+    { BABYTCHI,      255, 255 }, //  0: Egg
+    { MARUTCHI,      255, 255 }, //  1: Babytchi
+    { TAMATCHI,        2, 255 }, //  2: Marutchi
+    { KUCHITAMATCHI, 255, 255 }, //  3
+    { MAMETCHI,        1, 255 }, //  4: Tamatchi
+    { GINJIROTCHI,     3, 255 }, //  5
+    { MASKUTCHI,       5, 255 }, //  6
+    { KUCHIPATCHI,     7, 255 }, //  7
+    { NYOROTCHI,       9, 255 }, //  8
+    { TARAKOTCHI,    255, 255 }, //  9
+    { KUCHIPATCHI,     1, 255 }, // 10: Kuchitamatchi
+    { NYOROTCHI,       5, 255 }, // 11
+    { TARAKOTCHI,    255, 255 }, // 12
+    { OYAJITCHI,       0,   0 }, // 13: Maskutchi
+    { MASKUTCHI,     255, 255 }  // 14
+};
+
+/**
+ * @var   _astStage
+ * @brief Evolution properties, indexed by @ref Evolution
+ */
+static const LifeCycleStage _astStage[NUM_OF_EVOLUTIONS] = {
+    // Duration          Max. age            Hunger                 Happiness              Poo    Bed Wake Transitions
+    { 300,               0,                  0,                     0,                     0,     0,  0,   0, 1 }, // Egg
+    { 3600,              0,                  LIFECYCLE_RATE(180),   LIFECYCLE_RATE(240),   600,   0,  0,   1, 1 }, // Babytchi
+    { LIFECYCLE_DAYS(1), 0,                  LIFECYCLE_RATE(1800),  LIFECYCLE_RATE(2400),  10800, 20, 9,   2, 2 }, // Marutchi
+    { LIFECYCLE_DAYS(2), 0,                  LIFECYCLE_RATE(2700),  LIFECYCLE_RATE(3000),  10800, 21, 9,   4, 6 }, // Tamatchi
+    { LIFECYCLE_DAYS(2), 0,                  LIFECYCLE_RATE(2400),  LIFECYCLE_RATE(2700),  10800, 21, 9,  10, 3 }, // Kuchitamatchi
+    { 0,                 LIFECYCLE_DAYS(16), LIFECYCLE_RATE(3600),  LIFECYCLE_RATE(3600),  10800, 22, 9,   0, 0 }, // Mametchi
+    { 0,                 LIFECYCLE_DAYS(14), LIFECYCLE_RATE(3600),  LIFECYCLE_RATE(3600),  10800, 22, 9,   0, 0 }, // Ginjirotchi
+    { LIFECYCLE_DAYS(1), LIFECYCLE_DAYS(12), LIFECYCLE_RATE(3600),  LIFECYCLE_RATE(3600),  10800, 22, 9,  13, 2 }, // Maskutchi
+    { 0,                 LIFECYCLE_DAYS(10), LIFECYCLE_RATE(3300),  LIFECYCLE_RATE(3300),  10800, 22, 9,   0, 0 }, // Kuchipatchi
+    { 0,                 LIFECYCLE_DAYS(8),  LIFECYCLE_RATE(3000),  LIFECYCLE_RATE(3000),  10800, 22, 9,   0, 0 }, // Nyorotchi
+    { 0,                 LIFECYCLE_DAYS(6),  LIFECYCLE_RATE(2700),  LIFECYCLE_RATE(2700),  10800, 22, 9,   0, 0 }, // Tarakotchi
+    { 0,                 LIFECYCLE_DAYS(16), LIFECYCLE_RATE(3600),  LIFECYCLE_RATE(3600),  10800, 22, 9,   0, 0 }, // Oyajitchi
+    { 0,                 0,                  0,                     0,                     0,     0,  0,   0, 0 }  // Obaketchi
+};
+
+static void     _Decay(uint32_t* pu32Meter, uint16_t u16Rate);
+static void     _DecayBy(uint32_t* pu32Meter, uint16_t u16Rate, uint32_t u32Seconds);
+static void     _Die(Stats* pstStats);
+static void     _Evolve(Stats* pstStats);
+static bool     _IsBedtime(const LifeCycleStage* pstStage, uint32_t u32TimeOfDay);
+static bool     _IsTired(const LifeCycleStage* pstStage, uint32_t u32TimeOfDay);
+static void     _Refill(uint32_t* pu32Meter);
+static uint32_t _SecondsToNextEvent(const Stats* pstStats);
+static uint32_t _SecondsUntil(uint32_t u32TimeOfDay, uint32_t u32Target);
+static void     _Skip(Stats* pstStats, uint32_t u32Seconds);
+
+#ifndef HOST_BUILD
+static uint32_t _GetTimeOfDay(void);
+static JobState _LifeCycleJob(Job* pstJob);
+#endif
+
 /**
  * @brief  Initialise life cycle
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
  */
-void LifeCycle_Init(void)
+int LifeCycle_Init(void)
 {
-    _stLifeCycle.stStats.eEvolution = EGG;
+    #ifndef HOST_BUILD
+    LifeCycle_Reset(&_stLifeCycle.stStats, _GetTimeOfDay());
+    _stLifeCycle.u16Flags        = _stLifeCycle.stStats.u16Flags;
+    _stLifeCycle.u16CareMistages = _stLifeCycle.stStats.u16CareMistages;
+    _stLifeCycle.eEvolution      = _stLifeCycle.stStats.eEvolution;
+
+    if (0 != Job_Add(&_stLifeCycle.stJob, _LifeCycleJob))
+    {
+        return -1;
+    }
+    #else
+    LifeCycle_Reset(&_stLifeCycle.stStats, 0);
+    #endif
+
+    return 0;
 }
 
 /**
@@ -71,7 +212,16 @@ bool LifeCycle_IsFlagSet(StatusFlag eFlag)
  */
 void LifeCycle_ClearFlat(StatusFlag eFlag)
 {
+    #ifndef HOST_BUILD
+    taskENTER_CRITICAL();
+    _stLifeCycle.stStats.u16Flags &= ~(1 << eFlag);
+    _stLifeCycle.u32Revision++;
+    taskEXIT_CRITICAL();
+
+    LifeCycle_Publish();
+    #else
     _stLifeCycle.stStats.u16Flags &= ~(1 << eFlag);
+    #endif
 }
 
 /**
@@ -81,5 +231,938 @@ void LifeCycle_ClearFlat(StatusFlag eFlag)
  */
 void LifeCycle_SetFlag(StatusFlag eFlag)
 {
+    #ifndef HOST_BUILD
+    taskENTER_CRITICAL();
+    _stLifeCycle.stStats.u16Flags |= 1 << eFlag;
+    _stLifeCycle.u32Revision++;
+    taskEXIT_CRITICAL();
+
+    LifeCycle_Publish();
+    #else
     _stLifeCycle.stStats.u16Flags |= 1 << eFlag;
+    #endif
+}
+
+#ifndef HOST_BUILD
+/**
+ * @brief   Account for an adjustment of the RTC
+ * @details The adjustment is not counted as elapsed time.  Has to be
+ *          called in the same critical section in which the RTC is
+ *          set.
+ * @param   s32Seconds
+ *          Seconds the RTC has been set forward (negative: backward)
+ */
+void LifeCycle_AdjustClock(int32_t s32Seconds)
+{
+    int32_t s32Offset = s32Seconds % (int32_t)LIFECYCLE_SECONDS_PER_DAY;
+
+    taskENTER_CRITICAL();
+    _stLifeCycle.u32ClockOffset = (uint32_t)((int32_t)_stLifeCycle.u32ClockOffset + (int32_t)LIFECYCLE_SECONDS_PER_DAY + s32Offset);
+    _stLifeCycle.u32ClockOffset %= LIFECYCLE_SECONDS_PER_DAY;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief   Apply care action of a button event to the pet
+ * @details See @ref LifeCycle_HandleButton.  Marks the statistics as
+ *          changed, so a catch-up of the life cycle job running
+ *          concurrently is redone on top of the action.
+ * @param   u8Gesture
+ *          Gesture (@ref ButtonGesture)
+ * @param   u8Buttons
+ *          Buttons involved (BUTTON_A, BUTTON_B, BUTTON_C)
+ */
+void LifeCycle_Care(uint8_t u8Gesture, uint8_t u8Buttons)
+{
+    taskENTER_CRITICAL();
+    LifeCycle_HandleButton(&_stLifeCycle.stStats, u8Gesture, u8Buttons);
+    _stLifeCycle.u32Revision++;
+    taskEXIT_CRITICAL();
+
+    LifeCycle_Publish();
+}
+
+/**
+ * @brief   Notify subscribers about changed pet statistics
+ * @details Compares the published fields against the statistics and
+ *          sets the corresponding change bits in the notification
+ *          value of every subscriber.  Called by the life cycle job
+ *          and after care actions; must not be called from an
+ *          interrupt.
+ */
+void LifeCycle_Publish(void)
+{
+    uint32_t u32Changes = 0;
+
+    taskENTER_CRITICAL();
+    if (_stLifeCycle.eEvolution != _stLifeCycle.stStats.eEvolution)
+    {
+        _stLifeCycle.eEvolution  = _stLifeCycle.stStats.eEvolution;
+        u32Changes              |= LIFECYCLE_CHANGED_EVOLUTION;
+    }
+
+    if (_stLifeCycle.u16Flags != _stLifeCycle.stStats.u16Flags)
+    {
+        _stLifeCycle.u16Flags  = _stLifeCycle.stStats.u16Flags;
+        u32Changes            |= LIFECYCLE_CHANGED_FLAGS;
+    }
+
+    if (_stLifeCycle.u16CareMistages != _stLifeCycle.stStats.u16CareMistages)
+    {
+        _stLifeCycle.u16CareMistages  = _stLifeCycle.stStats.u16CareMistages;
+        u32Changes                   |= LIFECYCLE_CHANGED_CARE_MISTAKES;
+    }
+    taskEXIT_CRITICAL();
+
+    if (0 == u32Changes)
+    {
+        return;
+    }
+
+    for (uint8_t u8Idx = 0; u8Idx < LIFECYCLE_MAX_SUBSCRIBERS; u8Idx++)
+    {
+        if (NULL != _stLifeCycle.ahSubscriber[u8Idx])
+        {
+            xTaskNotify(_stLifeCycle.ahSubscriber[u8Idx], u32Changes, eSetBits);
+        }
+    }
+}
+
+/**
+ * @brief   Subscribe calling task to changes of the pet statistics
+ * @details The subscriber is notified via its task notification value,
+ *          see @ref LifeCycle_TakeChanges.
+ * @return  Error code
+ * @retval  0: OK
+ * @retval -1: Error, too many subscribers
+ */
+int LifeCycle_Subscribe(void)
+{
+    TaskHandle_t hTask  = xTaskGetCurrentTaskHandle();
+    int          nError = -1;
+
+    taskENTER_CRITICAL();
+    for (uint8_t u8Idx = 0; u8Idx < LIFECYCLE_MAX_SUBSCRIBERS; u8Idx++)
+    {
+        if ((NULL == _stLifeCycle.ahSubscriber[u8Idx]) || (hTask == _stLifeCycle.ahSubscriber[u8Idx]))
+        {
+            _stLifeCycle.ahSubscriber[u8Idx] = hTask;
+            nError = 0;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return nError;
+}
+
+/**
+ * @brief  Take pending changes of the calling subscriber
+ * @param  u32TimeoutInMs
+ *         Time to wait for a change in ms (0: do not block,
+ *         portMAX_DELAY: wait forever)
+ * @return Change mask (LIFECYCLE_CHANGED_*), 0 if nothing has changed
+ */
+uint32_t LifeCycle_TakeChanges(uint32_t u32TimeoutInMs)
+{
+    uint32_t   u32Changes = 0;
+    TickType_t xTimeout   = portMAX_DELAY;
+
+    if (portMAX_DELAY != u32TimeoutInMs)
+    {
+        xTimeout = pdMS_TO_TICKS(u32TimeoutInMs);
+    }
+
+    xTaskNotifyWait(0, UINT32_MAX, &u32Changes, xTimeout);
+
+    return u32Changes;
+}
+#endif
+
+/**
+ * @brief Reset pet to a freshly laid egg
+ * @param pstStats
+ *        Pointer to pet statistics
+ * @param u32TimeOfDay
+ *        Seconds since midnight
+ */
+void LifeCycle_Reset(Stats* pstStats, uint32_t u32TimeOfDay)
+{
+    memset(pstStats, 0, sizeof(Stats));
+    pstStats->eEvolution   = EGG;
+    pstStats->u32TimeOfDay = u32TimeOfDay % LIFECYCLE_SECONDS_PER_DAY;
+}
+
+/**
+ * @brief   Simulate one second of the pet's life
+ * @details Runs in constant time: every meter and timer is updated at
+ *          most once and evolutions are resolved via
+ *          @ref _astTransition.
+ * @param   pstStats
+ *          Pointer to pet statistics
+ */
+void LifeCycle_Tick(Stats* pstStats)
+{
+    const LifeCycleStage* pstStage = &_astStage[pstStats->eEvolution];
+    bool                  bCalling = false;
+
+    if (OBAKETCHI == pstStats->eEvolution)
+    {
+        return;
+    }
+
+    pstStats->u32Age++;
+    pstStats->u32StageTime++;
+    pstStats->u32TimeOfDay++;
+    if (LIFECYCLE_SECONDS_PER_DAY <= pstStats->u32TimeOfDay)
+    {
+        pstStats->u32TimeOfDay = 0;
+    }
+
+    // Sleep schedule
+    if (_IsBedtime(pstStage, pstStats->u32TimeOfDay))
+    {
+        pstStats->u16Flags |=  (1 << IS_SLEEPING);
+        pstStats->u16Flags &= ~(1 << IS_TIRED);
+    }
+    else
+    {
+        pstStats->u16Flags &= ~(1 << IS_SLEEPING);
+
+        if (_IsTired(pstStage, pstStats->u32TimeOfDay))
+        {
+            pstStats->u16Flags |=  (1 << IS_TIRED);
+        }
+        else
+        {
+            pstStats->u16Flags &= ~(1 << IS_TIRED);
+        }
+
+        // Meters only decay while awake
+        _Decay(&pstStats->u32Hunger,    pstStage->u16HungerRate);
+        _Decay(&pstStats->u32Happiness, pstStage->u16HappyRate);
+
+        if (0 != pstStage->u16PooInterval)
+        {
+            if (0 == pstStats->u16PooTimer)
+            {
+                pstStats->u16PooTimer = pstStage->u16PooInterval;
+            }
+
+            pstStats->u16PooTimer--;
+            if (0 == pstStats->u16PooTimer)
+            {
+                if (0 == pstStats->u8Poo)
+                {
+                    pstStats->u16DirtTimer = LIFECYCLE_DIRT_TIMEOUT;
+                }
+                if (LIFECYCLE_MAX_POO > pstStats->u8Poo)
+                {
+                    pstStats->u8Poo++;
+                }
+                pstStats->u16Flags |= (1 << HAS_POOPED);
+            }
+        }
+
+        if (EGG != pstStats->eEvolution)
+        {
+            if ((0 == pstStats->u32Hunger) || (0 == pstStats->u32Happiness))
+            {
+                bCalling = true;
+            }
+        }
+    }
+
+    // Ignoring a call for too long is a care mistake
+    if (bCalling)
+    {
+        if (! ((pstStats->u16Flags >> IS_CALLING) & 1))
+        {
+            pstStats->u16Flags     |= (1 << IS_CALLING);
+            pstStats->u16CallTimer  = LIFECYCLE_CALL_TIMEOUT;
+        }
+        else if (0 != pstStats->u16CallTimer)
+        {
+            pstStats->u16CallTimer--;
+            if (0 == pstStats->u16CallTimer)
+            {
+                pstStats->u16CareMistages++;
+                if (255 > pstStats->u8StageMistakes)
+                {
+                    pstStats->u8StageMistakes++;
+                }
+            }
+        }
+    }
+    else
+    {
+        pstStats->u16Flags &= ~(1 << IS_CALLING);
+    }
+
+    // Uncleaned poo makes sick, untreated sickness is fatal
+    if ((pstStats->u16Flags >> IS_SICK) & 1)
+    {
+        pstStats->u16SickTimer--;
+        if (0 == pstStats->u16SickTimer)
+        {
+            _Die(pstStats);
+            return;
+        }
+    }
+    else if (0 != pstStats->u8Poo)
+    {
+        pstStats->u16DirtTimer--;
+        if (0 == pstStats->u16DirtTimer)
+        {
+            pstStats->u16Flags     |= (1 << IS_SICK);
+            pstStats->u16SickTimer  = LIFECYCLE_SICK_TIMEOUT;
+        }
+    }
+
+    if ((0 != pstStage->u32MaxAge) && (pstStage->u32MaxAge <= pstStats->u32Age))
+    {
+        _Die(pstStats);
+        return;
+    }
+
+    if ((0 != pstStage->u32Duration) && (pstStage->u32Duration <= pstStats->u32StageTime))
+    {
+        _Evolve(pstStats);
+    }
+}
+
+/**
+ * @brief   Simulate an elapsed interval (catch-up)
+ * @details Produces exactly the same state as calling
+ *          @ref LifeCycle_Tick once per second, but only simulates the
+ *          seconds in which something discrete happens (poo, calls,
+ *          care mistakes, sickness, sleep schedule, evolution).  The
+ *          quiet seconds in between are applied in closed form, so the
+ *          cost is proportional to the number of events rather than the
+ *          length of the interval.
+ * @param   pstStats
+ *          Pointer to pet statistics
+ * @param   u32Seconds
+ *          Elapsed time in seconds
+ */
+void LifeCycle_Advance(Stats* pstStats, uint32_t u32Seconds)
+{
+    while ((0 < u32Seconds) && (OBAKETCHI != pstStats->eEvolution))
+    {
+        uint32_t u32Quiet;
+
+        // A regular tick re-establishes all flags, e.g. after care
+        // actions or a reset.
+        LifeCycle_Tick(pstStats);
+        u32Seconds--;
+
+        u32Quiet = _SecondsToNextEvent(pstStats) - 1;
+        if (u32Quiet > u32Seconds)
+        {
+            u32Quiet = u32Seconds;
+        }
+
+        _Skip(pstStats, u32Quiet);
+        u32Seconds -= u32Quiet;
+    }
+}
+
+/**
+ * @brief   Get time the life cycle may remain unsimulated
+ * @details Nothing but meters and timers changes linearly until the
+ *          next discrete event, so the statistics do not have to be
+ *          updated before.  Used to let the MCU sleep for as long as
+ *          possible.
+ * @param   pstStats
+ *          Pointer to pet statistics
+ * @return  Seconds until the next event (1 to
+ *          @ref LIFECYCLE_MAX_IDLE_TIME)
+ */
+uint32_t LifeCycle_GetIdleTime(const Stats* pstStats)
+{
+    uint32_t u32Seconds;
+
+    if (OBAKETCHI == pstStats->eEvolution)
+    {
+        return LIFECYCLE_MAX_IDLE_TIME;
+    }
+
+    u32Seconds = _SecondsToNextEvent(pstStats);
+    if (LIFECYCLE_MAX_IDLE_TIME < u32Seconds)
+    {
+        u32Seconds = LIFECYCLE_MAX_IDLE_TIME;
+    }
+
+    return u32Seconds;
+}
+
+/**
+ * @brief Feed pet; refills one heart of the hunger meter
+ * @param pstStats
+ *        Pointer to pet statistics
+ */
+void LifeCycle_Feed(Stats* pstStats)
+{
+    if ((EGG == pstStats->eEvolution) || (OBAKETCHI == pstStats->eEvolution))
+    {
+        return;
+    }
+
+    if ((pstStats->u16Flags >> IS_SLEEPING) & 1)
+    {
+        return;
+    }
+
+    _Refill(&pstStats->u32Hunger);
+}
+
+/**
+ * @brief Play with pet; refills one heart of the happiness meter
+ * @param pstStats
+ *        Pointer to pet statistics
+ */
+void LifeCycle_Play(Stats* pstStats)
+{
+    if ((EGG == pstStats->eEvolution) || (OBAKETCHI == pstStats->eEvolution))
+    {
+        return;
+    }
+
+    if ((pstStats->u16Flags >> IS_SLEEPING) & 1)
+    {
+        return;
+    }
+
+    _Refill(&pstStats->u32Happiness);
+}
+
+/**
+ * @brief Clean up all poos
+ * @param pstStats
+ *        Pointer to pet statistics
+ */
+void LifeCycle_Clean(Stats* pstStats)
+{
+    pstStats->u8Poo         = 0;
+    pstStats->u16DirtTimer  = 0;
+    pstStats->u16Flags     &= ~(1 << HAS_POOPED);
+}
+
+/**
+ * @brief Give medicine; cures sickness
+ * @param pstStats
+ *        Pointer to pet statistics
+ */
+void LifeCycle_Heal(Stats* pstStats)
+{
+    if (! ((pstStats->u16Flags >> IS_SICK) & 1))
+    {
+        return;
+    }
+
+    pstStats->u16SickTimer  = 0;
+    pstStats->u16Flags     &= ~(1 << IS_SICK);
+
+    // Re-arm the dirt timer if the cause has not been removed
+    if (0 != pstStats->u8Poo)
+    {
+        pstStats->u16DirtTimer = LIFECYCLE_DIRT_TIMEOUT;
+    }
+}
+
+/**
+ * @brief Scold pet; increases discipline
+ * @param pstStats
+ *        Pointer to pet statistics
+ */
+void LifeCycle_Scold(Stats* pstStats)
+{
+    if ((EGG == pstStats->eEvolution) || (OBAKETCHI == pstStats->eEvolution))
+    {
+        return;
+    }
+
+    if ((100U - LIFECYCLE_DISCIPLINE_STEP) < pstStats->u8Discipline)
+    {
+        pstStats->u8Discipline = 100U;
+    }
+    else
+    {
+        pstStats->u8Discipline += LIFECYCLE_DISCIPLINE_STEP;
+    }
+}
+
+/**
+ * @brief   Apply care action of a button event
+ * @details
+ *          - A: feed, long press: heal
+ *          - B: play
+ *          - C: clean up, long press: scold
+ *
+ *          Shared by the application and the host replay, so recorded
+ *          button events have the same effect on both.
+ * @note    Input is ignored while the pet sleeps, as the display is
+ *          off then.  Button combinations are not care actions.
+ * @param   pstStats
+ *          Pointer to pet statistics
+ * @param   u8Gesture
+ *          Gesture (@ref ButtonGesture)
+ * @param   u8Buttons
+ *          Buttons involved (BUTTON_A, BUTTON_B, BUTTON_C)
+ */
+void LifeCycle_HandleButton(Stats* pstStats, uint8_t u8Gesture, uint8_t u8Buttons)
+{
+    if ((pstStats->u16Flags >> IS_SLEEPING) & 1)
+    {
+        return;
+    }
+
+    if (BUTTON_COMBO == u8Gesture)
+    {
+        return;
+    }
+
+    switch (u8Buttons)
+    {
+        case BUTTON_A:
+            if (BUTTON_LONG == u8Gesture)
+            {
+                LifeCycle_Heal(pstStats);
+            }
+            else
+            {
+                LifeCycle_Feed(pstStats);
+            }
+            break;
+        case BUTTON_B:
+            LifeCycle_Play(pstStats);
+            break;
+        case BUTTON_C:
+            if (BUTTON_LONG == u8Gesture)
+            {
+                LifeCycle_Scold(pstStats);
+            }
+            else
+            {
+                LifeCycle_Clean(pstStats);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Decrease meter (saturating)
+ * @param pu32Meter
+ *        Pointer to meter
+ * @param u16Rate
+ *        Decay per second, Q16.16
+ */
+static void _Decay(uint32_t* pu32Meter, uint16_t u16Rate)
+{
+    if (u16Rate >= *pu32Meter)
+    {
+        *pu32Meter = 0;
+    }
+    else
+    {
+        *pu32Meter -= u16Rate;
+    }
+}
+
+/**
+ * @brief Decrease meter by several seconds worth of decay (saturating)
+ * @param pu32Meter
+ *        Pointer to meter
+ * @param u16Rate
+ *        Decay per second, Q16.16
+ * @param u32Seconds
+ *        Number of seconds
+ */
+static void _DecayBy(uint32_t* pu32Meter, uint16_t u16Rate, uint32_t u32Seconds)
+{
+    uint64_t u64Decay = (uint64_t)u16Rate * u32Seconds;
+
+    if (u64Decay >= *pu32Meter)
+    {
+        *pu32Meter = 0;
+    }
+    else
+    {
+        *pu32Meter -= (uint32_t)u64Decay;
+    }
+}
+
+/**
+ * @brief Let pet die
+ * @param pstStats
+ *        Pointer to pet statistics
+ */
+static void _Die(Stats* pstStats)
+{
+    pstStats->eEvolution    = OBAKETCHI;
+    pstStats->u32StageTime  = 0;
+    pstStats->u16Flags     &= (1 << HAS_POOPED);
+}
+
+/**
+ * @brief Evolve pet according to care received in current evolution
+ * @param pstStats
+ *        Pointer to pet statistics
+ */
+static void _Evolve(Stats* pstStats)
+{
+    const LifeCycleStage*      pstStage      = &_astStage[pstStats->eEvolution];
+    const LifeCycleTransition* pstTransition = &_astTransition[pstStage->u8Transition];
+    Evolution                  ePrevious     = pstStats->eEvolution;
+
+    for (uint8_t u8Idx = 0; u8Idx < pstStage->u8NumOfTransitions; u8Idx++, pstTransition++)
+    {
+        if ((pstStats->u8StageMistakes <= pstTransition->u8MaxMistakes) &&
+            (pstStats->u8Discipline    <= pstTransition->u8MaxDiscipline))
+        {
+            pstStats->eEvolution = pstTransition->eTo;
+            break;
+        }
+    }
+
+    pstStats->u32StageTime    = 0;
+    pstStats->u8StageMistakes = 0;
+
+    // A freshly hatched pet is hungry and wants attention
+    if (EGG == ePrevious)
+    {
+        pstStats->u32Hunger    = 0;
+        pstStats->u32Happiness = 0;
+    }
+}
+
+/**
+ * @brief  Check if pet is asleep at given time of day
+ * @param  pstStage
+ *         Pointer to evolution properties
+ * @param  u32TimeOfDay
+ *         Seconds since midnight
+ * @return Sleep state
+ * @retval true: Pet sleeps
+ * @retval false: Pet is awake
+ */
+static bool _IsBedtime(const LifeCycleStage* pstStage, uint32_t u32TimeOfDay)
+{
+    uint8_t u8Hour = (uint8_t)(u32TimeOfDay / 3600U);
+
+    if (pstStage->u8Bedtime == pstStage->u8Wakeup)
+    {
+        return false;
+    }
+    else if (pstStage->u8Bedtime < pstStage->u8Wakeup)
+    {
+        return (u8Hour >= pstStage->u8Bedtime) && (u8Hour < pstStage->u8Wakeup);
+    }
+    else
+    {
+        return (u8Hour >= pstStage->u8Bedtime) || (u8Hour < pstStage->u8Wakeup);
+    }
+}
+
+/**
+ * @brief  Check if pet is tired (shortly before bedtime)
+ * @param  pstStage
+ *         Pointer to evolution properties
+ * @param  u32TimeOfDay
+ *         Seconds since midnight
+ * @return Tired state
+ */
+static bool _IsTired(const LifeCycleStage* pstStage, uint32_t u32TimeOfDay)
+{
+    uint32_t u32Bedtime = pstStage->u8Bedtime * 3600UL;
+    uint32_t u32Left;
+
+    if (pstStage->u8Bedtime == pstStage->u8Wakeup)
+    {
+        return false;
+    }
+
+    u32Left = (u32Bedtime + LIFECYCLE_SECONDS_PER_DAY - u32TimeOfDay) % LIFECYCLE_SECONDS_PER_DAY;
+
+    return (0 != u32Left) && (LIFECYCLE_TIRED_WINDOW >= u32Left);
+}
+
+/**
+ * @brief Increase meter by one heart (saturating)
+ * @param pu32Meter
+ *        Pointer to meter
+ */
+static void _Refill(uint32_t* pu32Meter)
+{
+    *pu32Meter += LIFECYCLE_HEART;
+    if (LIFECYCLE_METER_FULL < *pu32Meter)
+    {
+        *pu32Meter = LIFECYCLE_METER_FULL;
+    }
+}
+
+/**
+ * @brief   Get number of seconds until the next discrete event
+ * @details The returned second is the first one in which
+ *          @ref LifeCycle_Tick does more than advancing clocks, meters
+ *          and timers linearly.  Requires the flags to be consistent
+ *          with the current state, i.e. to be called right after a
+ *          tick.
+ * @param   pstStats
+ *          Pointer to pet statistics
+ * @return  Seconds until next event (at least 1)
+ */
+static uint32_t _SecondsToNextEvent(const Stats* pstStats)
+{
+    const LifeCycleStage* pstStage  = &_astStage[pstStats->eEvolution];
+    uint32_t              u32Next   = UINT32_MAX;
+    uint32_t              u32Events[10];
+    uint8_t               u8Count   = 0;
+
+    // Flags still follow the previous evolution's schedule right after
+    // evolving
+    if ((OBAKETCHI == pstStats->eEvolution) || (0 == pstStats->u32StageTime))
+    {
+        return 1;
+    }
+
+    // Sleep schedule
+    if (pstStage->u8Bedtime != pstStage->u8Wakeup)
+    {
+        uint32_t u32Bedtime = pstStage->u8Bedtime * 3600UL;
+
+        u32Events[u8Count++] = _SecondsUntil(pstStats->u32TimeOfDay, u32Bedtime);
+        u32Events[u8Count++] = _SecondsUntil(pstStats->u32TimeOfDay, pstStage->u8Wakeup * 3600UL);
+        u32Events[u8Count++] = _SecondsUntil(
+            pstStats->u32TimeOfDay,
+            (u32Bedtime + LIFECYCLE_SECONDS_PER_DAY - LIFECYCLE_TIRED_WINDOW) % LIFECYCLE_SECONDS_PER_DAY);
+    }
+
+    if (! ((pstStats->u16Flags >> IS_SLEEPING) & 1))
+    {
+        // Empty meter starts a call
+        if ((EGG != pstStats->eEvolution) && (! ((pstStats->u16Flags >> IS_CALLING) & 1)))
+        {
+            if (0 != pstStage->u16HungerRate)
+            {
+                u32Events[u8Count++] = (pstStats->u32Hunger + pstStage->u16HungerRate - 1) / pstStage->u16HungerRate;
+            }
+            if (0 != pstStage->u16HappyRate)
+            {
+                u32Events[u8Count++] = (pstStats->u32Happiness + pstStage->u16HappyRate - 1) / pstStage->u16HappyRate;
+            }
+        }
+
+        if (0 != pstStage->u16PooInterval)
+        {
+            u32Events[u8Count++] = (0 == pstStats->u16PooTimer) ? pstStage->u16PooInterval : pstStats->u16PooTimer;
+        }
+    }
+
+    if ((pstStats->u16Flags >> IS_CALLING) & 1)
+    {
+        if (0 != pstStats->u16CallTimer)
+        {
+            u32Events[u8Count++] = pstStats->u16CallTimer;
+        }
+    }
+
+    if ((pstStats->u16Flags >> IS_SICK) & 1)
+    {
+        u32Events[u8Count++] = pstStats->u16SickTimer;
+    }
+    else if (0 != pstStats->u8Poo)
+    {
+        u32Events[u8Count++] = pstStats->u16DirtTimer;
+    }
+
+    if (0 != pstStage->u32MaxAge)
+    {
+        u32Events[u8Count++] = (pstStage->u32MaxAge > pstStats->u32Age) ? (pstStage->u32MaxAge - pstStats->u32Age) : 1;
+    }
+
+    if (0 != pstStage->u32Duration)
+    {
+        u32Events[u8Count++] = (pstStage->u32Duration > pstStats->u32StageTime) ? (pstStage->u32Duration - pstStats->u32StageTime) : 1;
+    }
+
+    for (uint8_t u8Idx = 0; u8Idx < u8Count; u8Idx++)
+    {
+        if (u32Events[u8Idx] < u32Next)
+        {
+            u32Next = u32Events[u8Idx];
+        }
+    }
+
+    if (0 == u32Next)
+    {
+        u32Next = 1;
+    }
+
+    return u32Next;
+}
+
+/**
+ * @brief  Get number of seconds until the clock reaches a time of day
+ * @param  u32TimeOfDay
+ *         Current seconds since midnight
+ * @param  u32Target
+ *         Target seconds since midnight
+ * @return Seconds until target (1 to one day)
+ */
+static uint32_t _SecondsUntil(uint32_t u32TimeOfDay, uint32_t u32Target)
+{
+    uint32_t u32Seconds = (u32Target + LIFECYCLE_SECONDS_PER_DAY - u32TimeOfDay) % LIFECYCLE_SECONDS_PER_DAY;
+
+    if (0 == u32Seconds)
+    {
+        u32Seconds = LIFECYCLE_SECONDS_PER_DAY;
+    }
+
+    return u32Seconds;
+}
+
+/**
+ * @brief   Apply quiet seconds in closed form
+ * @details Only valid if no event occurs within the interval, see
+ *          @ref _SecondsToNextEvent.
+ * @param   pstStats
+ *          Pointer to pet statistics
+ * @param   u32Seconds
+ *          Number of quiet seconds
+ */
+static void _Skip(Stats* pstStats, uint32_t u32Seconds)
+{
+    const LifeCycleStage* pstStage = &_astStage[pstStats->eEvolution];
+
+    if (0 == u32Seconds)
+    {
+        return;
+    }
+
+    pstStats->u32Age       += u32Seconds;
+    pstStats->u32StageTime += u32Seconds;
+    pstStats->u32TimeOfDay  = (pstStats->u32TimeOfDay + u32Seconds) % LIFECYCLE_SECONDS_PER_DAY;
+
+    if (! ((pstStats->u16Flags >> IS_SLEEPING) & 1))
+    {
+        _DecayBy(&pstStats->u32Hunger,    pstStage->u16HungerRate, u32Seconds);
+        _DecayBy(&pstStats->u32Happiness, pstStage->u16HappyRate,  u32Seconds);
+
+        if (0 != pstStage->u16PooInterval)
+        {
+            if (0 == pstStats->u16PooTimer)
+            {
+                pstStats->u16PooTimer = pstStage->u16PooInterval;
+            }
+            pstStats->u16PooTimer -= (uint16_t)u32Seconds;
+        }
+    }
+
+    if (((pstStats->u16Flags >> IS_CALLING) & 1) && (0 != pstStats->u16CallTimer))
+    {
+        pstStats->u16CallTimer -= (uint16_t)u32Seconds;
+    }
+
+    if ((pstStats->u16Flags >> IS_SICK) & 1)
+    {
+        pstStats->u16SickTimer -= (uint16_t)u32Seconds;
+    }
+    else if (0 != pstStats->u8Poo)
+    {
+        pstStats->u16DirtTimer -= (uint16_t)u32Seconds;
+    }
+}
+
+#ifndef HOST_BUILD
+/**
+ * @brief  Get current time of day from RTC
+ * @return Seconds since midnight
+ */
+static uint32_t _GetTimeOfDay(void)
+{
+    uint8_t u8Hours   = 0;
+    uint8_t u8Minutes = 0;
+    uint8_t u8Seconds = 0;
+
+    RTC_GetTime(&u8Hours, &u8Minutes, &u8Seconds);
+
+    return (u8Hours * 3600UL) + (u8Minutes * 60UL) + u8Seconds;
+}
+
+/**
+ * @brief   Life cycle job
+ * @details Simulates every second elapsed on the RTC since the last
+ *          run, which may be hours after a deep sleep.  Catching up
+ *          loops over every event in the gap, so it runs on a copy of
+ *          the statistics with interrupts enabled.  The copy is only
+ *          committed if nothing else changed the statistics in the
+ *          meantime (see @ref LifeCycle_Care), otherwise the catch-up
+ *          is redone on top of the change.
+ *
+ *          The job only wakes up for the next event (see
+ *          @ref LifeCycle_GetIdleTime), shortly after an RTC second
+ *          boundary, so the MCU can stay in STOP mode in between.
+ * @param   pstJob
+ *          Pointer to job entry
+ * @return  Job state
+ */
+static JobState _LifeCycleJob(Job* pstJob)
+{
+    JOB_BEGIN(pstJob);
+    _stLifeCycle.u32Last = _GetTimeOfDay();
+
+    while (1)
+    {
+        uint32_t u32Now;
+        uint32_t u32Elapsed;
+        uint32_t u32Delay;
+
+        // Skip adjustments of the RTC
+        taskENTER_CRITICAL();
+        u32Now                      = _GetTimeOfDay();
+        _stLifeCycle.u32Last        = (_stLifeCycle.u32Last + _stLifeCycle.u32ClockOffset) % LIFECYCLE_SECONDS_PER_DAY;
+        _stLifeCycle.u32ClockOffset = 0;
+        taskEXIT_CRITICAL();
+
+        u32Elapsed = (u32Now + LIFECYCLE_SECONDS_PER_DAY - _stLifeCycle.u32Last) % LIFECYCLE_SECONDS_PER_DAY;
+
+        if (0 < u32Elapsed)
+        {
+            Stats    stStats;
+            uint32_t u32Revision;
+            bool     bCommitted;
+
+            do
+            {
+                taskENTER_CRITICAL();
+                stStats     = _stLifeCycle.stStats;
+                u32Revision = _stLifeCycle.u32Revision;
+                taskEXIT_CRITICAL();
+
+                LifeCycle_Advance(&stStats, u32Elapsed);
+
+                taskENTER_CRITICAL();
+                bCommitted = (u32Revision == _stLifeCycle.u32Revision);
+                if (bCommitted)
+                {
+                    _stLifeCycle.stStats = stStats;
+                }
+                taskEXIT_CRITICAL();
+            }
+            while (! bCommitted);
+        }
+
+        LifeCycle_Publish();
+
+        _stLifeCycle.u32Last  = u32Now;
+        u32Delay              = LifeCycle_GetIdleTime(&_stLifeCycle.stStats) * 1000U;
+        u32Delay             -= RTC_GetMilliseconds();
+        JOB_DELAY(pstJob, u32Delay + 1);
+    }
+
+    JOB_END(pstJob);
 }
+#endif
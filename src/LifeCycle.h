@@ -5,27 +5,40 @@
  */
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#define LIFECYCLE_HEART      (1UL << 16)            ///< One heart, Q16.16 fixed-point
+#define LIFECYCLE_METER_FULL (4UL * LIFECYCLE_HEART) ///< Full meter (four hearts)
+#define LIFECYCLE_MAX_POO    4                      ///< Maximum number of poos
+
+#define LIFECYCLE_CHANGED_EVOLUTION     (1UL << 0) ///< Evolution has changed
+#define LIFECYCLE_CHANGED_FLAGS         (1UL << 1) ///< Status flags have changed
+#define LIFECYCLE_CHANGED_CARE_MISTAKES (1UL << 2) ///< Number of care mistakes has changed
+#define LIFECYCLE_CHANGED_ALL           (0x07UL)   ///< All fields have changed
+
+#define LIFECYCLE_MAX_IDLE_TIME 60U ///< Max. seconds between two life cycle updates
+
 /**
  * @enum  Evolution
  * @brief Tamago evolutions
  */
 typedef enum
 {
-    EGG = 0,       ///< Egg
-    BABYTCHI,      ///< Baby, from Egg
-    MARUTCHI,      ///< Child, from Babytchi
-    TAMATCHI,      ///< Teen, good care from Marutchi
-    KUCHITAMATCHI, ///< Teen, bad care from Marutchi
-    MAMETCHI,      ///< Adult, perfect care from Tamatchi
-    GINJIROTCHI,   ///< Adult, above average care from Tamatchi
-    MASKUTCHI,     ///< Adult, average care from Tamatchi
-    KUCHIPATCHI,   ///< Adult, below average care from Tamatchi, perfect care from Kuchitamatchi
-    NYOROTCHI,     ///< Adult, bad care from Tamatchi, average care from Kuchitamatchi
-    TARAKOTCHI,    ///< Adult, Horrible care from both
-    OYAJITCHI,     ///< Special, no discipline until it evolves to Maskutchi, perfect care from Maskutchi
-    OBAKETCHI      ///< Dead
+    EGG = 0,          ///< Egg
+    BABYTCHI,         ///< Baby, from Egg
+    MARUTCHI,         ///< Child, from Babytchi
+    TAMATCHI,         ///< Teen, good care from Marutchi
+    KUCHITAMATCHI,    ///< Teen, bad care from Marutchi
+    MAMETCHI,         ///< Adult, perfect care from Tamatchi
+    GINJIROTCHI,      ///< Adult, above average care from Tamatchi
+    MASKUTCHI,        ///< Adult, average care from Tamatchi
+    KUCHIPATCHI,      ///< Adult, below average care from Tamatchi, perfect care from Kuchitamatchi
+    NYOROTCHI,        ///< Adult, bad care from Tamatchi, average care from Kuchitamatchi
+    TARAKOTCHI,       ///< Adult, Horrible care from both
+    OYAJITCHI,        ///< Special, no discipline until it evolves to Maskutchi, perfect care from Maskutchi
+    OBAKETCHI,        ///< Dead
+    NUM_OF_EVOLUTIONS ///< Total number of evolutions
 
 } Evolution;
 
@@ -37,7 +50,8 @@ typedef enum
     HAS_POOPED = 0,
     IS_SICK,
     IS_SLEEPING,
-    IS_TIRED
+    IS_TIRED,
+    IS_CALLING
 
 } StatusFlag;
 
@@ -50,11 +64,42 @@ typedef struct
     uint16_t  u16Flags;        ///< Status flags (bit-field)
     uint16_t  u16CareMistages; ///< Number of care mistakes
     Evolution eEvolution;      ///< Current evolution
+    uint32_t  u32Age;          ///< Age in seconds
+    uint32_t  u32StageTime;    ///< Seconds spent in current evolution
+    uint32_t  u32TimeOfDay;    ///< Seconds since midnight
+    uint32_t  u32Hunger;       ///< Hunger meter, Q16.16 hearts (0: starving)
+    uint32_t  u32Happiness;    ///< Happiness meter, Q16.16 hearts (0: sad)
+    uint16_t  u16PooTimer;     ///< Seconds until next poo
+    uint16_t  u16DirtTimer;    ///< Seconds until uncleaned poo makes sick
+    uint16_t  u16CallTimer;    ///< Seconds until an ignored call is a care mistake
+    uint16_t  u16SickTimer;    ///< Seconds until untreated sickness is fatal
+    uint8_t   u8Poo;           ///< Number of uncleaned poos
+    uint8_t   u8Discipline;    ///< Discipline in percent
+    uint8_t   u8StageMistakes; ///< Care mistakes in current evolution
 
 } Stats;
 
-void   LifeCycle_Init(void);
-Stats* LifeCycle_GetStats(void);
-bool   LifeCycle_IsFlagSet(StatusFlag eFlag);
-void   LifeCycle_ClearFlat(StatusFlag eFlag);
-void   LifeCycle_SetFlag(StatusFlag eFlag);
+int      LifeCycle_Init(void);
+Stats*   LifeCycle_GetStats(void);
+bool     LifeCycle_IsFlagSet(StatusFlag eFlag);
+void     LifeCycle_ClearFlat(StatusFlag eFlag);
+void     LifeCycle_SetFlag(StatusFlag eFlag);
+
+#ifndef HOST_BUILD
+void     LifeCycle_AdjustClock(int32_t s32Seconds);
+void     LifeCycle_Care(uint8_t u8Gesture, uint8_t u8Buttons);
+void     LifeCycle_Publish(void);
+int      LifeCycle_Subscribe(void);
+uint32_t LifeCycle_TakeChanges(uint32_t u32TimeoutInMs);
+#endif
+
+void     LifeCycle_Reset(Stats* pstStats, uint32_t u32TimeOfDay);
+void     LifeCycle_Tick(Stats* pstStats);
+void     LifeCycle_Advance(Stats* pstStats, uint32_t u32Seconds);
+uint32_t LifeCycle_GetIdleTime(const Stats* pstStats);
+void     LifeCycle_Feed(Stats* pstStats);
+void     LifeCycle_Play(Stats* pstStats);
+void     LifeCycle_Clean(Stats* pstStats);
+void     LifeCycle_Heal(Stats* pstStats);
+void     LifeCycle_Scold(Stats* pstStats);
+void     LifeCycle_HandleButton(Stats* pstStats, uint8_t u8Gesture, uint8_t u8Buttons);
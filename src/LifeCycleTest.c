@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      LifeCycleTest.c
+ * @brief     Host test of the life cycle catch-up
+ * @details   Runs random pets through @ref LifeCycle_Advance and, in
+ *            parallel, through one @ref LifeCycle_Tick per second.
+ *            Both copies get the same random care actions at random
+ *            intervals, mostly within minutes and now and then up to
+ *            two days, and are compared after every interval and every
+ *            action.  Fails on the first difference in @ref Stats.
+ * @code{.unparsed}
+ * Usage: program [-n pets] [-s seed]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_LIFECYCLETEST
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "LifeCycle.h"
+
+#define TEST_MAX_DAYS     30UL    ///< Simulation limit per pet in days
+#define TEST_MAX_INTERVAL 172800U ///< Longest interval between two actions in seconds
+
+/**
+ * @enum  TestAction
+ * @brief Care actions, bit positions in the action mask
+ */
+typedef enum
+{
+    TEST_FEED = 0, ///< LifeCycle_Feed()
+    TEST_PLAY,     ///< LifeCycle_Play()
+    TEST_CLEAN,    ///< LifeCycle_Clean()
+    TEST_HEAL,     ///< LifeCycle_Heal()
+    TEST_SCOLD,    ///< LifeCycle_Scold()
+    NUM_OF_TEST_ACTIONS
+
+} TestAction;
+
+static void        _Act(Stats* pstStats, uint8_t u8Actions);
+static const char* _Diff(const Stats* pstA, const Stats* pstB);
+static uint32_t    _Interval(uint64_t* pu64State);
+static uint32_t    _Random(uint64_t* pu64State);
+static bool        _RunPet(uint32_t u32Pet, uint64_t u64Seed);
+
+/**
+ * @brief  Life cycle test entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    uint32_t u32Pets = 200;
+    uint64_t u64Seed = 0x7A6A60ULL;
+    int      nOpt;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "n:s:")))
+    {
+        switch (nOpt)
+        {
+            case 'n':
+                u32Pets = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                u64Seed = strtoull(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n pets] [-s seed]\n", apcArgv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for (uint32_t u32Pet = 0; u32Pet < u32Pets; u32Pet++)
+    {
+        if (! _RunPet(u32Pet, u64Seed))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%u pets: LifeCycle_Advance matches LifeCycle_Tick\n", u32Pets);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Apply care actions
+ * @param pstStats
+ *        Pointer to pet statistics
+ * @param u8Actions
+ *        Care actions, bit n: @ref TestAction n
+ */
+static void _Act(Stats* pstStats, uint8_t u8Actions)
+{
+    for (uint8_t u8Action = 0; u8Action < NUM_OF_TEST_ACTIONS; u8Action++)
+    {
+        if (0 == ((u8Actions >> u8Action) & 1U))
+        {
+            continue;
+        }
+
+        switch ((TestAction)u8Action)
+        {
+            case TEST_FEED:
+                LifeCycle_Feed(pstStats);
+                break;
+            case TEST_PLAY:
+                LifeCycle_Play(pstStats);
+                break;
+            case TEST_CLEAN:
+                LifeCycle_Clean(pstStats);
+                break;
+            case TEST_HEAL:
+                LifeCycle_Heal(pstStats);
+                break;
+            case TEST_SCOLD:
+            default:
+                LifeCycle_Scold(pstStats);
+                break;
+        }
+    }
+}
+
+/**
+ * @brief  Compare pet statistics
+ * @param  pstA
+ *         Pointer to first statistics
+ * @param  pstB
+ *         Pointer to second statistics
+ * @return Name of the first differing field, NULL if equal
+ */
+static const char* _Diff(const Stats* pstA, const Stats* pstB)
+{
+    #define TEST_COMPARE(field)              \
+        if (pstA->field != pstB->field)      \
+        {                                    \
+            return #field;                   \
+        }
+
+    TEST_COMPARE(u16Flags);
+    TEST_COMPARE(u16CareMistages);
+    TEST_COMPARE(eEvolution);
+    TEST_COMPARE(u32Age);
+    TEST_COMPARE(u32StageTime);
+    TEST_COMPARE(u32TimeOfDay);
+    TEST_COMPARE(u32Hunger);
+    TEST_COMPARE(u32Happiness);
+    TEST_COMPARE(u16PooTimer);
+    TEST_COMPARE(u16DirtTimer);
+    TEST_COMPARE(u16CallTimer);
+    TEST_COMPARE(u16SickTimer);
+    TEST_COMPARE(u8Poo);
+    TEST_COMPARE(u8Discipline);
+    TEST_COMPARE(u8StageMistakes);
+
+    #undef TEST_COMPARE
+
+    return NULL;
+}
+
+/**
+ * @brief  Draw interval until the next action
+ * @note   Mostly short intervals, some of them long enough to cover
+ *         sleep, sickness and evolutions unattended.
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return Interval in seconds, at least 1
+ */
+static uint32_t _Interval(uint64_t* pu64State)
+{
+    uint32_t u32Random = _Random(pu64State);
+
+    switch (u32Random % 16U)
+    {
+        case 0:
+            return 1U + ((u32Random >> 8) % TEST_MAX_INTERVAL);
+        case 1:
+        case 2:
+            return 1U + ((u32Random >> 8) % 21600U);
+        case 3:
+        case 4:
+        case 5:
+            return 1U + ((u32Random >> 8) % 3600U);
+        default:
+            return 1U + ((u32Random >> 8) % 900U);
+    }
+}
+
+/**
+ * @brief  xorshift64* pseudo random number generator
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return Random number
+ */
+static uint32_t _Random(uint64_t* pu64State)
+{
+    *pu64State ^= *pu64State >> 12;
+    *pu64State ^= *pu64State << 25;
+    *pu64State ^= *pu64State >> 27;
+
+    return (uint32_t)((*pu64State * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief  Simulate one pet on both paths
+ * @param  u32Pet
+ *         Pet index
+ * @param  u64Seed
+ *         Test seed
+ * @return true: no difference, false: difference found
+ */
+static bool _RunPet(uint32_t u32Pet, uint64_t u64Seed)
+{
+    uint64_t    u64State = (u64Seed ^ ((uint64_t)(u32Pet + 1U) * 0x9E3779B97F4A7C15ULL)) | 1U;
+    uint32_t    u32Time  = 0;
+    Stats       stAdvance;
+    Stats       stTick;
+    const char* pacField;
+
+    LifeCycle_Reset(&stAdvance, _Random(&u64State));
+    LifeCycle_Reset(&stTick, stAdvance.u32TimeOfDay);
+
+    while ((OBAKETCHI != stTick.eEvolution) && (u32Time < (TEST_MAX_DAYS * 86400UL)))
+    {
+        uint32_t u32Seconds = _Interval(&u64State);
+        uint8_t  u8Actions  = (uint8_t)(_Random(&u64State) & ((1U << NUM_OF_TEST_ACTIONS) - 1U));
+
+        LifeCycle_Advance(&stAdvance, u32Seconds);
+        for (uint32_t u32Idx = 0; u32Idx < u32Seconds; u32Idx++)
+        {
+            LifeCycle_Tick(&stTick);
+        }
+        u32Time += u32Seconds;
+
+        pacField = _Diff(&stAdvance, &stTick);
+        if (NULL != pacField)
+        {
+            fprintf(stderr, "Pet %u: %s differs after %u s of catch-up at %u s\n", u32Pet, pacField, u32Seconds, u32Time);
+            return false;
+        }
+
+        _Act(&stAdvance, u8Actions);
+        _Act(&stTick, u8Actions);
+
+        pacField = _Diff(&stAdvance, &stTick);
+        if (NULL != pacField)
+        {
+            fprintf(stderr, "Pet %u: %s differs after actions %02x at %u s\n", u32Pet, pacField, u8Actions, u32Time);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif // USE_LIFECYCLETEST
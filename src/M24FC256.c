@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include "M24FC256.h"
 #include "MCAL.h"
+#include "Profile.h"
 
 /**
  * @brief   Read data from 24FC256 EEPROM
@@ -44,6 +45,8 @@ int M24FC256_Read(uint16_t u16Address, uint8_t *pu8RxBuffer, uint8_t u8Pages)
     int     sRemainingBytes = u8Pages * M24FC256_PAGESIZE;
     int     sMemoryAddress  = 0;
 
+    PROFILE_SCOPE(PROFILE_M24FC256_READ);
+
     if (NULL == pu8RxBuffer)
     {
         return -1;
@@ -91,6 +94,8 @@ int M24FC256_Write(uint16_t u16Address, uint8_t *pu8TxBuffer, uint8_t u8Pages)
     int sRemainingBytes = u8Pages * M24FC256_PAGESIZE;
     int sMemoryAddress  = 0;
 
+    PROFILE_SCOPE(PROFILE_M24FC256_WRITE);
+
     if (NULL == pu8TxBuffer)
     {
         return -1;
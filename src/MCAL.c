@@ -9,19 +9,111 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "FreeRTOS.h"
 #include "MCAL.h"
+#include "semphr.h"
 #include "stm32f1xx_hal.h"
+#include "stm32f1xx_hal_adc.h"
 #include "stm32f1xx_hal_i2c.h"
 #include "stm32f1xx_hal_spi.h"
 #include "stm32f1xx_hal_rtc.h"
 #include "stm32f1xx_hal_tim.h"
+#include "Trace.h"
+#include "task.h"
 
+#ifdef USE_RECORD
+#include "Record.h"
+#endif
+
+#define I2C_READY_POLLS 20U ///< Max. acknowledge polls after a transfer, about 1 ms apart
+
+extern ADC_HandleTypeDef hadc1;
+extern DMA_HandleTypeDef hdma_tim1_up;
 extern I2C_HandleTypeDef hi2c2;
 extern SPI_HandleTypeDef hspi1;
 extern RTC_HandleTypeDef hrtc;
 extern TIM_HandleTypeDef htim1;
+extern TIM_HandleTypeDef htim3;
+
+static volatile uint16_t _u16MicrosecondsHigh; ///< Upper half of the microsecond clock
+static StaticSemaphore_t _stI2CDone;           ///< I²C transfer complete signal storage
+static SemaphoreHandle_t _hI2CDone;            ///< I²C transfer complete signal
 
 static GPIO_TypeDef* _MCAL_ConvertGPIOPort(GPIOPort ePort);
+static uint32_t      _MCAL_GetRTCCounter(uint16_t* pu16Milliseconds);
+static void          _MCAL_PWMComplete(DMA_HandleTypeDef* phDMA);
+static void          _MCAL_RestoreClock(void);
+
+/**
+ * @brief   Start continuous ADC scan
+ * @details The regular group is converted on every TIM3 update (TRGO,
+ *          every 65.536 ms) and written to a circular buffer by DMA;
+ *          the half and full transfer interrupts call
+ *          HAL_ADC_ConvHalfCpltCallback() and HAL_ADC_ConvCpltCallback().
+ *          No CPU time is needed per conversion.
+ * @param   pu16Buffer
+ *          Pointer to buffer; has to stay valid while the scan runs
+ * @param   u16Length
+ *          Buffer length in conversions, a multiple of twice the
+ *          number of ranks
+ * @return  Error code
+ * @retval   0: OK
+ * @retval  -1: Error
+ */
+int ADC_Start(uint16_t* pu16Buffer, uint16_t u16Length)
+{
+    if (HAL_OK != HAL_ADCEx_Calibration_Start(&hadc1))
+    {
+        return -1;
+    }
+
+    if (HAL_OK != HAL_ADC_Start_DMA(&hadc1, (uint32_t*)pu16Buffer, u16Length))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Arm analog watchdog (ADC1 channel 8)
+ * @note  Interrupts on every conversion outside the window, which calls
+ *        HAL_ADC_LevelOutOfWindowCallback(); move the window there.
+ * @param u16Low
+ *        Lower threshold (0 to 4095)
+ * @param u16High
+ *        Upper threshold (0 to 4095)
+ */
+void ADC_SetWatchdog(uint16_t u16Low, uint16_t u16High)
+{
+    __HAL_ADC_DISABLE_IT(&hadc1, ADC_IT_AWD);
+    WRITE_REG(ADC1->LTR, u16Low);
+    WRITE_REG(ADC1->HTR, u16High);
+    __HAL_ADC_CLEAR_FLAG(&hadc1, ADC_FLAG_AWD);
+    __HAL_ADC_ENABLE_IT(&hadc1, ADC_IT_AWD);
+}
+
+/**
+ * @brief Mask external interrupt line(s)
+ * @param u16PinMask
+ *        Pin mask, equals the EXTI line mask
+ */
+void GPIO_DisableInterrupt(uint16_t u16PinMask)
+{
+    CLEAR_BIT(EXTI->IMR, u16PinMask);
+}
+
+/**
+ * @brief Unmask external interrupt line(s)
+ * @note  Edges which occurred while masked are discarded.
+ * @param u16PinMask
+ *        Pin mask, equals the EXTI line mask
+ */
+void GPIO_EnableInterrupt(uint16_t u16PinMask)
+{
+    __HAL_GPIO_EXTI_CLEAR_IT(u16PinMask);
+    SET_BIT(EXTI->IMR, u16PinMask);
+}
 
 /**
  * @brief  Read current input pin state
@@ -174,40 +266,427 @@ int I2C_Transmit(uint16_t u16DevAddress, uint16_t u16MemAddress, I2CMemAddSize e
     return 0;
 }
 
+/**
+ * @brief Signal the end of an I²C transfer
+ * @note  Called from the I²C transfer complete and error callbacks.
+ */
+void I2C_Complete(void)
+{
+    BaseType_t xWoken = pdFALSE;
+
+    if (NULL != _hI2CDone)
+    {
+        xSemaphoreGiveFromISR(_hI2CDone, &xWoken);
+        portYIELD_FROM_ISR(xWoken);
+    }
+}
+
 /**
  * @brief   Wait for the end of the transfer
  * @details Before starting a new communication transfer, the CPU need
  *          to check the current state of the peripheral; if it's busy
  *          the CPU need to wait for the end of current transfer before
- *          starting a new one.
+ *          starting a new one.  Afterwards the device is polled until
+ *          it acknowledges its address, e.g. at the end of an EEPROM
+ *          write cycle.
+ *
+ *          Once the scheduler is running, the calling task is blocked
+ *          on the transfer complete signal (see @ref I2C_Complete) and
+ *          for one tick between two polls, so other tasks may run.  A
+ *          stale signal only costs another check of the state.
  * @param   u16DevAddress
  *          Target device address
  */
 void I2C_WaitUntilReady(uint16_t u16DevAddress)
 {
-    while (HAL_I2C_STATE_READY != HAL_I2C_GetState(&hi2c2));
+    bool bBlock = (taskSCHEDULER_RUNNING == xTaskGetSchedulerState());
 
-    while (HAL_TIMEOUT == HAL_I2C_IsDeviceReady(
-               &hi2c2,
-               u16DevAddress,
-               100,
-               100));
+    TRACE_BEGIN(TRACE_MARK_I2C_WAIT);
+
+    if (bBlock && (NULL == _hI2CDone))
+    {
+        _hI2CDone = xSemaphoreCreateBinaryStatic(&_stI2CDone);
+    }
 
     while (HAL_I2C_STATE_READY != HAL_I2C_GetState(&hi2c2))
     {
-        MCAL_Sleep(1);
+        if (bBlock)
+        {
+            xSemaphoreTake(_hI2CDone, 1);
+        }
+    }
+
+    for (uint8_t u8Poll = 0; u8Poll < I2C_READY_POLLS; u8Poll++)
+    {
+        if (HAL_OK == HAL_I2C_IsDeviceReady(&hi2c2, u16DevAddress, 1, 1))
+        {
+            break;
+        }
+
+        if (bBlock)
+        {
+            vTaskDelay(1);
+        }
+        else
+        {
+            MCAL_Sleep(1000);
+        }
     }
+
+    TRACE_END(TRACE_MARK_I2C_WAIT);
+}
+
+/**
+ * @brief Halt CPU until the next interrupt (SLEEP mode)
+ */
+void MCAL_EnterSleep(void)
+{
+    HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+}
+
+/**
+ * @brief   Enter STOP mode until an RTC second boundary
+ * @details Suspends the SysTick and the HAL tick and programs the RTC
+ *          alarm to the last second boundary within the given time.
+ *          After wake-up (alarm or any other EXTI event), the system
+ *          clock is restored and the elapsed time, measured with the
+ *          RTC, is added to the HAL tick.  Has to be called with
+ *          interrupts disabled (PRIMASK).
+ * @param   u32MaxInMs
+ *          Maximum time to stay in STOP mode in ms
+ * @return  Time spent in STOP mode in ms, 0 if no second boundary is
+ *          within the given time and STOP mode was not entered
+ */
+uint32_t MCAL_EnterStop(uint32_t u32MaxInMs)
+{
+    uint16_t u16StartMs;
+    uint16_t u16EndMs;
+    uint32_t u32Start;
+    uint32_t u32Seconds;
+    uint32_t u32Elapsed;
+
+    u32Start   = _MCAL_GetRTCCounter(&u16StartMs);
+    u32Seconds = (u16StartMs + u32MaxInMs) / 1000U;
+    if (0 == u32Seconds)
+    {
+        return 0;
+    }
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    HAL_SuspendTick();
+
+    // Program alarm; the RTC has to be in configuration mode
+    while (0 == (RTC->CRL & RTC_CRL_RTOFF));
+    __HAL_RTC_WRITEPROTECTION_DISABLE(&hrtc);
+    WRITE_REG(RTC->ALRH, (u32Start + u32Seconds) >> 16);
+    WRITE_REG(RTC->ALRL, (u32Start + u32Seconds) & RTC_ALRL_RTC_ALR);
+    __HAL_RTC_WRITEPROTECTION_ENABLE(&hrtc);
+    while (0 == (RTC->CRL & RTC_CRL_RTOFF));
+
+    __HAL_RTC_ALARM_CLEAR_FLAG(&hrtc, RTC_FLAG_ALRAF);
+    __HAL_RTC_ALARM_EXTI_CLEAR_FLAG();
+    __HAL_RTC_ALARM_EXTI_ENABLE_IT();
+    __HAL_RTC_ALARM_EXTI_ENABLE_RISING_EDGE();
+    __HAL_RTC_ALARM_ENABLE_IT(&hrtc, RTC_IT_ALRA);
+
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    _MCAL_RestoreClock();
+
+    __HAL_RTC_ALARM_DISABLE_IT(&hrtc, RTC_IT_ALRA);
+    __HAL_RTC_ALARM_CLEAR_FLAG(&hrtc, RTC_FLAG_ALRAF);
+    __HAL_RTC_ALARM_EXTI_CLEAR_FLAG();
+    HAL_NVIC_ClearPendingIRQ(RTC_Alarm_IRQn);
+
+    u32Elapsed  = (_MCAL_GetRTCCounter(&u16EndMs) - u32Start) * 1000U;
+    u32Elapsed += u16EndMs;
+    u32Elapsed -= u16StartMs;
+    if (u32Elapsed > u32MaxInMs)
+    {
+        u32Elapsed = u32MaxInMs;
+    }
+
+    uwTick += u32Elapsed;
+    HAL_ResumeTick();
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    return u32Elapsed;
+}
+
+/**
+ * @brief   Get input capture time stamp (TIM3 channel 1, PB4)
+ * @details Returns the last captured edge and arms the capture for the
+ *          edge opposite to the current pin level; the inputs only
+ *          capture either rising or falling edges.
+ * @note    Call from the TIM3 capture interrupt.
+ * @param   pbRising
+ *          Set if a rising edge has been captured
+ * @return  Time stamp on the microsecond clock
+ */
+uint32_t MCAL_GetCapture(bool* pbRising)
+{
+    uint16_t u16Capture = (uint16_t)HAL_TIM_ReadCapturedValue(&htim3, TIM_CHANNEL_1);
+    uint32_t u32Now     = MCAL_GetMicroseconds();
+
+    *pbRising = (0 == READ_BIT(TIM3->CCER, TIM_CCER_CC1P));
+
+    if (GPIO_PIN_SET == HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_4))
+    {
+        SET_BIT(TIM3->CCER, TIM_CCER_CC1P);
+    }
+    else
+    {
+        CLEAR_BIT(TIM3->CCER, TIM_CCER_CC1P);
+    }
+
+    // The capture lies less than one counter period in the past
+    return u32Now - (uint16_t)((uint16_t)u32Now - u16Capture);
+}
+
+/**
+ * @brief   Get microsecond clock
+ * @details TIM3 counts at 1 MHz; its overflows are counted in
+ *          @ref MCAL_IncMicroseconds.  Safe to call with interrupts
+ *          disabled, a pending overflow is taken into account.  The
+ *          clock stands still in STOP mode.
+ * @return  Microseconds since start-up (wraps after approx. 71 min)
+ */
+uint32_t MCAL_GetMicroseconds(void)
+{
+    uint16_t u16High;
+    uint16_t u16Low;
+    bool     bPending;
+
+    // Retry if the overflow interrupt was serviced in between
+    do
+    {
+        u16High  = _u16MicrosecondsHigh;
+        u16Low   = (uint16_t)__HAL_TIM_GET_COUNTER(&htim3);
+        bPending = (RESET != __HAL_TIM_GET_FLAG(&htim3, TIM_FLAG_UPDATE));
+    }
+    while (u16High != _u16MicrosecondsHigh);
+
+    // Overflow not serviced yet, e.g. interrupts are disabled
+    if (bPending && (0x8000U > u16Low))
+    {
+        u16High++;
+    }
+
+    return ((uint32_t)u16High << 16) | u16Low;
+}
+
+/**
+ * @brief  Get system tick
+ * @return Milliseconds since start-up
+ */
+uint32_t MCAL_GetTick(void)
+{
+    return HAL_GetTick();
+}
+
+/**
+ * @brief Count microsecond clock overflow
+ * @note  Called from the TIM3 update interrupt.
+ */
+void MCAL_IncMicroseconds(void)
+{
+    _u16MicrosecondsHigh++;
 }
 
 /**
  * @brief Microsecond delay (blocking)
+ * @note  Busy-waits on the microsecond clock (TIM3).
  * @param u16DelayInUs
  *        Delay in microseconds
  */
 void MCAL_Sleep(uint16_t u16DelayInUs)
 {
-    __HAL_TIM_SET_COUNTER(&htim1, 0);
-    while (u16DelayInUs > __HAL_TIM_GET_COUNTER(&htim1));
+    uint16_t u16Start = (uint16_t)__HAL_TIM_GET_COUNTER(&htim3);
+
+    while (u16DelayInUs > (uint16_t)(__HAL_TIM_GET_COUNTER(&htim3) - u16Start));
+}
+
+/**
+ * @brief   Arm timer service alarm (TIM3 channel 4)
+ * @details The compare interrupt sets the timer service software
+ *          interrupt pending.  Only the lower 16 bits of the deadline
+ *          are compared, so a deadline further away matches early; a
+ *          deadline which has already passed is signalled at once.
+ * @param   u32Deadline
+ *          Deadline in µs (@ref MCAL_GetMicroseconds)
+ */
+void MCAL_StartAlarm(uint32_t u32Deadline)
+{
+    __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_CC4);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, (uint16_t)u32Deadline);
+    __HAL_TIM_CLEAR_IT(&htim3, TIM_IT_CC4);
+    __HAL_TIM_ENABLE_IT(&htim3, TIM_IT_CC4);
+
+    // The compare may have matched before the flag was cleared
+    if (0 >= (int32_t)(u32Deadline - MCAL_GetMicroseconds()))
+    {
+        HAL_NVIC_SetPendingIRQ(TIM2_IRQn);
+    }
+}
+
+/**
+ * @brief Start one-shot blanking timer (TIM3 channel 2)
+ * @note  Re-arming replaces a running timeout.  When it elapses, the
+ *        display rows are switched off.
+ * @param u16DelayInUs
+ *        Delay in microseconds
+ */
+void MCAL_StartBlanking(uint16_t u16DelayInUs)
+{
+    __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_CC2);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, (uint16_t)(__HAL_TIM_GET_COUNTER(&htim3) + u16DelayInUs));
+    __HAL_TIM_CLEAR_IT(&htim3, TIM_IT_CC2);
+    __HAL_TIM_ENABLE_IT(&htim3, TIM_IT_CC2);
+}
+
+/**
+ * @brief Start input capture on TIM3 channel 1 (PB4)
+ */
+void MCAL_StartCapture(void)
+{
+    if (GPIO_PIN_SET == HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_4))
+    {
+        SET_BIT(TIM3->CCER, TIM_CCER_CC1P);
+    }
+
+    HAL_TIM_IC_Start_IT(&htim3, TIM_CHANNEL_1);
+}
+
+/**
+ * @brief Start one-shot debounce timer (TIM3 channel 3)
+ * @note  Re-arming replaces a running timeout.  When it elapses, the
+ *        button interrupt is set pending.
+ * @param u16DelayInUs
+ *        Delay in microseconds
+ */
+void MCAL_StartDebounce(uint16_t u16DelayInUs)
+{
+    __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_CC3);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, (uint16_t)(__HAL_TIM_GET_COUNTER(&htim3) + u16DelayInUs));
+    __HAL_TIM_CLEAR_IT(&htim3, TIM_IT_CC3);
+    __HAL_TIM_ENABLE_IT(&htim3, TIM_IT_CC3);
+}
+
+/**
+ * @brief   Emit latch pulse on TIM2 channel 4 (PA3)
+ * @details The timer runs in one-pulse mode and stops by itself; the
+ *          rising edge follows one timer clock after the start, the
+ *          pulse width is set in System_TIM2_Init().  Returns once the
+ *          timer has been started.
+ */
+void MCAL_StartLatch(void)
+{
+    SET_BIT(TIM2->CR1, TIM_CR1_CEN);
+    __DSB();
+}
+
+/**
+ * @brief Disarm timer service alarm (TIM3 channel 4)
+ */
+void MCAL_StopAlarm(void)
+{
+    __HAL_TIM_DISABLE_IT(&htim3, TIM_IT_CC4);
+}
+
+/**
+ * @brief  Check if a PWM sequence is being played
+ * @return Boolean state
+ * @retval true: Sequence is running
+ * @retval false: Output is idle
+ */
+bool PWM_IsRunning(void)
+{
+    return (0 != READ_BIT(TIM1->CR1, TIM_CR1_CEN));
+}
+
+/**
+ * @brief   Play PWM sequence on TIM1 channel 1 (PA8)
+ * @details Every entry consists of four half-words which are written
+ *          to PSC, ARR, RCR and CCR1 by a DMA burst on each update
+ *          event.  An entry therefore lasts RCR + 1 periods of
+ *          (PSC + 1) * (ARR + 1) timer clock cycles.  All registers are
+ *          preloaded: the burst at the start of an entry fetches the
+ *          next one.  When the DMA transfer is complete, the timer is
+ *          switched to one-pulse mode and stops at the end of the
+ *          second to last entry; the last entry only sets the idle
+ *          state of the output.  No CPU time is needed in between.
+ * @param   pu16Burst
+ *          Pointer to the entries; has to stay valid during playback
+ * @param   u16Entries
+ *          Number of entries including the final one, at least 2
+ * @return  Error code
+ * @retval   0: OK
+ * @retval  -1: Error
+ */
+int PWM_Start(const uint16_t* pu16Burst, uint16_t u16Entries)
+{
+    PWM_Stop();
+
+    if (2 > u16Entries)
+    {
+        return -1;
+    }
+
+    WRITE_REG(TIM1->PSC,  pu16Burst[0]);
+    WRITE_REG(TIM1->ARR,  pu16Burst[1]);
+    WRITE_REG(TIM1->RCR,  pu16Burst[2]);
+    WRITE_REG(TIM1->CCR1, pu16Burst[3]);
+
+    hdma_tim1_up.XferCpltCallback = _MCAL_PWMComplete;
+
+    if (HAL_OK != HAL_DMA_Start_IT(
+            &hdma_tim1_up,
+            (uint32_t)&pu16Burst[4],
+            (uint32_t)&TIM1->DMAR,
+            (uint32_t)(u16Entries - 1U) * 4U))
+    {
+        return -1;
+    }
+
+    __HAL_TIM_ENABLE_DMA(&htim1, TIM_DMA_UPDATE);
+
+    // Load the first entry; the update event requests the second one
+    WRITE_REG(TIM1->EGR, TIM_EGR_UG);
+    SET_BIT(TIM1->CCER, TIM_CCER_CC1E);
+    __HAL_TIM_MOE_ENABLE(&htim1);
+    SET_BIT(TIM1->CR1, TIM_CR1_CEN);
+
+    return 0;
+}
+
+/**
+ * @brief Stop PWM sequence and pull the output low
+ */
+void PWM_Stop(void)
+{
+    CLEAR_BIT(TIM1->CR1, TIM_CR1_CEN | TIM_CR1_OPM);
+    __HAL_TIM_DISABLE_DMA(&htim1, TIM_DMA_UPDATE);
+
+    if (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(&hdma_tim1_up))
+    {
+        HAL_DMA_Abort(&hdma_tim1_up);
+    }
+
+    WRITE_REG(TIM1->CCR1, 0);
+    WRITE_REG(TIM1->EGR, TIM_EGR_UG);
+}
+
+/**
+ * @brief  Get milliseconds elapsed in the current RTC second
+ * @return Milliseconds (0 to 999)
+ */
+uint16_t RTC_GetMilliseconds(void)
+{
+    uint16_t u16Milliseconds;
+
+    _MCAL_GetRTCCounter(&u16Milliseconds);
+
+    return u16Milliseconds;
 }
 
 /**
@@ -235,6 +714,10 @@ int RTC_GetTime(uint8_t* pu8Hours, uint8_t* pu8Minutes, uint8_t* pu8Seconds)
     *pu8Minutes = stTime.Minutes;
     *pu8Seconds = stTime.Seconds;
 
+    #ifdef USE_RECORD
+    Record_Time((stTime.Hours * 3600UL) + (stTime.Minutes * 60UL) + stTime.Seconds);
+    #endif
+
     return 0;
 }
 
@@ -328,6 +811,15 @@ int SPI_TransmitReceive(uint8_t* pu8TxData, uint8_t* pu8RxData, uint16_t u16Size
     return 0;
 }
 
+/**
+ * @brief Wait for the end of the SPI transfer
+ * @note  Busy-waits; the transfers are interrupt driven.
+ */
+void SPI_WaitUntilReady(void)
+{
+    while (HAL_SPI_STATE_READY != HAL_SPI_GetState(&hspi1));
+}
+
 /**
  * @brief  Convert GPIOPort to STM32_HAL's GPIO_TypeDef
  * @param  ePort
@@ -356,3 +848,58 @@ static GPIO_TypeDef* _MCAL_ConvertGPIOPort(GPIOPort ePort)
 
     return phPort;
 }
+
+/**
+ * @brief  Read RTC counter and prescaler divider consistently
+ * @param  pu16Milliseconds
+ *         Pointer to milliseconds elapsed in the current second
+ * @return RTC counter in seconds
+ */
+static uint32_t _MCAL_GetRTCCounter(uint16_t* pu16Milliseconds)
+{
+    uint32_t u32Counter;
+    uint32_t u32Divider;
+    uint32_t u32Prescaler = ((RTC->PRLH & RTC_PRLH_PRL) << 16) | RTC->PRLL;
+
+    // The divider may reload between the reads
+    do
+    {
+        u32Counter = (RTC->CNTH << 16) | RTC->CNTL;
+        u32Divider = ((RTC->DIVH & RTC_DIVH_RTC_DIV) << 16) | RTC->DIVL;
+    }
+    while (u32Counter != ((RTC->CNTH << 16) | RTC->CNTL));
+
+    *pu16Milliseconds = (uint16_t)(((u32Prescaler - u32Divider) * 1000U) / (u32Prescaler + 1U));
+
+    return u32Counter;
+}
+
+/**
+ * @brief PWM sequence DMA transfer complete callback
+ * @note  The last entry has been fetched; stop the timer at the end of
+ *        the current one.
+ * @param phDMA
+ *        DMA handle
+ */
+static void _MCAL_PWMComplete(DMA_HandleTypeDef* phDMA)
+{
+    __HAL_TIM_DISABLE_DMA(&htim1, TIM_DMA_UPDATE);
+    SET_BIT(TIM1->CR1, TIM_CR1_OPM);
+}
+
+/**
+ * @brief Restore system clock after STOP mode (HSE, PLL)
+ * @note  The MCU wakes up on the HSI; the PLL configuration is
+ *        retained.
+ */
+static void _MCAL_RestoreClock(void)
+{
+    __HAL_RCC_HSE_CONFIG(RCC_HSE_ON);
+    while (RESET == __HAL_RCC_GET_FLAG(RCC_FLAG_HSERDY));
+
+    __HAL_RCC_PLL_ENABLE();
+    while (RESET == __HAL_RCC_GET_FLAG(RCC_FLAG_PLLRDY));
+
+    __HAL_RCC_SYSCLK_CONFIG(RCC_SYSCLKSOURCE_PLLCLK);
+    while (RCC_SYSCLKSOURCE_STATUS_PLLCLK != __HAL_RCC_GET_SYSCLK_SOURCE());
+}
@@ -8,7 +8,27 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+
+#ifndef HOST_BUILD
 #include "stm32f1xx_hal.h"
+#else
+#define GPIO_PIN_0  ((uint16_t)0x0001) ///< Pin 0 selected
+#define GPIO_PIN_1  ((uint16_t)0x0002) ///< Pin 1 selected
+#define GPIO_PIN_2  ((uint16_t)0x0004) ///< Pin 2 selected
+#define GPIO_PIN_3  ((uint16_t)0x0008) ///< Pin 3 selected
+#define GPIO_PIN_4  ((uint16_t)0x0010) ///< Pin 4 selected
+#define GPIO_PIN_5  ((uint16_t)0x0020) ///< Pin 5 selected
+#define GPIO_PIN_6  ((uint16_t)0x0040) ///< Pin 6 selected
+#define GPIO_PIN_7  ((uint16_t)0x0080) ///< Pin 7 selected
+#define GPIO_PIN_8  ((uint16_t)0x0100) ///< Pin 8 selected
+#define GPIO_PIN_9  ((uint16_t)0x0200) ///< Pin 9 selected
+#define GPIO_PIN_10 ((uint16_t)0x0400) ///< Pin 10 selected
+#define GPIO_PIN_11 ((uint16_t)0x0800) ///< Pin 11 selected
+#define GPIO_PIN_12 ((uint16_t)0x1000) ///< Pin 12 selected
+#define GPIO_PIN_13 ((uint16_t)0x2000) ///< Pin 13 selected
+#define GPIO_PIN_14 ((uint16_t)0x4000) ///< Pin 14 selected
+#define GPIO_PIN_15 ((uint16_t)0x8000) ///< Pin 15 selected
+#endif
 
 /**
  * @enum  GPIOPort
@@ -34,16 +54,136 @@ typedef enum
 
 } I2CMemAddSize;
 
-bool GPIO_IsSet(GPIOPort ePort, uint16_t u16PinMask);
-void GPIO_PullDown(GPIOPort ePort, uint16_t u16PinMask);
-void GPIO_RaiseHigh(GPIOPort ePort, uint16_t u16PinMask);
-void GPIO_Toggle(GPIOPort ePort, uint16_t u16PinMask);
-int  I2C_Receive(uint16_t u16DevAddress, uint16_t u16MemAddress, I2CMemAddSize eMemAddSize, uint8_t* pu8RxBuffer, uint16_t u16Size);
-int  I2C_Transmit(uint16_t u16DevAddress, uint16_t u16MemAddress, I2CMemAddSize eMemAddSize, uint8_t* pu8TxBuffer, uint16_t u16Size);
-void I2C_WaitUntilReady(uint16_t u16DevAddress);
-void MCAL_Sleep(uint16_t u16DelayInUs);
-int  RTC_GetTime(uint8_t* pu8Hours, uint8_t* pu8Minutes, uint8_t* pu8Seconds);
-int  RTC_SetTime(uint8_t u8Hours, uint8_t u8Minutes, uint8_t u8Seconds);
-int  SPI_Transmit(uint8_t* pu8TxData, uint16_t u16Size);
-int  SPI_Receive(uint8_t* pu8RxData, uint16_t u16Size);
-int  SPI_TransmitReceive(uint8_t* pu8TxData, uint8_t* pu8RxData, uint16_t u16Size);
+#ifndef HOST_BUILD
+/**
+ * @brief Register block of a GPIO port
+ * @note  Ports A to D are 0x400 apart, so a constant port resolves to a
+ *        constant address.
+ */
+#define GPIO_FAST_PORT(ePort) ((GPIO_TypeDef*)(GPIOA_BASE + (0x400UL * (uint32_t)(ePort))))
+
+/**
+ * @brief Bit-band alias of a bit in SRAM
+ * @note  Each word of the alias region maps to one bit; a store to it
+ *        is a single atomic bus write which changes only that bit.
+ */
+#define SRAM_BITBAND(pvByte, u8Bit) \
+    ((volatile uint32_t*)(SRAM_BB_BASE + (((uint32_t)(pvByte) - SRAM_BASE) << 5) + ((uint32_t)(u8Bit) << 2)))
+#else
+extern uint16_t au16HostPort[GPIO_PORT_D + 1];
+#endif
+
+/**
+ * @brief Pull output pin(s) low
+ * @note  Inline variant of @ref GPIO_PullDown; with constant arguments
+ *        it compiles to a single store to BRR.
+ * @param ePort
+ *        GPIO port
+ * @param u16PinMask
+ *        Pin mask
+ */
+static inline void GPIO_FastPullDown(GPIOPort ePort, uint16_t u16PinMask)
+{
+#ifndef HOST_BUILD
+    GPIO_FAST_PORT(ePort)->BRR = u16PinMask;
+#else
+    au16HostPort[ePort] &= (uint16_t)~u16PinMask;
+#endif
+}
+
+/**
+ * @brief Raise output pin(s) high
+ * @note  Inline variant of @ref GPIO_RaiseHigh; with constant arguments
+ *        it compiles to a single store to BSRR.
+ * @param ePort
+ *        GPIO port
+ * @param u16PinMask
+ *        Pin mask
+ */
+static inline void GPIO_FastRaiseHigh(GPIOPort ePort, uint16_t u16PinMask)
+{
+#ifndef HOST_BUILD
+    GPIO_FAST_PORT(ePort)->BSRR = u16PinMask;
+#else
+    au16HostPort[ePort] |= u16PinMask;
+#endif
+}
+
+/**
+ * @brief Set and reset output pins in a single store
+ * @note  Atomic, the pins change at the same time.  Set wins if a pin
+ *        is in both masks.
+ * @param ePort
+ *        GPIO port
+ * @param u16SetMask
+ *        Pins to be raised high
+ * @param u16ResetMask
+ *        Pins to be pulled low
+ */
+static inline void GPIO_FastSetReset(GPIOPort ePort, uint16_t u16SetMask, uint16_t u16ResetMask)
+{
+#ifndef HOST_BUILD
+    GPIO_FAST_PORT(ePort)->BSRR = ((uint32_t)u16ResetMask << 16) | u16SetMask;
+#else
+    au16HostPort[ePort] = (uint16_t)((au16HostPort[ePort] & ~u16ResetMask) | u16SetMask);
+#endif
+}
+
+/**
+ * @brief  Read current pin state
+ * @note   Inline variant of @ref GPIO_IsSet.
+ * @param  ePort
+ *         GPIO port
+ * @param  u16PinMask
+ *         Pin mask
+ * @return Boolean state, true if any of the pins is high
+ */
+static inline bool GPIO_FastIsSet(GPIOPort ePort, uint16_t u16PinMask)
+{
+#ifndef HOST_BUILD
+    return (0 != (GPIO_FAST_PORT(ePort)->IDR & u16PinMask));
+#else
+    return (0 != (au16HostPort[ePort] & u16PinMask));
+#endif
+}
+
+int      ADC_Start(uint16_t* pu16Buffer, uint16_t u16Length);
+void     ADC_SetWatchdog(uint16_t u16Low, uint16_t u16High);
+void     GPIO_DisableInterrupt(uint16_t u16PinMask);
+void     GPIO_EnableInterrupt(uint16_t u16PinMask);
+bool     GPIO_IsSet(GPIOPort ePort, uint16_t u16PinMask);
+void     GPIO_PullDown(GPIOPort ePort, uint16_t u16PinMask);
+void     GPIO_RaiseHigh(GPIOPort ePort, uint16_t u16PinMask);
+void     GPIO_Toggle(GPIOPort ePort, uint16_t u16PinMask);
+void     I2C_Complete(void);
+int      I2C_Receive(uint16_t u16DevAddress, uint16_t u16MemAddress, I2CMemAddSize eMemAddSize, uint8_t* pu8RxBuffer, uint16_t u16Size);
+int      I2C_Transmit(uint16_t u16DevAddress, uint16_t u16MemAddress, I2CMemAddSize eMemAddSize, uint8_t* pu8TxBuffer, uint16_t u16Size);
+void     I2C_WaitUntilReady(uint16_t u16DevAddress);
+void     MCAL_EnterSleep(void);
+uint32_t MCAL_EnterStop(uint32_t u32MaxInMs);
+uint32_t MCAL_GetCapture(bool* pbRising);
+uint32_t MCAL_GetMicroseconds(void);
+uint32_t MCAL_GetTick(void);
+void     MCAL_IncMicroseconds(void);
+void     MCAL_Sleep(uint16_t u16DelayInUs);
+void     MCAL_StartAlarm(uint32_t u32Deadline);
+void     MCAL_StartBlanking(uint16_t u16DelayInUs);
+void     MCAL_StartCapture(void);
+void     MCAL_StartDebounce(uint16_t u16DelayInUs);
+void     MCAL_StartLatch(void);
+void     MCAL_StopAlarm(void);
+bool     PWM_IsRunning(void);
+int      PWM_Start(const uint16_t* pu16Burst, uint16_t u16Entries);
+void     PWM_Stop(void);
+uint16_t RTC_GetMilliseconds(void);
+int      RTC_GetTime(uint8_t* pu8Hours, uint8_t* pu8Minutes, uint8_t* pu8Seconds);
+int      RTC_SetTime(uint8_t u8Hours, uint8_t u8Minutes, uint8_t u8Seconds);
+int      SPI_Transmit(uint8_t* pu8TxData, uint16_t u16Size);
+int      SPI_Receive(uint8_t* pu8RxData, uint16_t u16Size);
+int      SPI_TransmitReceive(uint8_t* pu8TxData, uint8_t* pu8RxData, uint16_t u16Size);
+void     SPI_WaitUntilReady(void);
+
+#ifdef HOST_BUILD
+void     MCAL_HostSetTick(uint32_t u32Tick);
+void     MCAL_HostSetTime(uint32_t u32Seconds);
+#endif
@@ -0,0 +1,401 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      MCAL_Host.c
+ * @brief     Microcontroller Abstraction Layer
+ * @details   MCAL for host builds (HOST_BUILD).  Pins, RTC and system
+ *            tick are simulated; time only advances when the host tool
+ *            sets it, so runs are deterministic and as fast as the CPU
+ *            allows.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef HOST_BUILD
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "MCAL.h"
+
+/**
+ * @struct MCALHostData
+ * @brief  Simulated peripherals
+ */
+typedef struct
+{
+    uint32_t u32Tick; ///< Virtual system tick in ms
+    uint32_t u32Time; ///< Virtual RTC, seconds since midnight
+
+} MCALHostData;
+
+/**
+ * @var   _stHost
+ * @brief Simulated peripherals
+ */
+static MCALHostData _stHost = { 0 };
+
+/**
+ * @var   au16HostPort
+ * @brief Simulated output data registers
+ * @note  Shared with the inline GPIO functions in MCAL.h.
+ */
+uint16_t au16HostPort[GPIO_PORT_D + 1] = { 0 };
+
+/**
+ * @brief  Start continuous ADC scan; not supported on the host
+ * @return Error code (always -1)
+ */
+int ADC_Start(uint16_t* pu16Buffer, uint16_t u16Length)
+{
+    return -1;
+}
+
+/**
+ * @brief Arm analog watchdog; not supported on the host
+ */
+void ADC_SetWatchdog(uint16_t u16Low, uint16_t u16High)
+{
+}
+
+/**
+ * @brief Mask external interrupt line(s); nothing to do on the host
+ */
+void GPIO_DisableInterrupt(uint16_t u16PinMask)
+{
+}
+
+/**
+ * @brief Unmask external interrupt line(s); nothing to do on the host
+ */
+void GPIO_EnableInterrupt(uint16_t u16PinMask)
+{
+}
+
+/**
+ * @brief  Read current pin state
+ * @param  ePort
+ *         GPIO port
+ * @param  u16PinMask
+ *         Pin mask
+ * @return Boolean state
+ */
+bool GPIO_IsSet(GPIOPort ePort, uint16_t u16PinMask)
+{
+    return (0 != (au16HostPort[ePort] & u16PinMask));
+}
+
+/**
+ * @brief Pull output pin(s) low
+ * @param ePort
+ *        GPIO port
+ * @param u16PinMask
+ *        Pin mask
+ */
+void GPIO_PullDown(GPIOPort ePort, uint16_t u16PinMask)
+{
+    au16HostPort[ePort] &= ~u16PinMask;
+}
+
+/**
+ * @brief Raise output pin(s) high
+ * @param ePort
+ *        GPIO port
+ * @param u16PinMask
+ *        Pin mask
+ */
+void GPIO_RaiseHigh(GPIOPort ePort, uint16_t u16PinMask)
+{
+    au16HostPort[ePort] |= u16PinMask;
+}
+
+/**
+ * @brief Toggle output pin(s) between high and low
+ * @param ePort
+ *        GPIO port
+ * @param u16PinMask
+ *        Pin mask
+ */
+void GPIO_Toggle(GPIOPort ePort, uint16_t u16PinMask)
+{
+    au16HostPort[ePort] ^= u16PinMask;
+}
+
+/**
+ * @brief Signal the end of an I²C transfer; nothing to do on the host
+ */
+void I2C_Complete(void)
+{
+}
+
+/**
+ * @brief  Receive an amount via I²C
+ * @return Error code
+ * @retval -1: Error, there is no I²C bus on the host
+ */
+int I2C_Receive(uint16_t u16DevAddress, uint16_t u16MemAddress, I2CMemAddSize eMemAddSize, uint8_t* pu8RxBuffer, uint16_t u16Size)
+{
+    return -1;
+}
+
+/**
+ * @brief  Transmit an amount via I²C
+ * @return Error code
+ * @retval -1: Error, there is no I²C bus on the host
+ */
+int I2C_Transmit(uint16_t u16DevAddress, uint16_t u16MemAddress, I2CMemAddSize eMemAddSize, uint8_t* pu8TxBuffer, uint16_t u16Size)
+{
+    return -1;
+}
+
+/**
+ * @brief Wait for the end of the transfer
+ */
+void I2C_WaitUntilReady(uint16_t u16DevAddress)
+{
+}
+
+/**
+ * @brief Halt CPU until the next interrupt; nothing to do on the host
+ */
+void MCAL_EnterSleep(void)
+{
+}
+
+/**
+ * @brief  Enter STOP mode; not supported on the host
+ * @return Time spent in STOP mode in ms (always 0)
+ */
+uint32_t MCAL_EnterStop(uint32_t u32MaxInMs)
+{
+    return 0;
+}
+
+/**
+ * @brief  Get input capture time stamp; not supported on the host
+ * @return Time stamp (always 0)
+ */
+uint32_t MCAL_GetCapture(bool* pbRising)
+{
+    *pbRising = false;
+    return 0;
+}
+
+/**
+ * @brief  Get virtual microsecond clock
+ * @return Microseconds since start-up
+ */
+uint32_t MCAL_GetMicroseconds(void)
+{
+    return _stHost.u32Tick * 1000UL;
+}
+
+/**
+ * @brief  Get virtual system tick
+ * @return Milliseconds since start-up
+ */
+uint32_t MCAL_GetTick(void)
+{
+    return _stHost.u32Tick;
+}
+
+/**
+ * @brief Count microsecond clock overflow; unused on the host
+ */
+void MCAL_IncMicroseconds(void)
+{
+}
+
+/**
+ * @brief Microsecond delay; returns immediately in virtual time
+ */
+void MCAL_Sleep(uint16_t u16DelayInUs)
+{
+}
+
+/**
+ * @brief Arm timer service alarm; not supported on the host
+ */
+void MCAL_StartAlarm(uint32_t u32Deadline)
+{
+}
+
+/**
+ * @brief Start blanking timer; not supported on the host
+ */
+void MCAL_StartBlanking(uint16_t u16DelayInUs)
+{
+}
+
+/**
+ * @brief Start input capture; not supported on the host
+ */
+void MCAL_StartCapture(void)
+{
+}
+
+/**
+ * @brief Start debounce timer; not supported on the host
+ */
+void MCAL_StartDebounce(uint16_t u16DelayInUs)
+{
+}
+
+/**
+ * @brief Emit latch pulse; not supported on the host
+ */
+void MCAL_StartLatch(void)
+{
+}
+
+/**
+ * @brief Disarm timer service alarm; not supported on the host
+ */
+void MCAL_StopAlarm(void)
+{
+}
+
+/**
+ * @brief  Check if a PWM sequence is being played
+ * @return Boolean state (always false, there is no PWM on the host)
+ */
+bool PWM_IsRunning(void)
+{
+    return false;
+}
+
+/**
+ * @brief  Play PWM sequence; not supported on the host
+ * @return Error code (always 0)
+ */
+int PWM_Start(const uint16_t* pu16Burst, uint16_t u16Entries)
+{
+    return 0;
+}
+
+/**
+ * @brief Stop PWM sequence; nothing to do on the host
+ */
+void PWM_Stop(void)
+{
+}
+
+/**
+ * @brief  Get milliseconds elapsed in the current virtual RTC second
+ * @return Milliseconds (always 0, the virtual RTC has a resolution of
+ *         one second)
+ */
+uint16_t RTC_GetMilliseconds(void)
+{
+    return 0;
+}
+
+/**
+ * @brief  Get current time from virtual RTC
+ * @param  pu8Hours
+ *         Pointer to hours
+ * @param  pu8Minutes
+ *         Pointer to minutes
+ * @param  pu8Seconds
+ *         Pointer to seconds
+ * @return Error code
+ * @retval  0: OK
+ */
+int RTC_GetTime(uint8_t* pu8Hours, uint8_t* pu8Minutes, uint8_t* pu8Seconds)
+{
+    *pu8Hours   = (uint8_t)(_stHost.u32Time / 3600U);
+    *pu8Minutes = (uint8_t)((_stHost.u32Time / 60U) % 60U);
+    *pu8Seconds = (uint8_t)(_stHost.u32Time % 60U);
+
+    return 0;
+}
+
+/**
+ * @brief  Set virtual RTC time
+ * @param  u8Hours
+ *         Hours
+ * @param  u8Minutes
+ *         Minutes
+ * @param  u8Seconds
+ *         Seconds
+ * @return Error code
+ * @retval  0: OK
+ */
+int RTC_SetTime(uint8_t u8Hours, uint8_t u8Minutes, uint8_t u8Seconds)
+{
+    _stHost.u32Time = (u8Hours * 3600UL) + (u8Minutes * 60UL) + u8Seconds;
+
+    return 0;
+}
+
+/**
+ * @brief  Transmit an amount via SPI
+ * @return Error code
+ * @retval  0: OK
+ */
+int SPI_Transmit(uint8_t* pu8TxData, uint16_t u16Size)
+{
+    return 0;
+}
+
+/**
+ * @brief  Receive an amount of data via SPI
+ * @param  pu8RxData
+ *         Pointer to data buffer
+ * @param  u16Size
+ *         Amount of data to be received
+ * @return Error code
+ * @retval  0: OK
+ */
+int SPI_Receive(uint8_t* pu8RxData, uint16_t u16Size)
+{
+    memset(pu8RxData, 0, u16Size);
+
+    return 0;
+}
+
+/**
+ * @brief  Transmit and Receive an amount of data via SPI
+ * @param  pu8TxData
+ *         Pointer to transmission data buffer
+ * @param  pu8RxData
+ *         Pointer to reception data buffer
+ * @param  u16Size
+ *         Amount of data to be sent and received
+ * @return Error code
+ * @retval  0: OK
+ */
+int SPI_TransmitReceive(uint8_t* pu8TxData, uint8_t* pu8RxData, uint16_t u16Size)
+{
+    memset(pu8RxData, 0, u16Size);
+
+    return 0;
+}
+
+/**
+ * @brief Wait for the end of the SPI transfer; nothing to do on the host
+ */
+void SPI_WaitUntilReady(void)
+{
+}
+
+/**
+ * @brief Set virtual system tick
+ * @param u32Tick
+ *        Milliseconds since start-up
+ */
+void MCAL_HostSetTick(uint32_t u32Tick)
+{
+    _stHost.u32Tick = u32Tick;
+}
+
+/**
+ * @brief Set virtual RTC time
+ * @param u32Seconds
+ *        Seconds since midnight
+ */
+void MCAL_HostSetTime(uint32_t u32Seconds)
+{
+    _stHost.u32Time = u32Seconds % 86400UL;
+}
+
+#endif // HOST_BUILD
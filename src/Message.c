@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Message.c
+ * @brief     Lock-free interrupt-to-task message queues
+ * @details   A message queue is a ring of pointers with exactly one
+ *            producer (usually an interrupt handler) and one consumer
+ *            (usually a task).  Each side writes only its own index, so
+ *            neither needs a critical section: the producer publishes a
+ *            slot by storing the head after the slot (release), the
+ *            consumer frees it by storing the tail after reading it.
+ *            On the Cortex-M3 the aligned 32-bit loads and stores are
+ *            atomic; the barriers are DMB instructions.
+ *
+ *            Messages with a payload are taken from a pool of
+ *            fixed-size blocks.  The pool is a second queue running in
+ *            the opposite direction: the producer allocates blocks from
+ *            it, the consumer returns them once they are processed.
+ *            Every block is either free, queued or held by one side,
+ *            so neither ring can overflow.
+ *
+ *            One queue and pool per interrupt source; the consuming
+ *            task drains all of its messages at once with
+ *            @ref Message_Drain.  Waking the task, if needed, is left
+ *            to the caller.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "Message.h"
+
+/**
+ * @brief  Allocate message block
+ * @note   Producer side of the pool.
+ * @param  pstPool
+ *         Pointer to pool
+ * @return Pointer to block, NULL if all blocks are in use
+ */
+void* Message_Alloc(MessagePool* pstPool)
+{
+    void* pvBlock = NULL;
+
+    if (0 == Message_Drain(&pstPool->stFree, &pvBlock, 1))
+    {
+        return NULL;
+    }
+
+    return pvBlock;
+}
+
+/**
+ * @brief  Take all pending messages
+ * @note   Consumer side.  The tail is published once per batch.
+ * @param  pstQueue
+ *         Pointer to queue
+ * @param  ppvMessage
+ *         Array which receives the message pointers, oldest first
+ * @param  u16Max
+ *         Max. number of messages to take
+ * @return Number of messages taken
+ */
+uint16_t Message_Drain(MessageQueue* pstQueue, void** ppvMessage, uint16_t u16Max)
+{
+    uint32_t u32Head  = __atomic_load_n(&pstQueue->u32Head, __ATOMIC_ACQUIRE);
+    uint32_t u32Tail  = pstQueue->u32Tail;
+    uint32_t u32Count = u32Head - u32Tail;
+
+    if (u16Max < u32Count)
+    {
+        u32Count = u16Max;
+    }
+
+    for (uint32_t u32Idx = 0; u32Idx < u32Count; u32Idx++)
+    {
+        ppvMessage[u32Idx] = pstQueue->ppvSlot[(u32Tail + u32Idx) & pstQueue->u32Mask];
+    }
+
+    __atomic_store_n(&pstQueue->u32Tail, u32Tail + u32Count, __ATOMIC_RELEASE);
+
+    return (uint16_t)u32Count;
+}
+
+/**
+ * @brief Return message block to its pool
+ * @note  Consumer side of the pool.
+ * @param pstPool
+ *        Pointer to pool
+ * @param pvBlock
+ *        Pointer to block from @ref Message_Alloc
+ */
+void Message_Free(MessagePool* pstPool, void* pvBlock)
+{
+    (void)Message_Put(&pstPool->stFree, pvBlock);
+}
+
+/**
+ * @brief  Initialise message block pool
+ * @param  pstPool
+ *         Pointer to pool
+ * @param  ppvSlot
+ *         Slot storage, one slot per block
+ * @param  pvBlocks
+ *         Block storage (u16Blocks * u16BlockSize bytes)
+ * @param  u16Blocks
+ *         Number of blocks, a power of two
+ * @param  u16BlockSize
+ *         Block size in bytes, a multiple of the pointer size
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Message_InitPool(MessagePool* pstPool, void** ppvSlot, void* pvBlocks, uint16_t u16Blocks, uint16_t u16BlockSize)
+{
+    uint8_t* pu8Block = (uint8_t*)pvBlocks;
+
+    if ((0 == u16BlockSize) || (0 != (u16BlockSize % sizeof(void*))))
+    {
+        return -1;
+    }
+
+    if (0 != Message_InitQueue(&pstPool->stFree, ppvSlot, u16Blocks))
+    {
+        return -1;
+    }
+
+    for (uint16_t u16Idx = 0; u16Idx < u16Blocks; u16Idx++)
+    {
+        pstPool->stFree.ppvSlot[u16Idx] = pu8Block;
+        pu8Block += u16BlockSize;
+    }
+    pstPool->stFree.u32Head = u16Blocks;
+
+    return 0;
+}
+
+/**
+ * @brief  Initialise message queue
+ * @note   Must not be called while the producer or consumer is active.
+ * @param  pstQueue
+ *         Pointer to queue
+ * @param  ppvSlot
+ *         Slot storage
+ * @param  u16Slots
+ *         Number of slots, a power of two
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Message_InitQueue(MessageQueue* pstQueue, void** ppvSlot, uint16_t u16Slots)
+{
+    if ((NULL == ppvSlot) || (0 == u16Slots) || (0 != (u16Slots & (u16Slots - 1U))))
+    {
+        return -1;
+    }
+
+    pstQueue->ppvSlot = ppvSlot;
+    pstQueue->u32Mask = u16Slots - 1U;
+    pstQueue->u32Head = 0;
+    pstQueue->u32Tail = 0;
+
+    return 0;
+}
+
+/**
+ * @brief  Check if the queue is empty
+ * @note   Consumer side.
+ * @param  pstQueue
+ *         Pointer to queue
+ * @return Boolean state
+ */
+bool Message_IsEmpty(MessageQueue* pstQueue)
+{
+    return (__atomic_load_n(&pstQueue->u32Head, __ATOMIC_ACQUIRE) == pstQueue->u32Tail);
+}
+
+/**
+ * @brief  Put message into queue
+ * @note   Producer side; does not block.
+ * @param  pstQueue
+ *         Pointer to queue
+ * @param  pvMessage
+ *         Message pointer
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Queue is full
+ */
+int Message_Put(MessageQueue* pstQueue, void* pvMessage)
+{
+    uint32_t u32Head = pstQueue->u32Head;
+    uint32_t u32Tail = __atomic_load_n(&pstQueue->u32Tail, __ATOMIC_ACQUIRE);
+
+    if (pstQueue->u32Mask < (u32Head - u32Tail))
+    {
+        return -1;
+    }
+
+    pstQueue->ppvSlot[u32Head & pstQueue->u32Mask] = pvMessage;
+    __atomic_store_n(&pstQueue->u32Head, u32Head + 1U, __ATOMIC_RELEASE);
+
+    return 0;
+}
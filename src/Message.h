@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Message.h
+ * @brief Lock-free interrupt-to-task message queues
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @struct MessageQueue
+ * @brief  Single-producer single-consumer ring of message pointers
+ */
+typedef struct
+{
+    void**   ppvSlot; ///< Slot storage, number of slots is a power of two
+    uint32_t u32Mask; ///< Number of slots - 1
+    uint32_t u32Head; ///< Messages put, written by the producer only
+    uint32_t u32Tail; ///< Messages taken, written by the consumer only
+
+} MessageQueue;
+
+/**
+ * @struct MessagePool
+ * @brief  Fixed-size message blocks
+ * @note   The free blocks are kept in a queue of their own, filled by
+ *         the consumer and emptied by the producer.
+ */
+typedef struct
+{
+    MessageQueue stFree; ///< Free blocks
+
+} MessagePool;
+
+void*    Message_Alloc(MessagePool* pstPool);
+uint16_t Message_Drain(MessageQueue* pstQueue, void** ppvMessage, uint16_t u16Max);
+void     Message_Free(MessagePool* pstPool, void* pvBlock);
+int      Message_InitPool(MessagePool* pstPool, void** ppvSlot, void* pvBlocks, uint16_t u16Blocks, uint16_t u16BlockSize);
+int      Message_InitQueue(MessageQueue* pstQueue, void** ppvSlot, uint16_t u16Slots);
+bool     Message_IsEmpty(MessageQueue* pstQueue);
+int      Message_Put(MessageQueue* pstQueue, void* pvMessage);
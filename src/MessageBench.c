@@ -0,0 +1,483 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      MessageBench.c
+ * @brief     Host benchmark of the lock-free message queues
+ * @details   Sends 8-byte events in bursts from a simulated interrupt
+ *            handler to a consumer, once through @ref Message_Put with
+ *            a block pool and once through xQueueSendFromISR(), and
+ *            reports the throughput and the latency of a single send.
+ *            FreeRTOS runs on a minimal host port without scheduler;
+ *            its critical sections are compiler barriers only, so the
+ *            figures for the FreeRTOS queue are a lower bound.
+ *
+ *            Finally a producer and a consumer thread pass sequence
+ *            numbers through a queue and pool concurrently to check the
+ *            ordering.  Fails if a message is lost, duplicated or out of
+ *            order.
+ * @code{.unparsed}
+ * Usage: program [-n messages] [-b burst]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_MESSAGEBENCH
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "Message.h"
+#include "queue.h"
+#include "task.h"
+
+#define BENCH_SLOTS   16U   ///< Queue length and number of blocks
+#define BENCH_BATCH   16U   ///< Max. messages per drain
+#define BENCH_SAMPLES 65536 ///< Latency samples kept per run
+
+/**
+ * @struct BenchEvent
+ * @brief  Event sent by the simulated interrupt handler
+ */
+typedef struct
+{
+    uint32_t u32Time;   ///< Time stamp
+    uint16_t u16Source; ///< Interrupt source
+    uint16_t u16Value;  ///< Payload
+
+} BenchEvent;
+
+/**
+ * @struct BenchResult
+ * @brief  Result of one run
+ */
+typedef struct
+{
+    double dMsgPerSec; ///< Throughput in messages per second
+    double dMedian;    ///< Median send latency in ns
+    double dP999;      ///< 99.9th percentile send latency in ns
+    double dMax;       ///< Max. send latency in ns
+
+} BenchResult;
+
+/**
+ * @struct BenchData
+ * @brief  Benchmark data
+ */
+typedef struct
+{
+    MessageQueue  stQueue;                                          ///< Lock-free queue
+    MessagePool   stPool;                                           ///< Block pool
+    void*         apvQueueSlot[BENCH_SLOTS];                        ///< Queue slots
+    void*         apvPoolSlot[BENCH_SLOTS];                         ///< Pool slots
+    BenchEvent    astBlock[BENCH_SLOTS];                            ///< Pool blocks
+    StaticQueue_t stRtosQueue;                                      ///< FreeRTOS queue control block
+    uint8_t       au8RtosStorage[BENCH_SLOTS * sizeof(BenchEvent)]; ///< FreeRTOS queue storage
+    QueueHandle_t hRtosQueue;                                       ///< FreeRTOS queue handle
+    uint32_t      au32Latency[BENCH_SAMPLES];                       ///< Send latencies in ns
+    uint32_t      u32Overhead;                                      ///< Cost of a time stamp pair in ns
+    uint32_t      u32Checksum;                                      ///< Keeps the consumer from being optimised away
+    uint32_t      u32Errors;                                        ///< Errors of the concurrent run
+
+} BenchData;
+
+/**
+ * @var   _stBench
+ * @brief Benchmark private data
+ */
+static BenchData _stBench;
+
+static int      _Compare(const void* pvA, const void* pvB);
+static void*    _Consumer(void* pvArg);
+static uint64_t _Now(void);
+static void*    _Producer(void* pvArg);
+static void     _Report(const char* pacName, const BenchResult* pstResult);
+static void     _RunMessage(uint32_t u32Messages, uint32_t u32Burst, bool bTimed, BenchResult* pstResult);
+static void     _RunRtos(uint32_t u32Messages, uint32_t u32Burst, bool bTimed, BenchResult* pstResult);
+static void     _Summarise(uint32_t u32Samples, BenchResult* pstResult);
+
+/**
+ * @brief  Message benchmark entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    BenchResult stMessage  = { 0 };
+    BenchResult stRtos     = { 0 };
+    uint32_t    u32Messages = 10000000;
+    uint32_t    u32Burst    = 4;
+    uint32_t    u32Min      = UINT32_MAX;
+    pthread_t   hProducer;
+    pthread_t   hConsumer;
+    int         nOpt;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "n:b:")))
+    {
+        switch (nOpt)
+        {
+            case 'n':
+                u32Messages = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                u32Burst = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n messages] [-b burst]\n", apcArgv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if ((0 == u32Burst) || (BENCH_SLOTS < u32Burst) || (0 == u32Messages))
+    {
+        fprintf(stderr, "Burst must be 1 to %u messages\n", BENCH_SLOTS);
+        return EXIT_FAILURE;
+    }
+
+    Message_InitQueue(&_stBench.stQueue, _stBench.apvQueueSlot, BENCH_SLOTS);
+    Message_InitPool(&_stBench.stPool, _stBench.apvPoolSlot, _stBench.astBlock, BENCH_SLOTS, sizeof(BenchEvent));
+
+    _stBench.hRtosQueue = xQueueCreateStatic(BENCH_SLOTS, sizeof(BenchEvent), _stBench.au8RtosStorage, &_stBench.stRtosQueue);
+    if (NULL == _stBench.hRtosQueue)
+    {
+        fprintf(stderr, "Could not create FreeRTOS queue\n");
+        return EXIT_FAILURE;
+    }
+
+    for (uint32_t u32Idx = 0; u32Idx < 1000; u32Idx++)
+    {
+        uint64_t u64Start = _Now();
+        uint32_t u32Cost  = (uint32_t)(_Now() - u64Start);
+
+        if (u32Min > u32Cost)
+        {
+            u32Min = u32Cost;
+        }
+    }
+    _stBench.u32Overhead = u32Min;
+
+    _RunMessage(u32Messages, u32Burst, false, &stMessage);
+    _RunMessage(BENCH_SAMPLES, u32Burst, true, &stMessage);
+    _RunRtos(u32Messages, u32Burst, false, &stRtos);
+    _RunRtos(BENCH_SAMPLES, u32Burst, true, &stRtos);
+
+    printf("%u messages of %zu bytes in bursts of %u\n", u32Messages, sizeof(BenchEvent), u32Burst);
+    _Report("Message_Put", &stMessage);
+    _Report("xQueueSendFromISR", &stRtos);
+    printf("Speed-up: %.2fx\n", stMessage.dMsgPerSec / stRtos.dMsgPerSec);
+
+    pthread_create(&hConsumer, NULL, _Consumer, &u32Messages);
+    pthread_create(&hProducer, NULL, _Producer, &u32Messages);
+    pthread_join(hProducer, NULL);
+    pthread_join(hConsumer, NULL);
+
+    printf("Concurrent run: %u messages, %u errors (checksum %08x)\n", u32Messages, _stBench.u32Errors, _stBench.u32Checksum);
+
+    return (0 == _stBench.u32Errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief  Compare two latency samples
+ * @param  pvA
+ *         Pointer to first sample
+ * @param  pvB
+ *         Pointer to second sample
+ * @return Comparison result for qsort()
+ */
+static int _Compare(const void* pvA, const void* pvB)
+{
+    uint32_t u32A = *(const uint32_t*)pvA;
+    uint32_t u32B = *(const uint32_t*)pvB;
+
+    return (u32A > u32B) - (u32A < u32B);
+}
+
+/**
+ * @brief  Consumer thread of the concurrent run
+ * @param  pvArg
+ *         Pointer to the number of messages
+ * @return NULL
+ */
+static void* _Consumer(void* pvArg)
+{
+    uint32_t u32Messages = *(const uint32_t*)pvArg;
+    uint32_t u32Expected = 0;
+    void*    apvMessage[BENCH_BATCH];
+
+    while (u32Expected < u32Messages)
+    {
+        uint16_t u16Count = Message_Drain(&_stBench.stQueue, apvMessage, BENCH_BATCH);
+
+        if (0 == u16Count)
+        {
+            sched_yield();
+        }
+
+        for (uint16_t u16Idx = 0; u16Idx < u16Count; u16Idx++)
+        {
+            BenchEvent* pstEvent = (BenchEvent*)apvMessage[u16Idx];
+
+            if (u32Expected != pstEvent->u32Time)
+            {
+                _stBench.u32Errors++;
+            }
+            u32Expected = pstEvent->u32Time + 1U;
+            Message_Free(&_stBench.stPool, pstEvent);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief  Get monotonic time
+ * @return Time in ns
+ */
+static uint64_t _Now(void)
+{
+    struct timespec stTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &stTime);
+
+    return ((uint64_t)stTime.tv_sec * 1000000000ULL) + (uint64_t)stTime.tv_nsec;
+}
+
+/**
+ * @brief  Producer thread of the concurrent run
+ * @param  pvArg
+ *         Pointer to the number of messages
+ * @return NULL
+ */
+static void* _Producer(void* pvArg)
+{
+    uint32_t u32Messages = *(const uint32_t*)pvArg;
+
+    for (uint32_t u32Seq = 0; u32Seq < u32Messages; u32Seq++)
+    {
+        BenchEvent* pstEvent;
+
+        while (NULL == (pstEvent = Message_Alloc(&_stBench.stPool)))
+        {
+            sched_yield();
+        }
+
+        pstEvent->u32Time   = u32Seq;
+        pstEvent->u16Source = 0;
+        pstEvent->u16Value  = (uint16_t)u32Seq;
+
+        while (0 != Message_Put(&_stBench.stQueue, pstEvent))
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Print result of a run
+ * @param pacName
+ *        Name of the send function
+ * @param pstResult
+ *        Pointer to result
+ */
+static void _Report(const char* pacName, const BenchResult* pstResult)
+{
+    printf("%-18s %7.2f M msg/s, send latency median %5.1f ns, 99.9%% %5.1f ns, max %9.1f ns\n",
+           pacName,
+           pstResult->dMsgPerSec / 1e6,
+           pstResult->dMedian,
+           pstResult->dP999,
+           pstResult->dMax);
+}
+
+/**
+ * @brief Pass messages through the lock-free queue
+ * @param u32Messages
+ *        Number of messages
+ * @param u32Burst
+ *        Messages sent per interrupt
+ * @param bTimed
+ *        true: measure every send, false: measure throughput
+ * @param pstResult
+ *        Pointer to result
+ */
+static void _RunMessage(uint32_t u32Messages, uint32_t u32Burst, bool bTimed, BenchResult* pstResult)
+{
+    uint64_t u64Start = _Now();
+    uint32_t u32Sent  = 0;
+    void*    apvMessage[BENCH_BATCH];
+
+    while (u32Sent < u32Messages)
+    {
+        // Interrupt handler
+        for (uint32_t u32Idx = 0; (u32Idx < u32Burst) && (u32Sent < u32Messages); u32Idx++)
+        {
+            uint64_t    u64Send  = bTimed ? _Now() : 0;
+            BenchEvent* pstEvent = (BenchEvent*)Message_Alloc(&_stBench.stPool);
+
+            pstEvent->u32Time   = u32Sent;
+            pstEvent->u16Source = 1;
+            pstEvent->u16Value  = (uint16_t)u32Idx;
+            Message_Put(&_stBench.stQueue, pstEvent);
+
+            if (bTimed)
+            {
+                _stBench.au32Latency[u32Sent] = (uint32_t)(_Now() - u64Send);
+            }
+            u32Sent++;
+        }
+
+        // Task
+        uint16_t u16Count = Message_Drain(&_stBench.stQueue, apvMessage, BENCH_BATCH);
+        for (uint16_t u16Idx = 0; u16Idx < u16Count; u16Idx++)
+        {
+            BenchEvent* pstEvent = (BenchEvent*)apvMessage[u16Idx];
+
+            _stBench.u32Checksum += pstEvent->u32Time ^ pstEvent->u16Value;
+            Message_Free(&_stBench.stPool, pstEvent);
+        }
+    }
+
+    if (bTimed)
+    {
+        _Summarise(u32Messages, pstResult);
+    }
+    else
+    {
+        pstResult->dMsgPerSec = (double)u32Messages * 1e9 / (double)(_Now() - u64Start);
+    }
+}
+
+/**
+ * @brief Pass messages through a FreeRTOS queue
+ * @param u32Messages
+ *        Number of messages
+ * @param u32Burst
+ *        Messages sent per interrupt
+ * @param bTimed
+ *        true: measure every send, false: measure throughput
+ * @param pstResult
+ *        Pointer to result
+ */
+static void _RunRtos(uint32_t u32Messages, uint32_t u32Burst, bool bTimed, BenchResult* pstResult)
+{
+    uint64_t   u64Start = _Now();
+    uint32_t   u32Sent  = 0;
+    BenchEvent stEvent;
+
+    while (u32Sent < u32Messages)
+    {
+        // Interrupt handler
+        for (uint32_t u32Idx = 0; (u32Idx < u32Burst) && (u32Sent < u32Messages); u32Idx++)
+        {
+            uint64_t   u64Send = bTimed ? _Now() : 0;
+            BaseType_t xWoken  = pdFALSE;
+
+            stEvent.u32Time   = u32Sent;
+            stEvent.u16Source = 1;
+            stEvent.u16Value  = (uint16_t)u32Idx;
+            xQueueSendFromISR(_stBench.hRtosQueue, &stEvent, &xWoken);
+
+            if (bTimed)
+            {
+                _stBench.au32Latency[u32Sent] = (uint32_t)(_Now() - u64Send);
+            }
+            u32Sent++;
+        }
+
+        // Task
+        while (pdPASS == xQueueReceive(_stBench.hRtosQueue, &stEvent, 0))
+        {
+            _stBench.u32Checksum += stEvent.u32Time ^ stEvent.u16Value;
+        }
+    }
+
+    if (bTimed)
+    {
+        _Summarise(u32Messages, pstResult);
+    }
+    else
+    {
+        pstResult->dMsgPerSec = (double)u32Messages * 1e9 / (double)(_Now() - u64Start);
+    }
+}
+
+/**
+ * @brief Evaluate latency samples
+ * @param u32Samples
+ *        Number of samples
+ * @param pstResult
+ *        Pointer to result
+ */
+static void _Summarise(uint32_t u32Samples, BenchResult* pstResult)
+{
+    for (uint32_t u32Idx = 0; u32Idx < u32Samples; u32Idx++)
+    {
+        uint32_t u32Value = _stBench.au32Latency[u32Idx];
+
+        _stBench.au32Latency[u32Idx] = (u32Value > _stBench.u32Overhead) ? (u32Value - _stBench.u32Overhead) : 0;
+    }
+
+    qsort(_stBench.au32Latency, u32Samples, sizeof(uint32_t), _Compare);
+
+    pstResult->dMedian = (double)_stBench.au32Latency[u32Samples / 2U];
+    pstResult->dP999   = (double)_stBench.au32Latency[(u32Samples * 999ULL) / 1000ULL];
+    pstResult->dMax    = (double)_stBench.au32Latency[u32Samples - 1U];
+}
+
+/*
+ * Host port hooks; the scheduler is never started.
+ */
+
+/**
+ * @brief Provide the memory for use by the RTOS Idle task
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t** ppxIdleTaskTCBBuffer, StackType_t** ppxIdleTaskStackBuffer, uint32_t* pulIdleTaskStackSize)
+{
+    static StaticTask_t xIdleTaskTCBBuffer;
+    static StackType_t  xIdleStack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer   = &xIdleTaskTCBBuffer;
+    *ppxIdleTaskStackBuffer = &xIdleStack[0];
+    *pulIdleTaskStackSize   = configMINIMAL_STACK_SIZE;
+}
+
+/**
+ * @brief Idle hook; unused
+ */
+void vApplicationIdleHook(void)
+{
+}
+
+/**
+ * @brief  Initialise task stack; unused
+ * @return Top of stack
+ */
+StackType_t* pxPortInitialiseStack(StackType_t* pxTopOfStack, TaskFunction_t pxCode, void* pvParameters)
+{
+    return pxTopOfStack;
+}
+
+/**
+ * @brief  Start scheduler; not supported
+ * @return pdFALSE
+ */
+BaseType_t xPortStartScheduler(void)
+{
+    return pdFALSE;
+}
+
+/**
+ * @brief Stop scheduler; unused
+ */
+void vPortEndScheduler(void)
+{
+}
+
+#endif // USE_MESSAGEBENCH
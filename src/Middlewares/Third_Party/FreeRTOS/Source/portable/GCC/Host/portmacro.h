@@ -0,0 +1,79 @@
+/*
+ * Minimal host port, used by the host benchmarks only.
+ *
+ * There is no scheduler: the kernel objects are driven from a single
+ * thread.  Critical sections and interrupt masks are compiler
+ * barriers, so their cost on the target (BASEPRI write and barriers)
+ * is not included in host measurements.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uint32_t
+#define portBASE_TYPE	long
+#define portPOINTER_SIZE_TYPE	uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	typedef uint16_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffff
+#else
+	typedef uint32_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+#endif
+
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			8
+
+#define portMEMORY_BARRIER()		__atomic_signal_fence( __ATOMIC_SEQ_CST )
+
+#define portYIELD()								portMEMORY_BARRIER()
+#define portEND_SWITCHING_ISR( xSwitchRequired )	( void )( xSwitchRequired )
+#define portYIELD_FROM_ISR( x )					portEND_SWITCHING_ISR( x )
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()		( portMEMORY_BARRIER(), 0 )
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	do { ( void )( x ); portMEMORY_BARRIER(); } while( 0 )
+#define portDISABLE_INTERRUPTS()				portMEMORY_BARRIER()
+#define portENABLE_INTERRUPTS()					portMEMORY_BARRIER()
+#define portENTER_CRITICAL()					portMEMORY_BARRIER()
+#define portEXIT_CRITICAL()						portMEMORY_BARRIER()
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )	( void )( xExpectedIdleTime )
+
+#if configUSE_PORT_OPTIMISED_TASK_SELECTION == 1
+	#define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+	#define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+	#define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities ) uxTopPriority = ( 31UL - ( uint32_t ) __builtin_clz( ( uint32_t )( uxReadyPriorities ) ) )
+#endif
+
+#define portNOP()
+#define portINLINE	__inline
+
+#ifndef portFORCE_INLINE
+	#define portFORCE_INLINE inline __attribute__(( always_inline))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
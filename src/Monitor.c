@@ -0,0 +1,324 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Monitor.c
+ * @brief     Run-time statistics
+ * @details   Samples the FreeRTOS run-time statistics (counted by the
+ *            TIM3 microsecond clock, see @ref MCAL_GetMicroseconds)
+ *            every @ref MONITOR_INTERVAL and reports the CPU usage of
+ *            each task within the interval and the stack high-water
+ *            marks, and the share of each power state since start-up.
+ *            The report is written to the ITM stimulus port 0 (SWO),
+ *            followed by the profiling probes (USE_PROFILING) and the
+ *            panel health counters (USE_DMD_SELFTEST).
+ *
+ *            Only built with USE_RUNTIME_STATS; release builds contain
+ *            neither the module nor the kernel's statistics.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_RUNTIME_STATS
+
+#include <stdint.h>
+#include "DMD.h"
+#include "FreeRTOS.h"
+#include "Job.h"
+#include "MCAL.h"
+#include "Monitor.h"
+#include "Power.h"
+#include "Profile.h"
+#include "cmsis_os.h"
+#include "task.h"
+
+/**
+ * @struct MonitorData
+ * @brief  Monitor data
+ */
+typedef struct
+{
+    TaskStatus_t astStatus[MONITOR_MAX_TASKS];     ///< Kernel task states (sampling buffer)
+    MonitorTask  astTask[MONITOR_MAX_TASKS];       ///< Statistics of last interval
+    uint32_t     au32Last[MONITOR_MAX_TASKS];      ///< Run time counters at last sample
+    uint8_t      au8LastNumber[MONITOR_MAX_TASKS]; ///< Task numbers at last sample
+    uint32_t     u32LastTotal;                     ///< Total run time at last sample
+    uint8_t      u8NumOfTasks;                     ///< Number of reported tasks
+    Job          stJob;                            ///< Monitor job
+
+} MonitorData;
+
+/**
+ * @var   _stMonitor
+ * @brief Monitor private data
+ */
+static MonitorData _stMonitor = { 0 };
+
+static JobState _MonitorJob(Job* pstJob);
+static void     _PrintNumber(uint32_t u32Number, uint8_t u8Width);
+static void     _PrintString(const char* pacString, uint8_t u8Width);
+static void     _Sample(void);
+
+/**
+ * @brief  Initialise run-time statistics
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Monitor_Init(void)
+{
+    if (0 != Job_Add(&_stMonitor.stJob, _MonitorJob))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Write report of the last interval to SWO
+ */
+void Monitor_Dump(void)
+{
+    MonitorTask astTask[MONITOR_MAX_TASKS];
+    uint8_t     u8NumOfTasks = Monitor_GetTasks(astTask, MONITOR_MAX_TASKS);
+
+    _PrintString("Task", configMAX_TASK_NAME_LEN);
+    _PrintString("  CPU%  Stack free\n", 0);
+
+    for (uint8_t u8Idx = 0; u8Idx < u8NumOfTasks; u8Idx++)
+    {
+        _PrintString(astTask[u8Idx].pacName, configMAX_TASK_NAME_LEN);
+        _PrintNumber(astTask[u8Idx].u8CPU, 6);
+        _PrintNumber(astTask[u8Idx].u16StackFree, 12);
+        _PrintString("\n", 0);
+    }
+
+    {
+        uint64_t u64Total = 0;
+
+        for (uint8_t u8Idx = 0; u8Idx < NUM_OF_POWER_STATES; u8Idx++)
+        {
+            u64Total += Power_GetTime((PowerState)u8Idx);
+        }
+
+        if (0 != u64Total)
+        {
+            _PrintString("Power", configMAX_TASK_NAME_LEN);
+            _PrintString("  RUN%  SLEEP%  STOP%  Current (uA)\n", 0);
+            _PrintString("", configMAX_TASK_NAME_LEN);
+            _PrintNumber((uint32_t)((100U * Power_GetTime(POWER_RUN)) / u64Total), 6);
+            _PrintNumber((uint32_t)((100U * Power_GetTime(POWER_SLEEP)) / u64Total), 8);
+            _PrintNumber((uint32_t)((100U * Power_GetTime(POWER_STOP)) / u64Total), 7);
+            _PrintNumber(Power_GetAverageCurrent(), 14);
+            _PrintString("\n", 0);
+        }
+    }
+
+    #ifdef USE_PROFILING
+    _PrintString("Probe", configMAX_TASK_NAME_LEN + 2);
+    _PrintString("     Count  Min (cyc)  Mean (cyc)  Max (cyc)\n", 0);
+
+    for (uint8_t u8Idx = 0; u8Idx < NUM_OF_PROFILE_PROBES; u8Idx++)
+    {
+        ProfileStats stStats;
+
+        Profile_Get((ProfileProbe)u8Idx, &stStats);
+        if (0 == stStats.u32Count)
+        {
+            continue;
+        }
+
+        _PrintString(Profile_GetName((ProfileProbe)u8Idx), configMAX_TASK_NAME_LEN + 2);
+        _PrintNumber(stStats.u32Count, 10);
+        _PrintNumber(stStats.u32Min, 11);
+        _PrintNumber((uint32_t)(stStats.u64Sum / stStats.u32Count), 12);
+        _PrintNumber(stStats.u32Max, 11);
+        _PrintString("\n", 0);
+    }
+    #endif
+
+    #ifdef USE_DMD_SELFTEST
+    {
+        static const char* const apacState[] = { "unknown", "OK", "bit errors", "no signal" };
+        DMDHealth                stHealth;
+
+        DMD_GetHealth(&stHealth);
+        _PrintString("Panel", configMAX_TASK_NAME_LEN + 2);
+        _PrintString("     Tests  Failed  Bit errors  No signal  Streak  State\n", 0);
+        _PrintString("0", configMAX_TASK_NAME_LEN + 2);
+        _PrintNumber(stHealth.u32Tests, 10);
+        _PrintNumber(stHealth.u32Failures, 8);
+        _PrintNumber(stHealth.u32BitErrors, 12);
+        _PrintNumber(stHealth.u32NoSignal, 11);
+        _PrintNumber(stHealth.u16Streak, 8);
+        _PrintString("  ", 0);
+        _PrintString(apacState[stHealth.eState], 0);
+        _PrintString("\n", 0);
+    }
+    #endif
+}
+
+/**
+ * @brief  Get task statistics of the last interval
+ * @param  pastTask
+ *         Pointer to array of task statistics
+ * @param  u8Max
+ *         Size of array
+ * @return Number of tasks
+ */
+uint8_t Monitor_GetTasks(MonitorTask* pastTask, uint8_t u8Max)
+{
+    uint8_t u8NumOfTasks;
+
+    taskENTER_CRITICAL();
+    u8NumOfTasks = _stMonitor.u8NumOfTasks;
+    if (u8NumOfTasks > u8Max)
+    {
+        u8NumOfTasks = u8Max;
+    }
+
+    for (uint8_t u8Idx = 0; u8Idx < u8NumOfTasks; u8Idx++)
+    {
+        pastTask[u8Idx] = _stMonitor.astTask[u8Idx];
+    }
+    taskEXIT_CRITICAL();
+
+    return u8NumOfTasks;
+}
+
+/**
+ * @brief  Monitor job
+ * @param  pstJob
+ *         Pointer to job entry
+ * @return Job state
+ */
+static JobState _MonitorJob(Job* pstJob)
+{
+    JOB_BEGIN(pstJob);
+
+    while (1)
+    {
+        JOB_DELAY(pstJob, MONITOR_INTERVAL);
+        _Sample();
+        Monitor_Dump();
+    }
+
+    JOB_END(pstJob);
+}
+
+/**
+ * @brief Print decimal number right-aligned to SWO
+ * @param u32Number
+ *        Number
+ * @param u8Width
+ *        Field width
+ */
+static void _PrintNumber(uint32_t u32Number, uint8_t u8Width)
+{
+    char    acDigits[10];
+    uint8_t u8Count = 0;
+
+    do
+    {
+        acDigits[u8Count++] = (char)('0' + (u32Number % 10U));
+        u32Number /= 10U;
+    }
+    while (0 != u32Number);
+
+    while (u8Width > u8Count)
+    {
+        ITM_SendChar(' ');
+        u8Width--;
+    }
+
+    while (0 != u8Count)
+    {
+        ITM_SendChar(acDigits[--u8Count]);
+    }
+}
+
+/**
+ * @brief Print string left-aligned to SWO
+ * @param pacString
+ *        String
+ * @param u8Width
+ *        Field width (0: none)
+ */
+static void _PrintString(const char* pacString, uint8_t u8Width)
+{
+    uint8_t u8Count = 0;
+
+    while ('\0' != *pacString)
+    {
+        ITM_SendChar(*pacString++);
+        u8Count++;
+    }
+
+    while (u8Width > u8Count)
+    {
+        ITM_SendChar(' ');
+        u8Count++;
+    }
+}
+
+/**
+ * @brief   Sample run-time statistics
+ * @details The kernel's run time counters are 32-bit microsecond
+ *          counters and wrap after approx. 71 minutes, so only the
+ *          differences within one interval are evaluated.
+ */
+static void _Sample(void)
+{
+    TaskStatus_t* astStatus = _stMonitor.astStatus;
+    uint32_t      au32Last[MONITOR_MAX_TASKS];
+    uint8_t       au8LastNumber[MONITOR_MAX_TASKS];
+    uint32_t      u32Total;
+    uint32_t      u32Interval;
+    UBaseType_t   uNumOfTasks;
+
+    // The buffer is only used by the monitor thread
+    uNumOfTasks = uxTaskGetSystemState(astStatus, MONITOR_MAX_TASKS, &u32Total);
+    u32Interval = u32Total - _stMonitor.u32LastTotal;
+
+    taskENTER_CRITICAL();
+    for (UBaseType_t uIdx = 0; uIdx < uNumOfTasks; uIdx++)
+    {
+        MonitorTask* pstTask = &_stMonitor.astTask[uIdx];
+        uint32_t     u32Last = 0;
+
+        // Run time counter of the same task at the last sample
+        for (uint8_t u8Idx = 0; u8Idx < _stMonitor.u8NumOfTasks; u8Idx++)
+        {
+            if (_stMonitor.au8LastNumber[u8Idx] == astStatus[uIdx].xTaskNumber)
+            {
+                u32Last = _stMonitor.au32Last[u8Idx];
+                break;
+            }
+        }
+
+        pstTask->pacName      = astStatus[uIdx].pcTaskName;
+        pstTask->u8Number     = (uint8_t)astStatus[uIdx].xTaskNumber;
+        pstTask->u32RunTime   = astStatus[uIdx].ulRunTimeCounter - u32Last;
+        pstTask->u16StackFree = (uint16_t)(astStatus[uIdx].usStackHighWaterMark * sizeof(StackType_t));
+        pstTask->u8CPU        = 0;
+
+        if (0 != u32Interval)
+        {
+            pstTask->u8CPU = (uint8_t)(((uint64_t)pstTask->u32RunTime * 100U) / u32Interval);
+        }
+
+        au32Last[uIdx]      = astStatus[uIdx].ulRunTimeCounter;
+        au8LastNumber[uIdx] = pstTask->u8Number;
+    }
+
+    for (UBaseType_t uIdx = 0; uIdx < uNumOfTasks; uIdx++)
+    {
+        _stMonitor.au32Last[uIdx]      = au32Last[uIdx];
+        _stMonitor.au8LastNumber[uIdx] = au8LastNumber[uIdx];
+    }
+
+    _stMonitor.u8NumOfTasks = (uint8_t)uNumOfTasks;
+    _stMonitor.u32LastTotal = u32Total;
+    taskEXIT_CRITICAL();
+}
+
+#endif // USE_RUNTIME_STATS
@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Monitor.h
+ * @brief Run-time statistics
+ */
+#pragma once
+
+#ifdef USE_RUNTIME_STATS
+
+#include <stdint.h>
+
+#define MONITOR_MAX_TASKS 6     ///< Max. number of reported tasks
+#define MONITOR_INTERVAL  10000 ///< Sampling interval in ms
+
+/**
+ * @struct MonitorTask
+ * @brief  Task statistics of the last sampling interval
+ */
+typedef struct
+{
+    const char* pacName;      ///< Task name
+    uint32_t    u32RunTime;   ///< Run time in µs
+    uint16_t    u16StackFree; ///< Stack high-water mark (min. free) in byte
+    uint8_t     u8CPU;        ///< CPU usage in percent
+    uint8_t     u8Number;     ///< Task number
+
+} MonitorTask;
+
+int     Monitor_Init(void);
+void    Monitor_Dump(void);
+uint8_t Monitor_GetTasks(MonitorTask* pastTask, uint8_t u8Max);
+
+#endif // USE_RUNTIME_STATS
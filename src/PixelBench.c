@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      PixelBench.c
+ * @brief     Host benchmark of the pixel functions
+ * @details   Applies random pixel operations to a frame buffer and to a
+ *            reference array of pixels and fails on the first
+ *            difference, then reports the time per pixel of
+ *            @ref DMD_SetPixel, @ref DMD_GetPixel and
+ *            @ref DMD_TogglePixel over full frames.
+ *
+ *            The host runs the bit-manipulation fallback; on the target
+ *            the same calls compile to bit-band alias accesses.
+ * @code{.unparsed}
+ * Usage: program [-n frames]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_PIXELBENCH
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "DMD.h"
+
+#define BENCH_BUFFER_SIZE ((DMD_WIDTH / 8) * DMD_HEIGHT) ///< Frame buffer size in bytes
+#define BENCH_PIXELS      (DMD_WIDTH * DMD_HEIGHT)      ///< Pixels per frame
+#define BENCH_CHECKS      1000000                       ///< Random operations checked
+#define BENCH_SAMPLES     65536                         ///< Timing samples kept per function
+
+/**
+ * @enum  BenchOp
+ * @brief Pixel operations
+ */
+typedef enum
+{
+    BENCH_SET = 0, ///< DMD_SetPixel()
+    BENCH_GET,     ///< DMD_GetPixel()
+    BENCH_TOGGLE,  ///< DMD_TogglePixel()
+    NUM_OF_BENCH_OPS
+
+} BenchOp;
+
+/**
+ * @struct BenchData
+ * @brief  Benchmark data
+ */
+typedef struct
+{
+    uint8_t  au8Buffer[BENCH_BUFFER_SIZE]; ///< Frame buffer
+    bool     abPixel[BENCH_PIXELS];        ///< Reference pixels
+    uint32_t au32Time[BENCH_SAMPLES];      ///< Frame times in ns
+    uint32_t u32Overhead;                  ///< Cost of a time stamp pair in ns
+    uint32_t u32Checksum;                  ///< Keeps the reads from being optimised away
+
+} BenchData;
+
+/**
+ * @var   _stBench
+ * @brief Benchmark private data
+ */
+static BenchData _stBench;
+
+/**
+ * @var   _apacOp
+ * @brief Function names
+ */
+static const char* const _apacOp[NUM_OF_BENCH_OPS] = {
+    "DMD_SetPixel",
+    "DMD_GetPixel",
+    "DMD_TogglePixel"
+};
+
+static bool     _Check(void);
+static int      _Compare(const void* pvA, const void* pvB);
+static uint64_t _Now(void);
+static uint32_t _Random(uint64_t* pu64State);
+static double   _Run(BenchOp eOp, uint32_t u32Frames);
+
+/**
+ * @brief  Pixel benchmark entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    uint32_t u32Frames = 100000;
+    uint32_t u32Min    = UINT32_MAX;
+    int      nOpt;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "n:")))
+    {
+        switch (nOpt)
+        {
+            case 'n':
+                u32Frames = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n frames]\n", apcArgv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (0 == u32Frames)
+    {
+        fprintf(stderr, "Number of frames must not be 0\n");
+        return EXIT_FAILURE;
+    }
+
+    if (! _Check())
+    {
+        return EXIT_FAILURE;
+    }
+    printf("Reference check: %u random operations OK\n", BENCH_CHECKS);
+
+    for (uint32_t u32Idx = 0; u32Idx < 1000; u32Idx++)
+    {
+        uint64_t u64Start = _Now();
+        uint32_t u32Cost  = (uint32_t)(_Now() - u64Start);
+
+        if (u32Min > u32Cost)
+        {
+            u32Min = u32Cost;
+        }
+    }
+    _stBench.u32Overhead = u32Min;
+
+    printf("%u frames of %u pixels per function\n", u32Frames, BENCH_PIXELS);
+    for (uint8_t u8Op = 0; u8Op < NUM_OF_BENCH_OPS; u8Op++)
+    {
+        printf("%-16s median %5.2f ns per pixel\n", _apacOp[u8Op], _Run((BenchOp)u8Op, u32Frames));
+    }
+    printf("(checksum %08x)\n", _stBench.u32Checksum);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief  Compare random operations with the reference
+ * @return true: no difference, false: difference found
+ */
+static bool _Check(void)
+{
+    uint64_t u64Seed = 0x91CE1ULL;
+
+    for (uint32_t u32Idx = 0; u32Idx < BENCH_CHECKS; u32Idx++)
+    {
+        uint32_t u32Random = _Random(&u64Seed);
+        uint8_t  u8X       = (uint8_t)(u32Random % DMD_WIDTH);
+        uint8_t  u8Y       = (uint8_t)((u32Random >> 8) % DMD_HEIGHT);
+        bool*    pbPixel   = &_stBench.abPixel[(u8Y * DMD_WIDTH) + u8X];
+
+        switch ((BenchOp)((u32Random >> 16) % NUM_OF_BENCH_OPS))
+        {
+            case BENCH_SET:
+                *pbPixel = (0 != (u32Random & (1UL << 31)));
+                DMD_SetPixel(_stBench.au8Buffer, u8X, u8Y, *pbPixel);
+                break;
+            case BENCH_TOGGLE:
+                *pbPixel = ! *pbPixel;
+                DMD_TogglePixel(_stBench.au8Buffer, u8X, u8Y);
+                break;
+            case BENCH_GET:
+            default:
+                break;
+        }
+
+        for (uint16_t u16Pixel = 0; u16Pixel < BENCH_PIXELS; u16Pixel++)
+        {
+            uint8_t u8PixelX = (uint8_t)(u16Pixel % DMD_WIDTH);
+            uint8_t u8PixelY = (uint8_t)(u16Pixel / DMD_WIDTH);
+
+            if (_stBench.abPixel[u16Pixel] != DMD_GetPixel(_stBench.au8Buffer, u8PixelX, u8PixelY))
+            {
+                fprintf(stderr, "Pixel %u/%u differs after operation %u\n", u8PixelX, u8PixelY, u32Idx);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief  Compare two timing samples
+ * @param  pvA
+ *         Pointer to first sample
+ * @param  pvB
+ *         Pointer to second sample
+ * @return Comparison result for qsort()
+ */
+static int _Compare(const void* pvA, const void* pvB)
+{
+    uint32_t u32A = *(const uint32_t*)pvA;
+    uint32_t u32B = *(const uint32_t*)pvB;
+
+    return (u32A > u32B) - (u32A < u32B);
+}
+
+/**
+ * @brief  Get monotonic time
+ * @return Time in ns
+ */
+static uint64_t _Now(void)
+{
+    struct timespec stTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &stTime);
+
+    return ((uint64_t)stTime.tv_sec * 1000000000ULL) + (uint64_t)stTime.tv_nsec;
+}
+
+/**
+ * @brief  xorshift64* pseudo random number generator
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return Random number
+ */
+static uint32_t _Random(uint64_t* pu64State)
+{
+    *pu64State ^= *pu64State >> 12;
+    *pu64State ^= *pu64State << 25;
+    *pu64State ^= *pu64State >> 27;
+
+    return (uint32_t)((*pu64State * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief  Measure full frames of one pixel function
+ * @param  eOp
+ *         Pixel function
+ * @param  u32Frames
+ *         Number of frames
+ * @return Median time per pixel in ns
+ */
+static double _Run(BenchOp eOp, uint32_t u32Frames)
+{
+    uint32_t u32Samples = (u32Frames < BENCH_SAMPLES) ? u32Frames : BENCH_SAMPLES;
+
+    for (uint32_t u32Idx = 0; u32Idx < u32Frames; u32Idx++)
+    {
+        uint64_t u64Start = _Now();
+        uint32_t u32Time;
+
+        for (uint8_t u8Y = 0; u8Y < DMD_HEIGHT; u8Y++)
+        {
+            for (uint8_t u8X = 0; u8X < DMD_WIDTH; u8X++)
+            {
+                switch (eOp)
+                {
+                    case BENCH_SET:
+                        DMD_SetPixel(_stBench.au8Buffer, u8X, u8Y, (0 != ((u8X ^ u8Y ^ u32Idx) & 1U)));
+                        break;
+                    case BENCH_GET:
+                        _stBench.u32Checksum += DMD_GetPixel(_stBench.au8Buffer, u8X, u8Y);
+                        break;
+                    case BENCH_TOGGLE:
+                    default:
+                        DMD_TogglePixel(_stBench.au8Buffer, u8X, u8Y);
+                        break;
+                }
+            }
+        }
+
+        u32Time = (uint32_t)(_Now() - u64Start);
+        _stBench.au32Time[u32Idx % BENCH_SAMPLES] = (u32Time > _stBench.u32Overhead) ? (u32Time - _stBench.u32Overhead) : 0;
+
+        // Keep the frame buffer observable between frames
+        __asm__ volatile("" : : "r"(_stBench.au8Buffer) : "memory");
+    }
+
+    qsort(_stBench.au32Time, u32Samples, sizeof(uint32_t), _Compare);
+
+    return (double)_stBench.au32Time[u32Samples / 2U] / BENCH_PIXELS;
+}
+
+#endif // USE_PIXELBENCH
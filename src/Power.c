@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Power.c
+ * @brief     Power management
+ * @details   Keeps track of the display state and of time signal
+ *            reception, which decide whether the MCU may enter STOP
+ *            mode while idle (see RTOS.c), and accounts the time spent
+ *            in each power state.
+ *
+ *            On the target, the idle hook accounts SLEEP and the
+ *            tickless idle accounts STOP; RUN is the remainder of the
+ *            uptime.
+ *
+ *            For host builds, @ref Power_Model estimates the time in
+ *            each state from the display state and the number of
+ *            wake-ups, following the firmware's behaviour:  while the
+ *            display is on, the CPU refreshes one scanline per
+ *            millisecond and sleeps in between; while it is off, the CPU
+ *            stays in STOP mode apart from short wake-ups, or halts
+ *            during a time signal window.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Power.h"
+
+#ifndef HOST_BUILD
+#include "MCAL.h"
+#endif
+
+#define POWER_REFRESH_US      500U ///< Run time per 1 ms display refresh
+#define POWER_WAKEUP_US      2000U ///< Run time per wake-up from STOP (incl. HSE start-up)
+
+#define POWER_RUN_UA        36000U ///< Supply current in RUN mode (72 MHz)
+#define POWER_SLEEP_UA      14000U ///< Supply current in SLEEP mode (72 MHz)
+#define POWER_STOP_UA          24U ///< Supply current in STOP mode (incl. RTC)
+
+/**
+ * @struct PowerData
+ * @brief  Power management data
+ */
+typedef struct
+{
+    uint64_t au64TimeInUs[NUM_OF_POWER_STATES]; ///< Time spent per state
+    bool     bDisplayOn;                        ///< Display is on
+    bool     bReception;                        ///< Time signal is being received
+    #ifndef HOST_BUILD
+    uint64_t u64UptimeInUs;                     ///< Uptime up to u32LastTick
+    uint32_t u32LastTick;                       ///< Tick of the last uptime update
+    #endif
+
+} PowerData;
+
+/**
+ * @var   _stPower
+ * @brief Power management private data
+ */
+static PowerData _stPower = {
+    { 0 },
+    true,
+    false,
+    #ifndef HOST_BUILD
+    0,
+    0
+    #endif
+};
+
+/**
+ * @var   _au32Current
+ * @brief Supply current per power state in µA
+ */
+static const uint32_t _au32Current[NUM_OF_POWER_STATES] = {
+    POWER_RUN_UA,
+    POWER_SLEEP_UA,
+    POWER_STOP_UA
+};
+
+#ifndef HOST_BUILD
+static void _UpdateRun(void);
+#endif
+
+/**
+ * @brief Account time spent in power state
+ * @note  On the target, RUN is derived from the uptime and must not be
+ *        accounted.
+ * @param eState
+ *        Power state
+ * @param u32TimeInUs
+ *        Time in µs
+ */
+void Power_Account(PowerState eState, uint32_t u32TimeInUs)
+{
+    _stPower.au64TimeInUs[eState] += u32TimeInUs;
+}
+
+/**
+ * @brief  Get average supply current of the MCU
+ * @return Average current in µA, 0 if no time has been accounted
+ */
+uint32_t Power_GetAverageCurrent(void)
+{
+    uint64_t u64Charge = 0;
+    uint64_t u64Time   = 0;
+
+    #ifndef HOST_BUILD
+    _UpdateRun();
+    #endif
+
+    for (uint8_t u8Idx = 0; u8Idx < NUM_OF_POWER_STATES; u8Idx++)
+    {
+        u64Charge += _stPower.au64TimeInUs[u8Idx] * _au32Current[u8Idx];
+        u64Time   += _stPower.au64TimeInUs[u8Idx];
+    }
+
+    if (0 == u64Time)
+    {
+        return 0;
+    }
+
+    return (uint32_t)(u64Charge / u64Time);
+}
+
+/**
+ * @brief  Get time spent in power state
+ * @param  eState
+ *         Power state
+ * @return Time in µs
+ */
+uint64_t Power_GetTime(PowerState eState)
+{
+    #ifndef HOST_BUILD
+    if (POWER_RUN == eState)
+    {
+        _UpdateRun();
+    }
+    #endif
+
+    return _stPower.au64TimeInUs[eState];
+}
+
+/**
+ * @brief  Check if display is on
+ * @return Display state
+ */
+bool Power_IsDisplayOn(void)
+{
+    return _stPower.bDisplayOn;
+}
+
+/**
+ * @brief   Check for a time signal window
+ * @details While the display is off, the MCU stays out of STOP mode
+ *          for up to @ref POWER_RECEPTION_WINDOW seconds at the start
+ *          of every @ref POWER_RECEPTION_PERIOD, so the DCF77 decoder
+ *          (TIM3) keeps running.
+ * @param   u32TimeOfDay
+ *          Seconds since midnight
+ * @return  Boolean state
+ */
+bool Power_IsReceptionWindow(uint32_t u32TimeOfDay)
+{
+    return ((u32TimeOfDay % POWER_RECEPTION_PERIOD) < POWER_RECEPTION_WINDOW);
+}
+
+/**
+ * @brief  Check if the MCU may enter STOP mode
+ * @return Boolean state
+ */
+bool Power_IsStopAllowed(void)
+{
+    return ((! _stPower.bDisplayOn) && (! _stPower.bReception));
+}
+
+/**
+ * @brief Model an interval of the firmware's power states
+ * @param u32TimeInMs
+ *        Length of interval in ms
+ * @param u32Wakeups
+ *        Number of wake-ups within the interval (display off only)
+ */
+void Power_Model(uint32_t u32TimeInMs, uint32_t u32Wakeups)
+{
+    uint64_t u64Total = (uint64_t)u32TimeInMs * 1000U;
+    uint64_t u64Run;
+
+    if (_stPower.bDisplayOn)
+    {
+        u64Run = (uint64_t)u32TimeInMs * POWER_REFRESH_US;
+
+        _stPower.au64TimeInUs[POWER_RUN]   += u64Run;
+        _stPower.au64TimeInUs[POWER_SLEEP] += u64Total - u64Run;
+    }
+    else if (_stPower.bReception)
+    {
+        u64Run = (uint64_t)u32Wakeups * POWER_WAKEUP_US;
+        if (u64Run > u64Total)
+        {
+            u64Run = u64Total;
+        }
+
+        _stPower.au64TimeInUs[POWER_RUN]   += u64Run;
+        _stPower.au64TimeInUs[POWER_SLEEP] += u64Total - u64Run;
+    }
+    else
+    {
+        u64Run = (uint64_t)u32Wakeups * POWER_WAKEUP_US;
+        if (u64Run > u64Total)
+        {
+            u64Run = u64Total;
+        }
+
+        _stPower.au64TimeInUs[POWER_RUN]  += u64Run;
+        _stPower.au64TimeInUs[POWER_STOP] += u64Total - u64Run;
+    }
+}
+
+/**
+ * @brief Set display state
+ * @param bOn
+ *        Display is on
+ */
+void Power_SetDisplay(bool bOn)
+{
+    _stPower.bDisplayOn = bOn;
+}
+
+/**
+ * @brief Set time signal reception state
+ * @param bOn
+ *        Time signal is being received
+ */
+void Power_SetReception(bool bOn)
+{
+    _stPower.bReception = bOn;
+}
+
+#ifndef HOST_BUILD
+/**
+ * @brief   Derive RUN time from the uptime
+ * @details The HAL tick includes the time spent in STOP mode.  It is
+ *          accumulated in 64 bits, so it must be read at least once
+ *          within its 49 days of range.
+ */
+static void _UpdateRun(void)
+{
+    uint32_t u32Now  = MCAL_GetTick();
+    uint64_t u64Idle = _stPower.au64TimeInUs[POWER_SLEEP] + _stPower.au64TimeInUs[POWER_STOP];
+
+    _stPower.u64UptimeInUs += (uint64_t)(u32Now - _stPower.u32LastTick) * 1000U;
+    _stPower.u32LastTick    = u32Now;
+
+    _stPower.au64TimeInUs[POWER_RUN] = (_stPower.u64UptimeInUs > u64Idle) ? (_stPower.u64UptimeInUs - u64Idle) : 0;
+}
+#endif
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Power.h
+ * @brief Power management
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define POWER_DISPLAY_TIMEOUT  10000U ///< Display time after input while the pet sleeps in ms
+#define POWER_IDLE_PERIOD      60000U ///< Max. time between two wake-ups of the update thread while the display is off in ms
+
+#ifndef POWER_RECEPTION_PERIOD
+    #define POWER_RECEPTION_PERIOD 3600U ///< Seconds between two time signal windows while the display is off
+#endif
+#ifndef POWER_RECEPTION_WINDOW
+    #define POWER_RECEPTION_WINDOW 240U  ///< Max. length of a time signal window in seconds
+#endif
+
+/**
+ * @enum  PowerState
+ * @brief MCU power states
+ */
+typedef enum
+{
+    POWER_RUN = 0,      ///< CPU running
+    POWER_SLEEP,        ///< CPU halted (WFI), clocks and tick running
+    POWER_STOP,         ///< STOP mode, only RTC running
+    NUM_OF_POWER_STATES ///< Total number of power states
+
+} PowerState;
+
+void     Power_Account(PowerState eState, uint32_t u32TimeInUs);
+uint32_t Power_GetAverageCurrent(void);
+uint64_t Power_GetTime(PowerState eState);
+bool     Power_IsDisplayOn(void);
+bool     Power_IsReceptionWindow(uint32_t u32TimeOfDay);
+bool     Power_IsStopAllowed(void);
+void     Power_Model(uint32_t u32TimeInMs, uint32_t u32Wakeups);
+void     Power_SetDisplay(bool bOn);
+void     Power_SetReception(bool bOn);
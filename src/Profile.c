@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Profile.c
+ * @brief     Hot-path profiling probes
+ * @details   Scope-bound probes (@ref PROFILE_SCOPE) measure the
+ *            duration of hot functions and aggregate count, min., max.,
+ *            mean and a histogram per probe.  On the target the
+ *            Cortex-M3 DWT cycle counter is used, on the host
+ *            clock_gettime().
+ *
+ *            Only built with USE_PROFILING; otherwise the probes
+ *            compile to nothing.  A probe must only be used by one task
+ *            at a time, statistics are updated without locking.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_PROFILING
+
+#include <stdint.h>
+#include "Profile.h"
+
+#ifdef HOST_BUILD
+#include <time.h>
+#else
+#include "MCAL.h"
+#endif
+
+/**
+ * @var   _astProfile
+ * @brief Probe statistics
+ */
+static ProfileStats _astProfile[NUM_OF_PROFILE_PROBES];
+
+/**
+ * @var   _apacName
+ * @brief Probe names
+ */
+static const char* const _apacName[NUM_OF_PROFILE_PROBES] = {
+    "DMD_Update",
+    "DMD_Upscale",
+    "Clock_Update",
+    "Animation_Update",
+    "BMP180_Read",
+    "M24FC256_Read",
+    "M24FC256_Write",
+    "Input_Latency",
+    "Transition"
+};
+
+/**
+ * @brief Account duration
+ * @param eProbe
+ *        Probe
+ * @param u32Duration
+ *        Duration in ticks
+ */
+void Profile_Add(ProfileProbe eProbe, uint32_t u32Duration)
+{
+    ProfileStats* pstStats = &_astProfile[eProbe];
+    uint8_t       u8Bin    = 0;
+
+    if (1U < u32Duration)
+    {
+        u8Bin = (uint8_t)(31 - __builtin_clz(u32Duration));
+        if ((PROFILE_HISTOGRAM_BINS - 1) < u8Bin)
+        {
+            u8Bin = PROFILE_HISTOGRAM_BINS - 1;
+        }
+    }
+
+    if ((0 == pstStats->u32Count) || (u32Duration < pstStats->u32Min))
+    {
+        pstStats->u32Min = u32Duration;
+    }
+
+    if (u32Duration > pstStats->u32Max)
+    {
+        pstStats->u32Max = u32Duration;
+    }
+
+    pstStats->u64Sum += u32Duration;
+    pstStats->u32Count++;
+    pstStats->au32Histogram[u8Bin]++;
+}
+
+/**
+ * @brief Stop probe and account duration
+ * @note  Called automatically at the end of the scope.
+ * @param pstScope
+ *        Pointer to running probe
+ */
+void Profile_End(ProfileScope* pstScope)
+{
+    Profile_Add(pstScope->eProbe, Profile_GetTicks() - pstScope->u32Start);
+}
+
+/**
+ * @brief Get probe statistics
+ * @param eProbe
+ *        Probe
+ * @param pstStats
+ *        Pointer to statistics
+ */
+void Profile_Get(ProfileProbe eProbe, ProfileStats* pstStats)
+{
+    *pstStats = _astProfile[eProbe];
+}
+
+/**
+ * @brief  Get probe name
+ * @param  eProbe
+ *         Probe
+ * @return Name
+ */
+const char* Profile_GetName(ProfileProbe eProbe)
+{
+    return _apacName[eProbe];
+}
+
+/**
+ * @brief  Get current time stamp
+ * @return CPU cycles (target) or nanoseconds (host)
+ */
+uint32_t Profile_GetTicks(void)
+{
+    #ifdef HOST_BUILD
+    struct timespec stNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+
+    return (uint32_t)((stNow.tv_sec * 1000000000ULL) + stNow.tv_nsec);
+    #else
+    return DWT->CYCCNT;
+    #endif
+}
+
+/**
+ * @brief Initialise profiling; enables the DWT cycle counter
+ */
+void Profile_Init(void)
+{
+    #ifndef HOST_BUILD
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT       = 0;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+    #endif
+}
+
+#endif // USE_PROFILING
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Profile.h
+ * @brief Hot-path profiling probes
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define PROFILE_HISTOGRAM_BINS 16 ///< Histogram bins (powers of two)
+
+/**
+ * @enum  ProfileProbe
+ * @brief Profiling probes
+ */
+typedef enum
+{
+    PROFILE_DMD_UPDATE = 0,   ///< DMD_Update()
+    PROFILE_DMD_UPSCALE,      ///< Upscaling to 64x32 in DMD_Update()
+    PROFILE_CLOCK_UPDATE,     ///< Clock_Update()
+    PROFILE_ANIMATION_UPDATE, ///< Animation_Update()
+    PROFILE_BMP180_READ,      ///< BMP180_ReadTemperature()
+    PROFILE_M24FC256_READ,    ///< M24FC256_Read()
+    PROFILE_M24FC256_WRITE,   ///< M24FC256_Write()
+    PROFILE_INPUT_LATENCY,    ///< Button edge to the end of the next full frame
+    PROFILE_TRANSITION,       ///< Transition_Step()
+    NUM_OF_PROFILE_PROBES     ///< Total number of probes
+
+} ProfileProbe;
+
+/**
+ * @struct ProfileStats
+ * @brief  Aggregated probe statistics
+ * @note   Ticks are CPU cycles on the target and nanoseconds on the
+ *         host.  Bin n of the histogram counts durations from 2^n to
+ *         2^(n+1)-1 ticks, the last bin everything above.
+ */
+typedef struct
+{
+    uint64_t u64Sum;                                ///< Sum of durations in ticks
+    uint32_t u32Count;                              ///< Number of runs
+    uint32_t u32Min;                                ///< Min. duration in ticks
+    uint32_t u32Max;                                ///< Max. duration in ticks
+    uint32_t au32Histogram[PROFILE_HISTOGRAM_BINS]; ///< Duration histogram
+
+} ProfileStats;
+
+#ifdef USE_PROFILING
+
+/**
+ * @struct ProfileScope
+ * @brief  Running probe, see @ref PROFILE_SCOPE
+ */
+typedef struct
+{
+    ProfileProbe eProbe;   ///< Probe
+    uint32_t     u32Start; ///< Start in ticks
+
+} ProfileScope;
+
+/**
+ * @brief Measure the enclosing scope
+ * @param eProbe
+ *        Probe (@ref ProfileProbe)
+ */
+#define PROFILE_SCOPE(eProbe) \
+    ProfileScope _stProfileScope __attribute__((cleanup(Profile_End))) = { (eProbe), Profile_GetTicks() }
+
+/**
+ * @brief Account the time since a time stamp taken with @ref PROFILE_TICKS
+ * @param eProbe
+ *        Probe (@ref ProfileProbe)
+ * @param u32Start
+ *        Start in ticks
+ */
+#define PROFILE_SINCE(eProbe, u32Start) Profile_Add((eProbe), Profile_GetTicks() - (u32Start))
+
+#define PROFILE_TICKS() Profile_GetTicks() ///< Get time stamp, e.g. in an interrupt
+
+void        Profile_Add(ProfileProbe eProbe, uint32_t u32Duration);
+void        Profile_End(ProfileScope* pstScope);
+void        Profile_Get(ProfileProbe eProbe, ProfileStats* pstStats);
+const char* Profile_GetName(ProfileProbe eProbe);
+uint32_t    Profile_GetTicks(void);
+void        Profile_Init(void);
+
+#else
+
+#define PROFILE_SCOPE(eProbe)           ///< Compiles to nothing without USE_PROFILING
+#define PROFILE_SINCE(eProbe, u32Start) ///< Compiles to nothing without USE_PROFILING
+#define PROFILE_TICKS()                 0U ///< No time stamps without USE_PROFILING
+
+#endif // USE_PROFILING
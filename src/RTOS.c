@@ -9,7 +9,12 @@
  *            obtain a copy of the License at:  www.st.com/SLA0044
  */
 
+#include "Button.h"
 #include "FreeRTOS.h"
+#include "MCAL.h"
+#include "Power.h"
+#include "Sound.h"
+#include "Timer.h"
 #include "task.h"
 
 static StaticTask_t xIdleTaskTCBBuffer;
@@ -25,3 +30,81 @@ void vApplicationGetIdleTaskMemory(StaticTask_t** ppxIdleTaskTCBBuffer, StackTyp
     *ppxIdleTaskStackBuffer = &xIdleStack[0];
     *pulIdleTaskStackSize   = configMINIMAL_STACK_SIZE;
 }
+
+/**
+ * @brief Idle hook; halt the CPU until the next interrupt
+ * @note  Requires configUSE_IDLE_HOOK.  The waking interrupt is taken
+ *        after the time stamp, so its run time is not accounted as
+ *        SLEEP.
+ */
+void vApplicationIdleHook(void)
+{
+    uint32_t u32Start;
+
+    __disable_irq();
+    u32Start = MCAL_GetMicroseconds();
+    MCAL_EnterSleep();
+    Power_Account(POWER_SLEEP, MCAL_GetMicroseconds() - u32Start);
+    __enable_irq();
+}
+
+/**
+ * @brief   Tickless idle; enter STOP mode while the display is off
+ * @details While the display is on, it has to be refreshed every tick,
+ *          so the regular tick keeps running and the idle hook halts
+ *          the CPU in between.  The same applies while the time signal
+ *          is received (see @ref Power_IsReceptionWindow).  Otherwise
+ *          the tick is suppressed and
+ *          the MCU stays in STOP mode until the RTC second boundary
+ *          before the next task is due.
+ * @note    Requires configUSE_TICKLESS_IDLE 2.
+ * @param   xExpectedIdleTime
+ *          Ticks until the next task is due
+ */
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+    uint32_t u32Slept;
+
+    if (! Power_IsStopAllowed())
+    {
+        return;
+    }
+
+    #ifdef USE_SOUND
+    // TIM1 stops in STOP mode
+    if (Sound_IsPlaying())
+    {
+        return;
+    }
+    #endif
+
+    // TIM3 stops in STOP mode
+    if (Timer_IsPending())
+    {
+        return;
+    }
+
+    #ifdef USE_BUTTONS
+    if (Button_IsBusy())
+    {
+        return;
+    }
+    #endif
+
+    __disable_irq();
+
+    if (eAbortSleep == eTaskConfirmSleepModeStatus())
+    {
+        __enable_irq();
+        return;
+    }
+
+    u32Slept = MCAL_EnterStop(xExpectedIdleTime * portTICK_PERIOD_MS);
+    if (0 != u32Slept)
+    {
+        vTaskStepTick(u32Slept / portTICK_PERIOD_MS);
+        Power_Account(POWER_STOP, u32Slept * 1000U);
+    }
+
+    __enable_irq();
+}
@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Record.c
+ * @brief     Stimulus recorder
+ * @details   Logs every external stimulus (RTC reads, sensor values and
+ *            button events) with a millisecond timestamp to the
+ *            24FC256 EEPROM (USE_RECORD), so field behaviour can be
+ *            replayed deterministically on the host.
+ *
+ *            To keep the log small, RTC reads are only logged if they
+ *            differ from the time predicted by @ref Record_PredictTime,
+ *            i.e. once after start-up, once the second boundary has
+ *            been found and on clock drift or changes.  Temperatures
+ *            are only logged on change.
+ *
+ *            Entries are collected in two page buffers and written by
+ *            @ref Record_Flush outside of time-critical code, so
+ *            incomplete pages are lost on power loss.  The page after
+ *            the last one written is kept erased, which ends the log
+ *            before any stale entries of an older session.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Record.h"
+
+#ifdef USE_RECORD
+#include "FreeRTOS.h"
+#include "M24FC256.h"
+#include "MCAL.h"
+#include "task.h"
+
+#define RECORD_ENTRIES_PER_PAGE (RECORD_PAGE_SIZE / sizeof(RecordEntry)) ///< Entries per page
+
+/**
+ * @struct RecordData
+ * @brief  Recorder data
+ */
+typedef struct
+{
+    RecordEntry astPage[2][RECORD_ENTRIES_PER_PAGE]; ///< Page buffers
+    uint8_t     au8End[RECORD_PAGE_SIZE];            ///< Erased page, ends the log
+    RecordEntry stLastTime;                          ///< Last logged time
+    uint16_t    u16Address;                          ///< Next EEPROM address
+    uint16_t    u16Dropped;                          ///< Number of dropped entries
+    uint8_t     u8Fill;                              ///< Page buffer being filled
+    uint8_t     u8Count;                             ///< Entries in page buffer being filled
+    int8_t      s8Temperature;                       ///< Last logged temperature
+    bool        bTimeLogged;                         ///< A time has been logged
+    bool        bTemperatureLogged;                  ///< A temperature has been logged
+    bool        bPending;                            ///< The other page buffer is full
+
+} RecordData;
+
+/**
+ * @var   _stRecord
+ * @brief Recorder private data
+ */
+static RecordData _stRecord = { 0 };
+#endif // USE_RECORD
+
+/**
+ * @brief   Predict RTC time from the last logged time
+ * @details Used by the recorder to decide whether an RTC read needs to
+ *          be logged and by the replay to reconstruct every RTC read.
+ * @param   pstLast
+ *          Pointer to last time entry
+ * @param   u32Tick
+ *          Current tick in milliseconds
+ * @return  Predicted seconds since midnight
+ */
+uint32_t Record_PredictTime(const RecordEntry* pstLast, uint32_t u32Tick)
+{
+    uint32_t u32Elapsed = (u32Tick - pstLast->u32Tick) / 1000UL;
+
+    return (RECORD_VALUE(pstLast->u32Data) + u32Elapsed) % 86400UL;
+}
+
+#ifdef USE_RECORD
+/**
+ * @brief  Initialise recorder and write log header
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Record_Init(void)
+{
+    uint8_t       au8Page[RECORD_PAGE_SIZE];
+    RecordHeader* pstHeader = (RecordHeader*)au8Page;
+
+    for (uint8_t u8Idx = 0; u8Idx < RECORD_PAGE_SIZE; u8Idx++)
+    {
+        au8Page[u8Idx]          = 0xFF;
+        _stRecord.au8End[u8Idx] = 0xFF;
+    }
+
+    pstHeader->u32Magic   = RECORD_MAGIC;
+    pstHeader->u32Version = RECORD_VERSION;
+
+    if (0 != M24FC256_Write(RECORD_ADDRESS_START, au8Page, 1))
+    {
+        return -1;
+    }
+
+    // End the log of the previous session
+    if (0 != M24FC256_Write(RECORD_ADDRESS_START + RECORD_PAGE_SIZE, _stRecord.au8End, 1))
+    {
+        return -1;
+    }
+
+    _stRecord.u16Address = RECORD_ADDRESS_START + RECORD_PAGE_SIZE;
+
+    return 0;
+}
+
+/**
+ * @brief Write full page buffer to EEPROM
+ * @note  Blocks on I²C; call from task context only.  The following
+ *        page is erased, so the log always ends with
+ *        @ref RECORD_END.
+ */
+void Record_Flush(void)
+{
+    uint8_t  u8Page;
+    uint16_t u16Address;
+
+    taskENTER_CRITICAL();
+    if (! _stRecord.bPending)
+    {
+        taskEXIT_CRITICAL();
+        return;
+    }
+    u8Page     = _stRecord.u8Fill ^ 1;
+    u16Address = _stRecord.u16Address;
+    taskEXIT_CRITICAL();
+
+    M24FC256_Write(u16Address, (uint8_t*)_stRecord.astPage[u8Page], 1);
+    if ((RECORD_ADDRESS_END - RECORD_PAGE_SIZE) > u16Address)
+    {
+        M24FC256_Write(u16Address + RECORD_PAGE_SIZE, _stRecord.au8End, 1);
+    }
+
+    taskENTER_CRITICAL();
+    _stRecord.u16Address += RECORD_PAGE_SIZE;
+    _stRecord.bPending    = false;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Log stimulus
+ * @param eType
+ *        Stimulus type
+ * @param u32Value
+ *        Value (24-Bit)
+ */
+void Record_Log(RecordType eType, uint32_t u32Value)
+{
+    RecordEntry* pstEntry;
+
+    taskENTER_CRITICAL();
+
+    if ((RECORD_ADDRESS_END - RECORD_PAGE_SIZE) < _stRecord.u16Address)
+    {
+        // Log is full
+        taskEXIT_CRITICAL();
+        return;
+    }
+
+    pstEntry          = &_stRecord.astPage[_stRecord.u8Fill][_stRecord.u8Count];
+    pstEntry->u32Tick = MCAL_GetTick();
+    pstEntry->u32Data = ((uint32_t)eType << 24) | (u32Value & 0x00FFFFFFUL);
+
+    if (RECORD_TIME == eType)
+    {
+        _stRecord.stLastTime  = *pstEntry;
+        _stRecord.bTimeLogged = true;
+    }
+
+    _stRecord.u8Count++;
+    if (RECORD_ENTRIES_PER_PAGE <= _stRecord.u8Count)
+    {
+        if (_stRecord.bPending)
+        {
+            // Flush is lagging behind; overwrite this page
+            _stRecord.u16Dropped += RECORD_ENTRIES_PER_PAGE;
+        }
+        else
+        {
+            _stRecord.bPending  = true;
+            _stRecord.u8Fill   ^= 1;
+        }
+        _stRecord.u8Count = 0;
+    }
+
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Log temperature if it has changed
+ * @param s8Temp
+ *        Temperature in 1°C
+ */
+void Record_Temperature(int8_t s8Temp)
+{
+    if (_stRecord.bTemperatureLogged && (s8Temp == _stRecord.s8Temperature))
+    {
+        return;
+    }
+
+    _stRecord.s8Temperature      = s8Temp;
+    _stRecord.bTemperatureLogged = true;
+
+    Record_Log(RECORD_TEMPERATURE, (uint8_t)s8Temp);
+}
+
+/**
+ * @brief Log RTC time unless it matches the predicted time
+ * @param u32Seconds
+ *        Seconds since midnight
+ */
+void Record_Time(uint32_t u32Seconds)
+{
+    if (_stRecord.bTimeLogged)
+    {
+        if (u32Seconds == Record_PredictTime(&_stRecord.stLastTime, MCAL_GetTick()))
+        {
+            return;
+        }
+    }
+
+    Record_Log(RECORD_TIME, u32Seconds);
+}
+#endif // USE_RECORD
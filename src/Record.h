@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Record.h
+ * @brief Stimulus recorder
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define RECORD_MAGIC          0x43455254UL ///< Log header magic ("TREC")
+#define RECORD_VERSION        1            ///< Log format version
+#define RECORD_ADDRESS_START  0x1000       ///< First EEPROM address of the log (header page)
+#define RECORD_ADDRESS_END    0x8000       ///< EEPROM address past the log
+#define RECORD_PAGE_SIZE      64           ///< Log page size in byte (EEPROM page)
+
+#define RECORD_TYPE(u32Data)  ((RecordType)((u32Data) >> 24)) ///< Get type of entry data
+#define RECORD_VALUE(u32Data) ((u32Data) & 0x00FFFFFFUL)      ///< Get value of entry data
+
+/**
+ * @enum  RecordType
+ * @brief Stimulus types
+ */
+typedef enum
+{
+    RECORD_TIME = 0,    ///< RTC time, seconds since midnight
+    RECORD_TEMPERATURE, ///< Temperature in 1°C (two's complement, 8-Bit)
+    RECORD_BUTTON,      ///< Button event
+    RECORD_CLOCK,       ///< RTC adjustment in seconds (two's complement, 24-Bit)
+    RECORD_PANEL,       ///< Panel health state changed (DMDHealthState)
+    RECORD_END  = 0xFF  ///< End of log (erased EEPROM)
+
+} RecordType;
+
+/**
+ * @struct RecordEntry
+ * @brief  Log entry (little-endian, as stored in EEPROM)
+ */
+typedef struct
+{
+    uint32_t u32Tick; ///< Timestamp in milliseconds since start-up
+    uint32_t u32Data; ///< Type (bits 31-24) and value (bits 23-0)
+
+} RecordEntry;
+
+/**
+ * @struct RecordHeader
+ * @brief  Log header, stored in the first page of the log
+ */
+typedef struct
+{
+    uint32_t u32Magic;   ///< @ref RECORD_MAGIC
+    uint32_t u32Version; ///< @ref RECORD_VERSION
+
+} RecordHeader;
+
+uint32_t Record_PredictTime(const RecordEntry* pstLast, uint32_t u32Tick);
+
+#ifdef USE_RECORD
+int      Record_Init(void);
+void     Record_Flush(void);
+void     Record_Log(RecordType eType, uint32_t u32Value);
+void     Record_Temperature(int8_t s8Temp);
+void     Record_Time(uint32_t u32Seconds);
+#endif
@@ -0,0 +1,494 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Replay.c
+ * @brief     Host replay of recorded stimuli
+ * @details   Feeds a log written by the stimulus recorder (an image of
+ *            the EEPROM log area, see @ref Record.h) back into the
+ *            clock-face and life cycle code in virtual time, as fast as
+ *            the CPU allows.  Every change of the clock-face buffer or
+ *            the pet statistics is captured as a CRC32, which can be
+ *            written to a file and compared against golden captures.
+ *            The power model (see @ref Power.c) reports the time the
+ *            MCU would have spent in each power state.
+ * @code{.unparsed}
+ * Usage: program -l log.bin [-w captures.txt] [-g golden.txt]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_REPLAY
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "Clock.h"
+#include "LifeCycle.h"
+#include "MCAL.h"
+#include "Power.h"
+#include "Profile.h"
+#include "Record.h"
+
+#define REPLAY_STEP 500 ///< Virtual time step in ms, matches the update thread
+
+/**
+ * @struct ReplayData
+ * @brief  Replay data
+ */
+typedef struct
+{
+    RecordEntry* pstEntry;     ///< Log entries
+    size_t       uEntries;     ///< Number of log entries
+    FILE*        phCapture;    ///< Capture output (optional)
+    FILE*        phGolden;     ///< Golden captures (optional)
+    uint32_t     u32Frames;    ///< Number of captured changes
+    uint32_t     u32Buttons;   ///< Number of button events
+    uint32_t     u32Mismatch;  ///< Tick of first mismatch
+    bool         bMismatch;    ///< Captures differ from golden captures
+
+} ReplayData;
+
+/**
+ * @var   _stReplay
+ * @brief Replay private data
+ */
+static ReplayData _stReplay = { 0 };
+
+static void     _Capture(uint32_t u32Tick, uint32_t u32ClockCRC, uint32_t u32StatsCRC);
+static uint32_t _CRC32(const void* pData, size_t uSize);
+static int      _Load(const char* pacPath);
+
+/**
+ * @brief  Replay entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    const char*     pacLog          = NULL;
+    RecordEntry     stLastTime      = { 0 };
+    Stats*          pstStats        = LifeCycle_GetStats();
+    struct timespec stStart;
+    struct timespec stEnd;
+    double          dSeconds;
+    size_t          uNext           = 0;
+    uint32_t        u32Tick;
+    uint32_t        u32End;
+    uint32_t        u32Time         = 0;
+    uint32_t        u32ClockCRC     = 0;
+    uint32_t        u32StatsCRC     = 0;
+    uint32_t        u32Wake         = 0;
+    uint32_t        u32Poll         = 0;
+    uint32_t        u32DisplayUntil = 0;
+    int8_t          s8Temp          = 0;
+    bool            bTimeKnown      = false;
+    bool            bStarted        = false;
+    int             nOpt;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "l:w:g:")))
+    {
+        switch (nOpt)
+        {
+            case 'l':
+                pacLog = optarg;
+                break;
+            case 'w':
+                _stReplay.phCapture = fopen(optarg, "w");
+                if (NULL == _stReplay.phCapture)
+                {
+                    perror(optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'g':
+                _stReplay.phGolden = fopen(optarg, "r");
+                if (NULL == _stReplay.phGolden)
+                {
+                    perror(optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                pacLog = NULL;
+                break;
+        }
+    }
+
+    if (NULL == pacLog)
+    {
+        fprintf(stderr, "Usage: %s -l log.bin [-w captures.txt] [-g golden.txt]\n", apcArgv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (0 != _Load(pacLog))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (0 == _stReplay.uEntries)
+    {
+        fprintf(stderr, "%s: log is empty.\n", pacLog);
+        return EXIT_FAILURE;
+    }
+
+    #ifdef USE_PROFILING
+    Profile_Init();
+    #endif
+
+    clock_gettime(CLOCK_MONOTONIC, &stStart);
+
+    u32Tick = _stReplay.pstEntry[0].u32Tick;
+    u32End  = _stReplay.pstEntry[_stReplay.uEntries - 1].u32Tick + REPLAY_STEP;
+
+    for (; u32Tick < u32End; u32Tick += REPLAY_STEP)
+    {
+        uint32_t u32CRC;
+
+        // Apply all stimuli up to the current virtual time
+        while ((uNext < _stReplay.uEntries) && (_stReplay.pstEntry[uNext].u32Tick <= u32Tick))
+        {
+            const RecordEntry* pstEntry = &_stReplay.pstEntry[uNext];
+
+            switch (RECORD_TYPE(pstEntry->u32Data))
+            {
+                case RECORD_TIME:
+                    stLastTime = *pstEntry;
+                    bTimeKnown = true;
+                    break;
+                case RECORD_TEMPERATURE:
+                    s8Temp = (int8_t)RECORD_VALUE(pstEntry->u32Data);
+                    break;
+                case RECORD_BUTTON:
+                    // Same care actions as on the device, at the state
+                    // reached so far
+                    if (bStarted)
+                    {
+                        uint32_t u32Now = Record_PredictTime(&stLastTime, pstEntry->u32Tick);
+
+                        LifeCycle_Advance(pstStats, (u32Now + 86400UL - u32Time) % 86400UL);
+                        u32Time = u32Now;
+                        LifeCycle_HandleButton(pstStats, (uint8_t)(RECORD_VALUE(pstEntry->u32Data) >> 8), (uint8_t)RECORD_VALUE(pstEntry->u32Data));
+                    }
+                    if (LifeCycle_IsFlagSet(IS_SLEEPING))
+                    {
+                        u32DisplayUntil = pstEntry->u32Tick + POWER_DISPLAY_TIMEOUT;
+                    }
+                    _stReplay.u32Buttons++;
+                    break;
+                case RECORD_CLOCK:
+                {
+                    // The adjustment is not elapsed time
+                    uint32_t u32Offset = RECORD_VALUE(pstEntry->u32Data);
+
+                    if (u32Offset & 0x00800000UL)
+                    {
+                        u32Offset = 86400UL - ((0x01000000UL - u32Offset) % 86400UL);
+                    }
+                    u32Offset %= 86400UL;
+
+                    stLastTime.u32Data = ((uint32_t)RECORD_TIME << 24) | ((RECORD_VALUE(stLastTime.u32Data) + u32Offset) % 86400UL);
+                    u32Time            = (u32Time + u32Offset) % 86400UL;
+                    break;
+                }
+                default:
+                    break;
+            }
+            uNext++;
+        }
+
+        if (! bTimeKnown)
+        {
+            // No RTC read recorded yet
+            continue;
+        }
+
+        MCAL_HostSetTick(u32Tick);
+
+        if (! bStarted)
+        {
+            u32Time = Record_PredictTime(&stLastTime, u32Tick);
+            LifeCycle_Reset(pstStats, u32Time);
+            bStarted = true;
+        }
+        else
+        {
+            uint32_t u32Now = Record_PredictTime(&stLastTime, u32Tick);
+
+            LifeCycle_Advance(pstStats, (u32Now + 86400UL - u32Time) % 86400UL);
+            u32Time = u32Now;
+        }
+
+        MCAL_HostSetTime(u32Time);
+
+        #ifdef USE_BMP180
+        Clock_SetTemperature(s8Temp);
+        #endif
+        Clock_Update();
+
+        // Display is off while the pet sleeps, unless there has been
+        // input recently; the life cycle job wakes up for the next
+        // event, the update thread at least every POWER_IDLE_PERIOD.
+        // Time signal windows are modelled at full length, the log
+        // does not tell when a frame has been taken.
+        if (LifeCycle_IsFlagSet(IS_SLEEPING) && (0 <= (int32_t)(u32Tick - u32DisplayUntil)))
+        {
+            uint32_t u32Wakeups = 0;
+
+            if (Power_IsDisplayOn())
+            {
+                Power_SetDisplay(false);
+                u32Wake = u32Tick;
+                u32Poll = u32Tick;
+            }
+
+            while (u32Wake <= u32Tick)
+            {
+                u32Wake += LifeCycle_GetIdleTime(pstStats) * 1000U;
+                u32Wakeups++;
+            }
+            while (u32Poll <= u32Tick)
+            {
+                u32Poll += POWER_IDLE_PERIOD;
+                u32Wakeups++;
+            }
+
+            #ifdef USE_DCF77
+            Power_SetReception(Power_IsReceptionWindow(u32Time));
+            if (Power_IsReceptionWindow(u32Time))
+            {
+                // Polled every REPLAY_STEP
+                u32Wakeups++;
+            }
+            #endif
+            Power_Model(REPLAY_STEP, u32Wakeups);
+        }
+        else
+        {
+            Power_SetReception(false);
+            Power_SetDisplay(true);
+            Power_Model(REPLAY_STEP, 0);
+        }
+
+        u32CRC = _CRC32(Clock_GetBufferAddr(), 64);
+        if ((u32CRC != u32ClockCRC) || (_CRC32(pstStats, sizeof(Stats)) != u32StatsCRC))
+        {
+            u32ClockCRC = u32CRC;
+            u32StatsCRC = _CRC32(pstStats, sizeof(Stats));
+            _Capture(u32Tick, u32ClockCRC, u32StatsCRC);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stEnd);
+    dSeconds = (double)(stEnd.tv_sec - stStart.tv_sec) + ((double)(stEnd.tv_nsec - stStart.tv_nsec) / 1e9);
+
+    printf("Replayed %zu entries (%u button events), %.1f h virtual time in %.3f s (%.0fx)\n",
+           _stReplay.uEntries,
+           _stReplay.u32Buttons,
+           (double)(u32End - _stReplay.pstEntry[0].u32Tick) / 3600000.0,
+           dSeconds,
+           (double)(u32End - _stReplay.pstEntry[0].u32Tick) / 1000.0 / dSeconds);
+    printf("%u captured changes, pet: evolution %d, %u care mistakes\n",
+           _stReplay.u32Frames,
+           pstStats->eEvolution,
+           pstStats->u16CareMistages);
+
+    dSeconds = (double)(Power_GetTime(POWER_RUN) + Power_GetTime(POWER_SLEEP) + Power_GetTime(POWER_STOP));
+    if (0.0 < dSeconds)
+    {
+        printf("Power: RUN %.1f%%, SLEEP %.1f%%, STOP %.1f%%, average MCU current %u uA\n",
+               100.0 * (double)Power_GetTime(POWER_RUN)   / dSeconds,
+               100.0 * (double)Power_GetTime(POWER_SLEEP) / dSeconds,
+               100.0 * (double)Power_GetTime(POWER_STOP)  / dSeconds,
+               Power_GetAverageCurrent());
+    }
+
+    #ifdef USE_PROFILING
+    printf("%-18s %10s %10s %10s %10s  Histogram (ns, 2^n)\n", "Probe", "Count", "Min (ns)", "Mean (ns)", "Max (ns)");
+    for (uint8_t u8Idx = 0; u8Idx < NUM_OF_PROFILE_PROBES; u8Idx++)
+    {
+        ProfileStats stStats;
+
+        Profile_Get((ProfileProbe)u8Idx, &stStats);
+        if (0 == stStats.u32Count)
+        {
+            continue;
+        }
+
+        printf("%-18s %10u %10u %10llu %10u ",
+               Profile_GetName((ProfileProbe)u8Idx),
+               stStats.u32Count,
+               stStats.u32Min,
+               (unsigned long long)(stStats.u64Sum / stStats.u32Count),
+               stStats.u32Max);
+
+        for (uint8_t u8Bin = 0; u8Bin < PROFILE_HISTOGRAM_BINS; u8Bin++)
+        {
+            if (0 != stStats.au32Histogram[u8Bin])
+            {
+                printf(" %u:%u", u8Bin, stStats.au32Histogram[u8Bin]);
+            }
+        }
+        printf("\n");
+    }
+    #endif
+
+    if (NULL != _stReplay.phCapture)
+    {
+        fclose(_stReplay.phCapture);
+    }
+
+    if (NULL != _stReplay.phGolden)
+    {
+        char acLine[64];
+
+        if ((! _stReplay.bMismatch) && (NULL != fgets(acLine, sizeof(acLine), _stReplay.phGolden)))
+        {
+            _stReplay.bMismatch   = true;
+            _stReplay.u32Mismatch = u32End;
+        }
+        fclose(_stReplay.phGolden);
+
+        if (_stReplay.bMismatch)
+        {
+            printf("Mismatch against golden captures at tick %u\n", _stReplay.u32Mismatch);
+            return EXIT_FAILURE;
+        }
+        printf("Captures match golden captures\n");
+    }
+
+    free(_stReplay.pstEntry);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Capture change and compare against golden capture
+ * @param u32Tick
+ *        Virtual tick in ms
+ * @param u32ClockCRC
+ *        CRC32 of clock-face buffer
+ * @param u32StatsCRC
+ *        CRC32 of pet statistics
+ */
+static void _Capture(uint32_t u32Tick, uint32_t u32ClockCRC, uint32_t u32StatsCRC)
+{
+    char acLine[64];
+
+    _stReplay.u32Frames++;
+
+    snprintf(acLine, sizeof(acLine), "%u %08x %08x\n", u32Tick, u32ClockCRC, u32StatsCRC);
+
+    if (NULL != _stReplay.phCapture)
+    {
+        fputs(acLine, _stReplay.phCapture);
+    }
+
+    if ((NULL != _stReplay.phGolden) && (! _stReplay.bMismatch))
+    {
+        char acGolden[64];
+
+        if ((NULL == fgets(acGolden, sizeof(acGolden), _stReplay.phGolden)) || (0 != strcmp(acLine, acGolden)))
+        {
+            _stReplay.bMismatch   = true;
+            _stReplay.u32Mismatch = u32Tick;
+        }
+    }
+}
+
+/**
+ * @brief  Calculate CRC32 (IEEE 802.3)
+ * @param  pData
+ *         Pointer to data
+ * @param  uSize
+ *         Size of data in byte
+ * @return CRC32
+ */
+static uint32_t _CRC32(const void* pData, size_t uSize)
+{
+    const uint8_t* pu8Data = (const uint8_t*)pData;
+    uint32_t       u32CRC  = 0xFFFFFFFFUL;
+
+    while (uSize--)
+    {
+        u32CRC ^= *pu8Data++;
+        for (uint8_t u8Bit = 0; u8Bit < 8; u8Bit++)
+        {
+            u32CRC = (u32CRC >> 1) ^ (0xEDB88320UL & (0 - (u32CRC & 1)));
+        }
+    }
+
+    return ~u32CRC;
+}
+
+/**
+ * @brief  Load log (EEPROM image of the log area)
+ * @param  pacPath
+ *         Path to log file
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+static int _Load(const char* pacPath)
+{
+    FILE*        phLog = fopen(pacPath, "rb");
+    RecordHeader stHeader;
+    RecordEntry  stEntry;
+    size_t       uCapacity = 0;
+
+    if (NULL == phLog)
+    {
+        perror(pacPath);
+        return -1;
+    }
+
+    if ((1 != fread(&stHeader, sizeof(stHeader), 1, phLog)) ||
+        (RECORD_MAGIC != stHeader.u32Magic) ||
+        (RECORD_VERSION != stHeader.u32Version))
+    {
+        fprintf(stderr, "%s: invalid log header.\n", pacPath);
+        fclose(phLog);
+        return -1;
+    }
+
+    fseek(phLog, RECORD_PAGE_SIZE, SEEK_SET);
+
+    // The log ends with an erased page; a decreasing tick ends it, too,
+    // in case the end page could not be written
+    while (1 == fread(&stEntry, sizeof(stEntry), 1, phLog))
+    {
+        if (RECORD_END == RECORD_TYPE(stEntry.u32Data))
+        {
+            break;
+        }
+
+        if ((0 != _stReplay.uEntries) && (stEntry.u32Tick < _stReplay.pstEntry[_stReplay.uEntries - 1].u32Tick))
+        {
+            break;
+        }
+
+        if (_stReplay.uEntries == uCapacity)
+        {
+            RecordEntry* pstEntry;
+
+            uCapacity = (0 == uCapacity) ? 1024 : (2 * uCapacity);
+            pstEntry  = realloc(_stReplay.pstEntry, uCapacity * sizeof(RecordEntry));
+            if (NULL == pstEntry)
+            {
+                fclose(phLog);
+                return -1;
+            }
+            _stReplay.pstEntry = pstEntry;
+        }
+
+        _stReplay.pstEntry[_stReplay.uEntries++] = stEntry;
+    }
+
+    fclose(phLog);
+
+    return 0;
+}
+
+#endif // USE_REPLAY
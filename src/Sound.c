@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Sound.c
+ * @brief     Sound engine
+ * @details   Plays note sequences on a piezo buzzer connected to TIM1
+ *            channel 1 (PA8).  Sequences are constant tables in flash
+ *            whose entries are the timer register values of each note,
+ *            computed at compile time.  The timer fetches them by DMA
+ *            on its own, so playback needs no CPU time per note.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_SOUND
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "MCAL.h"
+#include "Sound.h"
+
+/**
+ * @var   _astBeep
+ * @brief Key beep
+ */
+static const SoundNote _astBeep[] = {
+    SOUND_NOTE(4000, 30),
+    SOUND_END
+};
+
+/**
+ * @var   _astAttention
+ * @brief Attention call
+ */
+static const SoundNote _astAttention[] = {
+    SOUND_NOTE(2000, 100),
+    SOUND_REST(100),
+    SOUND_NOTE(2000, 100),
+    SOUND_REST(100),
+    SOUND_NOTE(2000, 100),
+    SOUND_END
+};
+
+/**
+ * @var   _astEvolution
+ * @brief Evolution melody (C6, E6, G6, C7)
+ */
+static const SoundNote _astEvolution[] = {
+    SOUND_NOTE(1047, 150),
+    SOUND_NOTE(1319, 150),
+    SOUND_NOTE(1568, 150),
+    SOUND_NOTE(2093, 120),
+    SOUND_NOTE(2093, 120),
+    SOUND_END
+};
+
+/**
+ * @var   _astDeath
+ * @brief Death melody (G5, E5, C5)
+ */
+static const SoundNote _astDeath[] = {
+    SOUND_NOTE(784, 300),
+    SOUND_REST(50),
+    SOUND_NOTE(659, 300),
+    SOUND_REST(50),
+    SOUND_NOTE(523, 480),
+    SOUND_NOTE(523, 480),
+    SOUND_END
+};
+
+/**
+ * @var   _apastSound
+ * @brief Sound table
+ */
+static const SoundNote* const _apastSound[NUM_OF_SOUNDS] = {
+    _astBeep,
+    _astAttention,
+    _astEvolution,
+    _astDeath
+};
+
+/**
+ * @brief  Check if a sound is being played
+ * @return Boolean state
+ */
+bool Sound_IsPlaying(void)
+{
+    return PWM_IsRunning();
+}
+
+/**
+ * @brief  Play sound; interrupts the current one
+ * @param  eID
+ *         Sound ID
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Sound_Play(SoundID eID)
+{
+    if (NUM_OF_SOUNDS <= eID)
+    {
+        return -1;
+    }
+
+    return Sound_PlaySequence(_apastSound[eID]);
+}
+
+/**
+ * @brief  Play sequence; interrupts the current one
+ * @param  pastNotes
+ *         Pointer to sequence terminated by @ref SOUND_END; has to stay
+ *         valid during playback
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Sound_PlaySequence(const SoundNote* pastNotes)
+{
+    uint16_t u16Entries = 1;
+
+    while (0 != pastNotes[u16Entries - 1].u16Period)
+    {
+        u16Entries++;
+    }
+
+    return PWM_Start((const uint16_t*)pastNotes, u16Entries);
+}
+
+/**
+ * @brief Stop playback
+ */
+void Sound_Stop(void)
+{
+    PWM_Stop();
+}
+
+#endif // USE_SOUND
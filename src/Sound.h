@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Sound.h
+ * @brief Sound engine
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SOUND_TIMER_CLOCK 72000000UL ///< TIM1 input clock in Hz
+#define SOUND_NOTE_CLOCK   1000000UL ///< Counter clock of notes in Hz
+#define SOUND_REST_CLOCK     10000UL ///< Counter clock of rests in Hz
+
+/**
+ * @brief Repetition counter value; fails to compile if the number of
+ *        periods is out of range (1 to 256)
+ */
+#define SOUND_REPEAT(u32Periods) \
+    ((u32Periods) - 1U + 0U * sizeof(char[((1U <= (u32Periods)) && (256U >= (u32Periods))) ? 1 : -1]))
+
+/**
+ * @brief Note with 50 % duty cycle
+ * @note  Lasts at most 256 periods, e.g. 256 ms at 1 kHz; split longer
+ *        notes.
+ * @param u32Hz
+ *        Frequency in Hz (16 Hz to 20 kHz)
+ * @param u32Ms
+ *        Duration in ms
+ */
+#define SOUND_NOTE(u32Hz, u32Ms) {                                \
+        (uint16_t)(SOUND_TIMER_CLOCK / SOUND_NOTE_CLOCK - 1U),    \
+        (uint16_t)(SOUND_NOTE_CLOCK / (u32Hz) - 1U),              \
+        (uint16_t)SOUND_REPEAT((u32Hz) * (u32Ms) / 1000U),        \
+        (uint16_t)(SOUND_NOTE_CLOCK / (u32Hz) / 2U) }
+
+/**
+ * @brief Rest
+ * @param u32Ms
+ *        Duration in ms (10 to 2560 ms in steps of 10 ms)
+ */
+#define SOUND_REST(u32Ms) {                                       \
+        (uint16_t)(SOUND_TIMER_CLOCK / SOUND_REST_CLOCK - 1U),    \
+        (uint16_t)(SOUND_REST_CLOCK / 100U - 1U),                 \
+        (uint16_t)SOUND_REPEAT((u32Ms) / 10U),                    \
+        0 }
+
+#define SOUND_END { 0, 0, 0, 0 } ///< End of sequence
+
+/**
+ * @struct SoundNote
+ * @brief  Sequence entry
+ * @note   Layout of the TIM1 DMA burst, see @ref PWM_Start.  Use the
+ *         macros above to set up sequences as constants in flash.
+ */
+typedef struct
+{
+    uint16_t u16Prescaler; ///< Prescaler (PSC)
+    uint16_t u16Period;    ///< Period (ARR), 0: end of sequence
+    uint16_t u16Repeat;    ///< Number of periods - 1 (RCR)
+    uint16_t u16Pulse;     ///< Pulse (CCR1)
+
+} SoundNote;
+
+/**
+ * @enum  SoundID
+ * @brief Sound IDs
+ */
+typedef enum
+{
+    SOUND_BEEP = 0,  ///< ID, Key beep
+    SOUND_ATTENTION, ///< ID, Attention call
+    SOUND_EVOLUTION, ///< ID, Evolution melody
+    SOUND_DEATH,     ///< ID, Death melody
+    NUM_OF_SOUNDS    ///< Total number of sounds
+
+} SoundID;
+
+#ifdef USE_SOUND
+bool Sound_IsPlaying(void);
+int  Sound_Play(SoundID eID);
+int  Sound_PlaySequence(const SoundNote* pastNotes);
+void Sound_Stop(void);
+#endif
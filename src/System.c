@@ -11,8 +11,11 @@
  * @section    GPIOConfig GPIO configuration
  * @subsection GPIO_ADC1 ADC 1
  *
- * @li PB0 ---> ADC1_IN8
- * @li PB1 ---> ADC1_IN9
+ * @li PB0 ---> ADC1_IN8 (battery voltage divider)
+ * @li PB1 ---> ADC1_IN9 (ambient light sensor)
+ *
+ * Scan triggered by TIM3, results written by DMA1 channel 1.  The
+ * analog watchdog guards the battery voltage.
  *
  * @subsection GPIO_I2C2 I²C 2
  *
@@ -22,35 +25,76 @@
  * @subsection GPIO_SPI1 SPI 1
  *
  * @li PA5 ---> SPI1_SCK
- * @li PA6 ---> SPI1_MISO
+ * @li PA6 ---> SPI1_MISO (looped back from the panel data output,
+ *             USE_DMD_SELFTEST)
  * @li PA7 ---> SPI1_MOSI
  *
  * @subsection GPIO_TIM1 TIM 1
  *
- * @li PA8 ---> TIM1_CH1
+ * @li PA8 ---> TIM1_CH1 (piezo)
+ *
+ * PWM for the sound engine, fed by DMA1 channel 5 (TIM1_UP).
+ *
+ * @subsection GPIO_TIM2 TIM 2
+ *
+ * @li PA3 ---> TIM2_CH4 (DMD SCLK, latch)
+ *
+ * One-pulse mode; each start emits a 1 µs latch pulse for the DMD
+ * shift registers, see @ref MCAL_StartLatch.  Its interrupt vector is
+ * used by the timer service.
+ *
+ * @subsection TIM3 TIM 3
+ *
+ * Free-running 1 MHz counter (microsecond clock, delays); its update
+ * event triggers the ADC scan.  Channel 2 is a one-shot compare for
+ * the display blanking, channel 3 one for the button debounce timer
+ * and channel 4 the alarm of the timer service (Timer.c), which is
+ * run in the TIM2 interrupt as a software interrupt.
+ *
+ * @li PB4 ---> TIM3_CH1 (DCF77 receiver, input capture, partial remap)
+ *
+ * @subsection GPIO_INPUT Input
+ *
+ * @li PB12 ---> Button A (EXTI12, active low)
+ * @li PB13 ---> Button B (EXTI13, active low)
+ * @li PB14 ---> Button C (EXTI14, active low)
  *
  * @subsection GPIO_OUTPUT Output
  *
- * @li PA0  ---> DMD OE pin
- * @li PA1  ---> DMD SCLK pin
- * @li PA2  ---> DMD A pin
- * @li PA3  ---> DMD B pin
+ * @li PA0  ---> DMD B pin
+ * @li PA1  ---> DMD A pin
+ * @li PA2  ---> DMD OE pin
+ * @li PA4  ---> DMD C pin (1/8 and 1/16 scan)
+ * @li PA9  ---> DMD D pin (1/16 scan)
  * @li PC13 ---> LED
  *
  */
 
 #include "stm32f1xx_hal.h"
+#include "Analog.h"
+#include "Button.h"
+#include "DCF77.h"
+#include "DMD.h"
+#include "MCAL.h"
 #include "System.h"
-
-ADC_HandleTypeDef hadc1; ///< ADC 1 handle
-I2C_HandleTypeDef hi2c2; ///< I²C 2 handle
-SPI_HandleTypeDef hspi1; ///< SPI 1 handle
-RTC_HandleTypeDef hrtc;  ///< RTC handle
-TIM_HandleTypeDef htim1; ///< Timer 1 handle
-TIM_HandleTypeDef htim4; ///< Timer 4 handle (Sys-Tick)
+#include "Timer.h"
+#include "Trace.h"
+
+ADC_HandleTypeDef hadc1;        ///< ADC 1 handle
+DMA_HandleTypeDef hdma_adc1;    ///< DMA 1 channel 1 handle (ADC 1)
+DMA_HandleTypeDef hdma_tim1_up; ///< DMA 1 channel 5 handle (TIM1 update)
+I2C_HandleTypeDef hi2c2;        ///< I²C 2 handle
+SPI_HandleTypeDef hspi1;        ///< SPI 1 handle
+RTC_HandleTypeDef hrtc;         ///< RTC handle
+TIM_HandleTypeDef htim1;        ///< Timer 1 handle (sound)
+TIM_HandleTypeDef htim2;        ///< Timer 2 handle (DMD latch)
+TIM_HandleTypeDef htim3;        ///< Timer 3 handle (microsecond clock)
+TIM_HandleTypeDef htim4;        ///< Timer 4 handle (Sys-Tick)
 
 static void System_GPIO_Init(void);
 static int  System_TIM1_Init(void);
+static int  System_TIM2_Init(void);
+static int  System_TIM3_Init(void);
 static int  System_ADC1_Init(void);
 static int  System_I2C2_Init(void);
 static int  System_SPI1_Init(void);
@@ -71,6 +115,114 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     {
         HAL_IncTick();
     }
+    else if (TIM3 == htim->Instance)
+    {
+        MCAL_IncMicroseconds();
+    }
+}
+
+/**
+ * @brief Conversion half complete callback (first half of the buffer)
+ * @param hadc : ADC handle
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef* hadc)
+{
+    #ifdef USE_ANALOG
+    Analog_Update(false);
+    #endif
+}
+
+/**
+ * @brief Conversion complete callback (second half of the buffer)
+ * @param hadc : ADC handle
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
+{
+    #ifdef USE_ANALOG
+    Analog_Update(true);
+    #endif
+}
+
+/**
+ * @brief Analog watchdog callback
+ * @param hadc : ADC handle
+ */
+void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef* hadc)
+{
+    #ifdef USE_ANALOG
+    Analog_Watchdog();
+    #endif
+}
+
+/**
+ * @brief Memory transmit complete callback
+ * @param hi2c : I2C handle
+ */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    I2C_Complete();
+}
+
+/**
+ * @brief Memory receive complete callback
+ * @param hi2c : I2C handle
+ */
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c)
+{
+    I2C_Complete();
+}
+
+/**
+ * @brief I2C error callback
+ * @param hi2c : I2C handle
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c)
+{
+    I2C_Complete();
+}
+
+/**
+ * @brief Input capture callback
+ * @param htim : TIM handle
+ */
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+{
+    if ((TIM3 == htim->Instance) && (HAL_TIM_ACTIVE_CHANNEL_1 == htim->Channel))
+    {
+        #ifdef USE_DCF77
+        DCF77_Capture();
+        #endif
+    }
+}
+
+/**
+ * @brief Output compare callback
+ * @note  TIM3 channel 2, 3 and 4 elapsed: the blanking, debounce and
+ *        timer service alarms are one-shot.  TIM3 runs above the
+ *        FreeRTOS syscall priority, so the button handler and the
+ *        timer service are run by setting a lower priority interrupt
+ *        pending.
+ * @param htim : TIM handle
+ */
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if ((TIM3 == htim->Instance) && (HAL_TIM_ACTIVE_CHANNEL_2 == htim->Channel))
+    {
+        __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC2);
+        DMD_OE_RowsOff();
+    }
+    else if ((TIM3 == htim->Instance) && (HAL_TIM_ACTIVE_CHANNEL_3 == htim->Channel))
+    {
+        __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC3);
+        #ifdef USE_BUTTONS
+        HAL_NVIC_SetPendingIRQ(EXTI15_10_IRQn);
+        #endif
+    }
+    else if ((TIM3 == htim->Instance) && (HAL_TIM_ACTIVE_CHANNEL_4 == htim->Channel))
+    {
+        __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC4);
+        HAL_NVIC_SetPendingIRQ(TIM2_IRQn);
+    }
 }
 
 /**
@@ -135,13 +287,27 @@ int System_Init(void)
     // Initialise peripherals
     System_GPIO_Init();
 
+    // Started by PWM_Start()
     nStatus = System_TIM1_Init();
     if (0 != nStatus)
     {
         return nStatus;
     }
 
-    if (HAL_OK != HAL_TIM_Base_Start(&htim1))
+    // Started by MCAL_StartLatch()
+    nStatus = System_TIM2_Init();
+    if (0 != nStatus)
+    {
+        return nStatus;
+    }
+
+    nStatus = System_TIM3_Init();
+    if (0 != nStatus)
+    {
+        return nStatus;
+    }
+
+    if (HAL_OK != HAL_TIM_Base_Start_IT(&htim3))
     {
         return -1;
     }
@@ -193,19 +359,36 @@ static void System_GPIO_Init(void)
     HAL_GPIO_Init(LED_GPIO_Port, &GPIO_InitStruct);
 
     // Dot Matrix Display
-    GPIO_InitStruct.Pin   = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3;
+    GPIO_InitStruct.Pin   = DMD_OE_Pin | DMD_ADDRESS_Pins;
     GPIO_InitStruct.Mode  = GPIO_MODE_OUTPUT_PP;
     GPIO_InitStruct.Pull  = GPIO_PULLUP;
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
 
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    #ifdef USE_BUTTONS
+    // Buttons
+    GPIO_InitStruct.Pin   = BUTTON_A_Pin | BUTTON_B_Pin | BUTTON_C_Pin;
+    GPIO_InitStruct.Mode  = GPIO_MODE_IT_RISING_FALLING;
+    GPIO_InitStruct.Pull  = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    // EXTI interrupt Init
+    HAL_NVIC_SetPriority(EXTI15_10_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+    #endif
 }
 
 /**
- * @brief  Timer 1 Initialisation Function
- * @return Error code
- * @retval  0: OK
- * @retval -1: Error
+ * @brief   Timer 1 Initialisation Function
+ * @details PWM on channel 1; prescaler, period, repetition counter and
+ *          pulse are written by a DMA burst on each update event, see
+ *          @ref PWM_Start.
+ * @return  Error code
+ * @retval   0: OK
+ * @retval  -1: Error
  */
 static int System_TIM1_Init(void)
 {
@@ -219,10 +402,10 @@ static int System_TIM1_Init(void)
     htim1.Instance               = TIM1;
     htim1.Init.Prescaler         = 72-1;
     htim1.Init.CounterMode       = TIM_COUNTERMODE_UP;
-    htim1.Init.Period            = 0xFFFF-1;
+    htim1.Init.Period            = 1000-1;
     htim1.Init.ClockDivision     = TIM_CLOCKDIVISION_DIV1;
     htim1.Init.RepetitionCounter = 0;
-    htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
 
     if (HAL_OK != HAL_TIM_Base_Init(&htim1))
     {
@@ -236,7 +419,7 @@ static int System_TIM1_Init(void)
         return -1;
     }
 
-    if (HAL_OK != HAL_TIM_OC_Init(&htim1))
+    if (HAL_OK != HAL_TIM_PWM_Init(&htim1))
     {
         return -1;
     }
@@ -249,7 +432,7 @@ static int System_TIM1_Init(void)
         return -1;
     }
 
-    sConfigOC.OCMode       = TIM_OCMODE_FORCED_ACTIVE;
+    sConfigOC.OCMode       = TIM_OCMODE_PWM1;
     sConfigOC.Pulse        = 0;
     sConfigOC.OCPolarity   = TIM_OCPOLARITY_HIGH;
     sConfigOC.OCNPolarity  = TIM_OCNPOLARITY_HIGH;
@@ -257,7 +440,7 @@ static int System_TIM1_Init(void)
     sConfigOC.OCIdleState  = TIM_OCIDLESTATE_RESET;
     sConfigOC.OCNIdleState = TIM_OCNIDLESTATE_RESET;
 
-    if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim1, &sConfigOC, TIM_CHANNEL_1))
+    if (HAL_OK != HAL_TIM_PWM_ConfigChannel(&htim1, &sConfigOC, TIM_CHANNEL_1))
     {
         return -1;
     }
@@ -275,27 +458,178 @@ static int System_TIM1_Init(void)
         return -1;
     }
 
+    // DMA burst: PSC, ARR, RCR and CCR1
+    WRITE_REG(TIM1->DCR, TIM_DMABASE_PSC | TIM_DMABURSTLENGTH_4TRANSFERS);
+
+    hdma_tim1_up.Instance                 = DMA1_Channel5;
+    hdma_tim1_up.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    hdma_tim1_up.Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma_tim1_up.Init.MemInc              = DMA_MINC_ENABLE;
+    hdma_tim1_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim1_up.Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim1_up.Init.Mode                = DMA_NORMAL;
+    hdma_tim1_up.Init.Priority            = DMA_PRIORITY_LOW;
+
+    if (HAL_OK != HAL_DMA_Init(&hdma_tim1_up))
+    {
+        return -1;
+    }
+
+    __HAL_LINKDMA(&htim1, hdma[TIM_DMA_ID_UPDATE], hdma_tim1_up);
+
     HAL_TIM_MspPostInit(&htim1);
 
     return 0;
 }
 
 /**
- * @brief  ADC 1 Initialisation Function
- * @return Error code
- * @retval  0: OK
- * @retval -1: Error
+ * @brief   Timer 2 Initialisation Function
+ * @details One-pulse PWM on channel 4: the output rises one clock after
+ *          the counter has been enabled and falls on the update event,
+ *          which also stops the counter.
+ * @return  Error code
+ * @retval   0: OK
+ * @retval  -1: Error
+ */
+static int System_TIM2_Init(void)
+{
+    TIM_OC_InitTypeDef sConfigOC = { 0 };
+
+    htim2.Instance               = TIM2;
+    htim2.Init.Prescaler         = 0;
+    htim2.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    htim2.Init.Period            = 72; // High from 1 to 72: 1 µs at 72 MHz
+    htim2.Init.ClockDivision     = TIM_CLOCKDIVISION_DIV1;
+    htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    if (HAL_OK != HAL_TIM_Base_Init(&htim2))
+    {
+        return -1;
+    }
+
+    if (HAL_OK != HAL_TIM_PWM_Init(&htim2))
+    {
+        return -1;
+    }
+
+    sConfigOC.OCMode     = TIM_OCMODE_PWM2;
+    sConfigOC.Pulse      = 1;
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+    if (HAL_OK != HAL_TIM_PWM_ConfigChannel(&htim2, &sConfigOC, TIM_CHANNEL_4))
+    {
+        return -1;
+    }
+
+    SET_BIT(TIM2->CR1, TIM_CR1_OPM);
+    SET_BIT(TIM2->CCER, TIM_CCER_CC4E);
+
+    HAL_TIM_MspPostInit(&htim2);
+
+    return 0;
+}
+
+/**
+ * @brief   Timer 3 Initialisation Function
+ * @details Free-running 16-bit counter at 1 MHz; the update interrupt
+ *          extends it to 32 bits, see @ref MCAL_GetMicroseconds.  The
+ *          update event is also output on TRGO to trigger the ADC.
+ * @return  Error code
+ * @retval   0: OK
+ * @retval  -1: Error
+ */
+static int System_TIM3_Init(void)
+{
+    TIM_ClockConfigTypeDef  sClockSourceConfig = { 0 };
+    TIM_MasterConfigTypeDef sMasterConfig      = { 0 };
+    TIM_OC_InitTypeDef      sConfigOC          = { 0 };
+    TIM_IC_InitTypeDef      sConfigIC          = { 0 };
+
+    htim3.Instance               = TIM3;
+    htim3.Init.Prescaler         = 72-1;
+    htim3.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    htim3.Init.Period            = 0xFFFF;
+    htim3.Init.ClockDivision     = TIM_CLOCKDIVISION_DIV1;
+    htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    if (HAL_OK != HAL_TIM_Base_Init(&htim3))
+    {
+        return -1;
+    }
+
+    sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+
+    if (HAL_OK != HAL_TIM_ConfigClockSource(&htim3, &sClockSourceConfig))
+    {
+        return -1;
+    }
+
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    sMasterConfig.MasterSlaveMode     = TIM_MASTERSLAVEMODE_DISABLE;
+
+    if (HAL_OK != HAL_TIMEx_MasterConfigSynchronization(&htim3, &sMasterConfig))
+    {
+        return -1;
+    }
+
+    // Blanking timer, interrupt enabled by MCAL_StartBlanking()
+    sConfigOC.OCMode     = TIM_OCMODE_TIMING;
+    sConfigOC.Pulse      = 0;
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+
+    if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim3, &sConfigOC, TIM_CHANNEL_2))
+    {
+        return -1;
+    }
+
+    // Debounce timer, interrupt enabled by MCAL_StartDebounce()
+    if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim3, &sConfigOC, TIM_CHANNEL_3))
+    {
+        return -1;
+    }
+
+    // Timer service alarm, interrupt enabled by MCAL_StartAlarm()
+    if (HAL_OK != HAL_TIM_OC_ConfigChannel(&htim3, &sConfigOC, TIM_CHANNEL_4))
+    {
+        return -1;
+    }
+
+    // DCF77 input capture, started by MCAL_StartCapture()
+    sConfigIC.ICPolarity  = TIM_INPUTCHANNELPOLARITY_RISING;
+    sConfigIC.ICSelection = TIM_ICSELECTION_DIRECTTI;
+    sConfigIC.ICPrescaler = TIM_ICPSC_DIV1;
+    sConfigIC.ICFilter    = 0x0F;
+
+    if (HAL_OK != HAL_TIM_IC_ConfigChannel(&htim3, &sConfigIC, TIM_CHANNEL_1))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief   ADC 1 Initialisation Function
+ * @details Scan of PB0 and PB1, twice each, on every TIM3 update; the
+ *          results are written to a circular buffer by DMA, see
+ *          @ref ADC_Start.  The analog watchdog is armed by
+ *          @ref ADC_SetWatchdog.
+ * @return  Error code
+ * @retval   0: OK
+ * @retval  -1: Error
  */
 static int System_ADC1_Init(void)
 {
-    ADC_ChannelConfTypeDef sConfig = { 0 };
+    ADC_ChannelConfTypeDef   sConfig    = { 0 };
+    ADC_AnalogWDGConfTypeDef sAnalogWDG = { 0 };
 
     // Common config
     hadc1.Instance                   = ADC1;
     hadc1.Init.ScanConvMode          = ADC_SCAN_ENABLE;
     hadc1.Init.ContinuousConvMode    = DISABLE;
     hadc1.Init.DiscontinuousConvMode = DISABLE;
-    hadc1.Init.ExternalTrigConv      = ADC_SOFTWARE_START;
+    hadc1.Init.ExternalTrigConv      = ADC_EXTERNALTRIGCONV_T3_TRGO;
     hadc1.Init.DataAlign             = ADC_DATAALIGN_RIGHT;
     hadc1.Init.NbrOfConversion       = 4;
 
@@ -333,13 +667,42 @@ static int System_ADC1_Init(void)
     }
 
     // Configure Regular Channel
-    sConfig.Rank = ADC_REGULAR_RANK_4;
+    sConfig.Channel = ADC_CHANNEL_9;
+    sConfig.Rank    = ADC_REGULAR_RANK_4;
 
     if (HAL_OK != HAL_ADC_ConfigChannel(&hadc1, &sConfig))
     {
         return -1;
     }
 
+    // Battery voltage watchdog, interrupt enabled by ADC_SetWatchdog()
+    sAnalogWDG.WatchdogMode  = ADC_ANALOGWATCHDOG_SINGLE_REG;
+    sAnalogWDG.Channel       = ADC_CHANNEL_8;
+    sAnalogWDG.ITMode        = DISABLE;
+    sAnalogWDG.HighThreshold = 4095;
+    sAnalogWDG.LowThreshold  = 0;
+
+    if (HAL_OK != HAL_ADC_AnalogWDGConfig(&hadc1, &sAnalogWDG))
+    {
+        return -1;
+    }
+
+    hdma_adc1.Instance                 = DMA1_Channel1;
+    hdma_adc1.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+    hdma_adc1.Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma_adc1.Init.MemInc              = DMA_MINC_ENABLE;
+    hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_adc1.Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+    hdma_adc1.Init.Mode                = DMA_CIRCULAR;
+    hdma_adc1.Init.Priority            = DMA_PRIORITY_LOW;
+
+    if (HAL_OK != HAL_DMA_Init(&hdma_adc1))
+    {
+        return -1;
+    }
+
+    __HAL_LINKDMA(&hadc1, DMA_Handle, hdma_adc1);
+
     return 0;
 }
 
@@ -474,6 +837,7 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
     {
         // Peripheral clock enable
         __HAL_RCC_ADC1_CLK_ENABLE();
+        __HAL_RCC_DMA1_CLK_ENABLE();
 
         __HAL_RCC_GPIOB_CLK_ENABLE();
 
@@ -489,6 +853,10 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
         // ADC1 interrupt Init
         HAL_NVIC_SetPriority(ADC1_2_IRQn, 5, 0);
         HAL_NVIC_EnableIRQ(ADC1_2_IRQn);
+
+        // DMA interrupt Init
+        HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 5, 0);
+        HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
     }
 }
 
@@ -512,6 +880,10 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
 
         // ADC1 interrupt DeInit
         HAL_NVIC_DisableIRQ(ADC1_2_IRQn);
+
+        // DMA DeInit
+        HAL_DMA_DeInit(hadc->DMA_Handle);
+        HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
     }
 }
 
@@ -638,10 +1010,50 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef* hspi)
  */
 void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base)
 {
+    GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+
     if(TIM1 == htim_base->Instance)
     {
         // Peripheral clock enable
         __HAL_RCC_TIM1_CLK_ENABLE();
+        __HAL_RCC_DMA1_CLK_ENABLE();
+
+        // DMA interrupt Init
+        HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 5, 0);
+        HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+    }
+    else if(TIM2 == htim_base->Instance)
+    {
+        // Peripheral clock enable
+        __HAL_RCC_TIM2_CLK_ENABLE();
+
+        // Timer service software interrupt, TIM2 itself raises none
+        HAL_NVIC_SetPriority(TIM2_IRQn, 5, 0);
+        HAL_NVIC_EnableIRQ(TIM2_IRQn);
+    }
+    else if(TIM3 == htim_base->Instance)
+    {
+        // Peripheral clock enable
+        __HAL_RCC_TIM3_CLK_ENABLE();
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+
+        /* TIM3 GPIO Configuration
+         *
+         *   PB4 ---> TIM3_CH1
+         *
+         * The partial remap also moves CH3 and CH4 to PB0 and PB1,
+         * their outputs stay disabled.
+         */
+        GPIO_InitStruct.Pin  = GPIO_PIN_4;
+        GPIO_InitStruct.Mode = GPIO_MODE_AF_INPUT;
+        GPIO_InitStruct.Pull = GPIO_PULLUP;
+        HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+        __HAL_AFIO_REMAP_TIM3_PARTIAL();
+
+        // TIM3 interrupt Init
+        HAL_NVIC_SetPriority(TIM3_IRQn, 0, 0);
+        HAL_NVIC_EnableIRQ(TIM3_IRQn);
     }
 }
 
@@ -665,6 +1077,18 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef* htim)
         GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
         HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
     }
+    else if(TIM2 == htim->Instance)
+    {
+        __HAL_RCC_GPIOA_CLK_ENABLE();
+        /* TIM2 GPIO Configuration
+         *
+         *   PA3 ---> TIM2_CH4
+         */
+        GPIO_InitStruct.Pin   = DMD_SCLK_Pin;
+        GPIO_InitStruct.Mode  = GPIO_MODE_AF_PP;
+        GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+        HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    }
 }
 
 /**
@@ -677,6 +1101,29 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* htim_base)
     {
         // Peripheral clock disable
         __HAL_RCC_TIM1_CLK_DISABLE();
+
+        // DMA DeInit
+        HAL_DMA_DeInit(htim_base->hdma[TIM_DMA_ID_UPDATE]);
+        HAL_NVIC_DisableIRQ(DMA1_Channel5_IRQn);
+    }
+    else if(TIM2 == htim_base->Instance)
+    {
+        // Peripheral clock disable
+        __HAL_RCC_TIM2_CLK_DISABLE();
+
+        HAL_GPIO_DeInit(GPIOA, DMD_SCLK_Pin);
+
+        HAL_NVIC_DisableIRQ(TIM2_IRQn);
+    }
+    else if(TIM3 == htim_base->Instance)
+    {
+        // Peripheral clock disable
+        __HAL_RCC_TIM3_CLK_DISABLE();
+
+        HAL_GPIO_DeInit(GPIOB, GPIO_PIN_4);
+
+        // TIM3 interrupt DeInit
+        HAL_NVIC_DisableIRQ(TIM3_IRQn);
     }
 }
 
@@ -699,6 +1146,10 @@ void HAL_RTC_MspInit(RTC_HandleTypeDef* hrtc)
         // RTC interrupt Init
         HAL_NVIC_SetPriority(RTC_IRQn, 5, 0);
         HAL_NVIC_EnableIRQ(RTC_IRQn);
+
+        // RTC alarm interrupt Init (wake-up from STOP mode)
+        HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 5, 0);
+        HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
     }
 }
 
@@ -715,6 +1166,7 @@ void HAL_RTC_MspDeInit(RTC_HandleTypeDef* hrtc)
 
         // RTC interrupt DeInit
         HAL_NVIC_DisableIRQ(RTC_IRQn);
+        HAL_NVIC_DisableIRQ(RTC_Alarm_IRQn);
     }
 }
 
@@ -861,12 +1313,59 @@ void ADC1_2_IRQHandler(void)
     HAL_ADC_IRQHandler(&hadc1);
 }
 
+/**
+ * @brief DMA1 channel 1 global interrupt handler (ADC 1)
+ */
+void DMA1_Channel1_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_adc1);
+}
+
+/**
+ * @brief DMA1 channel 5 global interrupt handler (TIM1 update)
+ */
+void DMA1_Channel5_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_tim1_up);
+}
+
+/**
+ * @brief TIM2 global interrupt handler
+ * @note  Only set pending by the timer service alarm (TIM3 channel 4).
+ */
+void TIM2_IRQHandler(void)
+{
+    Timer_Expire();
+}
+
+/**
+ * @brief TIM3 global interrupt handler
+ */
+void TIM3_IRQHandler(void)
+{
+    HAL_TIM_IRQHandler(&htim3);
+}
+
+#ifdef USE_BUTTONS
+/**
+ * @brief EXTI line[15:10] interrupt handler (buttons)
+ * @note  Also set pending by the debounce timer.
+ */
+void EXTI15_10_IRQHandler(void)
+{
+    __HAL_GPIO_EXTI_CLEAR_IT(BUTTON_A_Pin | BUTTON_B_Pin | BUTTON_C_Pin);
+    Button_Update();
+}
+#endif
+
 /**
  * @brief TIM4 global interrupt handler
  */
 void TIM4_IRQHandler(void)
 {
+    TRACE_IRQ_ENTER(TRACE_IRQ_TIM4);
     HAL_TIM_IRQHandler(&htim4);
+    TRACE_IRQ_EXIT(TRACE_IRQ_TIM4);
 }
 
 /**
@@ -874,7 +1373,9 @@ void TIM4_IRQHandler(void)
  */
 void I2C2_EV_IRQHandler(void)
 {
+    TRACE_IRQ_ENTER(TRACE_IRQ_I2C2_EV);
     HAL_I2C_EV_IRQHandler(&hi2c2);
+    TRACE_IRQ_EXIT(TRACE_IRQ_I2C2_EV);
 }
 
 /**
@@ -882,7 +1383,9 @@ void I2C2_EV_IRQHandler(void)
  */
 void I2C2_ER_IRQHandler(void)
 {
+    TRACE_IRQ_ENTER(TRACE_IRQ_I2C2_ER);
     HAL_I2C_ER_IRQHandler(&hi2c2);
+    TRACE_IRQ_EXIT(TRACE_IRQ_I2C2_ER);
 }
 
 /**
@@ -890,7 +1393,9 @@ void I2C2_ER_IRQHandler(void)
  */
 void SPI1_IRQHandler(void)
 {
+    TRACE_IRQ_ENTER(TRACE_IRQ_SPI1);
     HAL_SPI_IRQHandler(&hspi1);
+    TRACE_IRQ_EXIT(TRACE_IRQ_SPI1);
 }
 
 /**
@@ -898,5 +1403,17 @@ void SPI1_IRQHandler(void)
  */
 void RTC_IRQHandler(void)
 {
+    TRACE_IRQ_ENTER(TRACE_IRQ_RTC);
     HAL_RTCEx_RTCIRQHandler(&hrtc);
+    TRACE_IRQ_EXIT(TRACE_IRQ_RTC);
+}
+
+/**
+ * @brief RTC alarm interrupt handler (EXTI line 17)
+ */
+void RTC_Alarm_IRQHandler(void)
+{
+    TRACE_IRQ_ENTER(TRACE_IRQ_RTC);
+    HAL_RTC_AlarmIRQHandler(&hrtc);
+    TRACE_IRQ_EXIT(TRACE_IRQ_RTC);
 }
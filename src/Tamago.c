@@ -36,20 +36,49 @@
  * @endcode
  */
 
+#include "Analog.h"
 #include "Animation.h"
 #include "BMP180.h"
+#include "Button.h"
 #include "Clock.h"
+#include "DCF77.h"
 #include "DMD.h"
 #include "FreeRTOS.h"
+#include "Job.h"
 #include "LifeCycle.h"
 #include "M24FC256.h"
+#include "MCAL.h"
+#include "Monitor.h"
+#include "Power.h"
+#include "Profile.h"
+#include "Record.h"
+#include "Sound.h"
 #include "Tamago.h"
+#include "Trace.h"
+#include "Transition.h"
 #include "cmsis_os.h"
 #include "task.h"
 
-static TaskHandle_t _hUpdateThread; ///< Update thread handle
+#define TAMAGO_LOW_BATTERY_BRIGHTNESS  64U ///< Max. display brightness on low battery
+#define TAMAGO_TRANSITION_FRAMES       16U ///< Frames of a screen transition
+#define TAMAGO_TRANSITION_PERIOD       20U ///< Update cycles (approx. ms) per transition frame
+#define TAMAGO_UPDATE_STACK_SIZE      256U ///< Update thread stack size in words, see custom_budget_stack
 
-static void _SetAnimationByStats(Stats* pstStats);
+static TaskHandle_t _hUpdateThread;                                    ///< Update thread handle
+static StaticTask_t _stUpdateThreadTCB;                                ///< Update thread control block
+static StackType_t  _au32UpdateThreadStack[TAMAGO_UPDATE_STACK_SIZE]; ///< Update thread stack
+
+#ifdef USE_ANALOG
+static void _AdaptToAnalog(void);
+#endif
+#ifdef USE_BUTTONS
+static void _HandleButton(const ButtonEvent* pstEvent);
+#endif
+#ifdef USE_SOUND
+static void _PlaySoundByStats(Stats* pstStats, uint32_t u32Changes);
+#endif
+static bool _Sample(void);
+static void _SetAnimationByStats(Stats* pstStats, uint32_t u32Changes);
 static void _UpdateThread(void* pArg);
 
 /**
@@ -60,8 +89,15 @@ static void _UpdateThread(void* pArg);
  */
 int Tamago_Init(void)
 {
-    int        nError  = 0;
-    BaseType_t nStatus = pdPASS;
+    int nError = 0;
+
+    #ifdef USE_PROFILING
+    Profile_Init();
+    #endif
+
+    #ifdef USE_TRACE
+    Trace_Init();
+    #endif
 
     #ifdef USE_BMP180
     nError = BMP180_Init();
@@ -71,18 +107,66 @@ int Tamago_Init(void)
     }
     #endif
 
+    #ifdef USE_RECORD
+    nError = Record_Init();
+    if (0 != nError)
+    {
+        return -1;
+    }
+    #endif
+
     Animation_Init();
-    LifeCycle_Init();
 
-    nStatus = xTaskCreate(
+    #ifdef USE_DCF77
+    DCF77_Init();
+    #endif
+
+    #ifdef USE_ANALOG
+    nError = Analog_Init();
+    if (0 != nError)
+    {
+        return -1;
+    }
+    #endif
+
+    nError = Job_Init();
+    if (0 != nError)
+    {
+        return -1;
+    }
+
+    nError = LifeCycle_Init();
+    if (0 != nError)
+    {
+        return -1;
+    }
+
+    #ifdef USE_RUNTIME_STATS
+    nError = Monitor_Init();
+    if (0 != nError)
+    {
+        return -1;
+    }
+    #endif
+
+    #ifdef USE_BUTTONS
+    nError = Button_Init();
+    if (0 != nError)
+    {
+        return -1;
+    }
+    #endif
+
+    _hUpdateThread = xTaskCreateStatic(
         _UpdateThread,
         "Update",
-        configMINIMAL_STACK_SIZE,
+        TAMAGO_UPDATE_STACK_SIZE,
         NULL,
         osPriorityNormal,
-        &_hUpdateThread);
+        _au32UpdateThreadStack,
+        &_stUpdateThreadTCB);
 
-    if (pdPASS == nStatus)
+    if (NULL != _hUpdateThread)
     {
         osKernelStart();
     }
@@ -95,116 +179,397 @@ int Tamago_Init(void)
 }
 
 /**
- * @brief Update thread
- * @param pArg: Unused
+ * @brief   Update thread
+ * @details While the pet sleeps, the display is off and the thread
+ *          wakes up at least every @ref POWER_IDLE_PERIOD to sample
+ *          the sensors, so the pet's wake-up is noticed within that
+ *          period.  The MCU enters STOP mode in between, except during
+ *          a time signal window which lasts until a frame has been
+ *          taken.  A button press shows the display for
+ *          @ref POWER_DISPLAY_TIMEOUT.
+ * @param   pArg: Unused
  */
 static void _UpdateThread(void* pArg)
 {
-    Stats*   pstStats = LifeCycle_GetStats();
-    uint16_t u16Cnt   = 0;
+    Stats*   pstStats        = LifeCycle_GetStats();
+    uint32_t u32Changes      = LIFECYCLE_CHANGED_ALL;
+    uint32_t u32DisplayUntil = 0;
+    uint16_t u16Cnt          = 0;
+    bool     bSynced         = false;
+
+    #ifdef USE_BUTTONS
+    ButtonEvent stEvent;
+    #ifdef USE_PROFILING
+    uint32_t    u32EventTicks = 0;
+    uint8_t     u8Scanlines   = 0;
+    #endif
+    #endif
 
     DMD_SetBuffer(Clock_GetBufferAddr());
     //DMD_SetBuffer(Animation_GetBufferAddr());
 
+    LifeCycle_Subscribe();
+
     while (1)
     {
-        _SetAnimationByStats(pstStats);
+        u32Changes |= LifeCycle_TakeChanges(0);
+        if (0 != u32Changes)
+        {
+            _SetAnimationByStats(pstStats, u32Changes);
+            #ifdef USE_SOUND
+            _PlaySoundByStats(pstStats, u32Changes);
+            #endif
+            u32Changes = 0;
+        }
 
-        if (500 <= u16Cnt)
+        // Display is off while the pet sleeps, unless there has been
+        // input recently
+        if (LifeCycle_IsFlagSet(IS_SLEEPING) && (0 <= (int32_t)(MCAL_GetTick() - u32DisplayUntil)))
         {
-            // These operations are executed approx. every 500ms
-            #ifdef USE_BMP180
-            int8_t s8Temp = 0;
-            BMP180_ReadTemperature(&s8Temp);
-            Clock_SetTemperature(s8Temp);
+            uint32_t u32Timeout = POWER_IDLE_PERIOD;
+            bool     bWindow    = false;
+
+            DMD_OE_RowsOff();
+            Power_SetDisplay(false);
+
+            #ifdef USE_DCF77
+            uint8_t u8Hours;
+            uint8_t u8Minutes;
+            uint8_t u8Seconds;
+
+            if (0 == RTC_GetTime(&u8Hours, &u8Minutes, &u8Seconds))
+            {
+                bWindow = Power_IsReceptionWindow((u8Hours * 3600UL) + (u8Minutes * 60UL) + u8Seconds);
+            }
+            if (! bWindow)
+            {
+                bSynced = false;
+            }
+            #endif
+
+            // Keep TIM3 running for the decoder until a frame has
+            // been taken
+            Power_SetReception(bWindow && (! bSynced));
+            if (bWindow && (! bSynced))
+            {
+                u32Timeout = 500;
+            }
+
+            #ifdef USE_BUTTONS
+            if (Button_GetEvent(&stEvent, u32Timeout))
+            {
+                // The first press only shows the display
+                u32DisplayUntil = MCAL_GetTick() + POWER_DISPLAY_TIMEOUT;
+                u16Cnt          = 500;
+            }
+            #else
+            osDelay(u32Timeout);
             #endif
 
+            if (_Sample())
+            {
+                bSynced = true;
+            }
+            continue;
+        }
+
+        if (! Power_IsDisplayOn())
+        {
+            Power_SetReception(false);
+            Power_SetDisplay(true);
+        }
+
+        if (500 <= u16Cnt)
+        {
+            // These operations are executed approx. every 500ms
+            _Sample();
             Animation_Update();
             u16Cnt = 0;
         }
 
         Clock_Update();
+
+        if (Transition_IsRunning() && (0 == (u16Cnt % TAMAGO_TRANSITION_PERIOD)))
+        {
+            DMD_SetBuffer(Transition_Step());
+        }
+
         DMD_Update();
 
+        #ifdef USE_BUTTONS
+        #ifdef USE_PROFILING
+        // Input latency: from the button edge until the change has been
+        // scanned out completely
+        if (0 != u8Scanlines)
+        {
+            u8Scanlines--;
+            if (0 == u8Scanlines)
+            {
+                PROFILE_SINCE(PROFILE_INPUT_LATENCY, u32EventTicks);
+            }
+        }
+        #endif
+
+        // Wakes up immediately on input instead of waiting for the next
+        // tick
+        if (Button_GetEvent(&stEvent, 1))
+        {
+            if (LifeCycle_IsFlagSet(IS_SLEEPING))
+            {
+                u32DisplayUntil = MCAL_GetTick() + POWER_DISPLAY_TIMEOUT;
+            }
+            _HandleButton(&stEvent);
+
+            #ifdef USE_PROFILING
+            if (0 == u8Scanlines)
+            {
+                u32EventTicks = stEvent.u32Ticks;
+                u8Scanlines   = DMD_SCANLINES;
+            }
+            #endif
+        }
+        #else
         osDelay(1);
+        #endif
+
         u16Cnt++;
     }
 }
 
+#ifdef USE_ANALOG
 /**
- * @brief Set animation by pet statistics
- * @param pstStats
- *        Pointer to pet statistics
+ * @brief Adapt to ambient light and battery state
+ * @details The display brightness follows the ambient light.  On low
+ *          battery, it is limited to save power; a message and an
+ *          attention call are shown once.
  */
-static void _SetAnimationByStats(Stats* pstStats)
+static void _AdaptToAnalog(void)
 {
-    switch (pstStats->eEvolution)
-    {
-        case EGG:
-            Animation_Set(IDLE_EGG);
-            break;
-        case BABYTCHI:
-            Animation_Set(IDLE_BABYTCHI);
-            break;
-        case MARUTCHI:
-            Animation_Set(IDLE_MARUTCHI);
-            break;
-        case TAMATCHI:
-            Animation_Set(IDLE_TAMATCHI);
-            break;
-        case KUCHITAMATCHI:
-            Animation_Set(IDLE_KUCHITAMATCHI);
-            break;
-        case MAMETCHI:
-            Animation_Set(IDLE_MAMETCHI);
-            break;
-        case GINJIROTCHI:
-            Animation_Set(IDLE_GINJIROTCHI);
-            break;
-        case MASKUTCHI:
-            Animation_Set(IDLE_MASKUTCHI);
-            break;
-        case KUCHIPATCHI:
-            Animation_Set(IDLE_KUCHIPATCHI);
-            break;
-        case NYOROTCHI:
-            Animation_Set(IDLE_NYOROTCHI);
-            break;
-        case TARAKOTCHI:
-            Animation_Set(IDLE_TARAKOTCHI);
-            break;
-        case OYAJITCHI:
-            Animation_Set(IDLE_OYAJITCHI);
-            break;
-        case OBAKETCHI:
-            Animation_Set(IDLE_OBAKETCHI);
-            break;
-    }
-
-    if (LifeCycle_IsFlagSet(HAS_POOPED))
-    {
-        Animation_ShowIcon(ICON_POO, true);
+    static bool bLow = false;
+    uint32_t    u32Level;
+
+    Analog_Process();
+    u32Level = ((uint32_t)Analog_GetAmbientLight() * DMD_BRIGHTNESS_MAX) / ANALOG_FULL_SCALE;
+
+    if (Analog_IsBatteryLow())
+    {
+        if (TAMAGO_LOW_BATTERY_BRIGHTNESS < u32Level)
+        {
+            u32Level = TAMAGO_LOW_BATTERY_BRIGHTNESS;
+        }
+
+        if (! bLow)
+        {
+            Clock_ShowText("Battery low");
+            #ifdef USE_SOUND
+            Sound_Play(SOUND_ATTENTION);
+            #endif
+        }
+        bLow = true;
     }
     else
     {
-        Animation_ShowIcon(ICON_POO, false);
+        bLow = false;
     }
 
-    if (LifeCycle_IsFlagSet(IS_SICK))
+    DMD_SetBrightness((uint8_t)u32Level);
+}
+#endif
+
+#ifdef USE_BUTTONS
+/**
+ * @brief Handle button event
+ * @details
+ *        - A + B: toggle between clock and pet
+ *        - Others: care actions, see @ref LifeCycle_Care
+ * @param pstEvent
+ *        Pointer to button event
+ */
+static void _HandleButton(const ButtonEvent* pstEvent)
+{
+    static bool bShowPet = false;
+
+    #ifdef USE_SOUND
+    Sound_Play(SOUND_BEEP);
+    #endif
+
+    if (BUTTON_COMBO == pstEvent->u8Gesture)
     {
-        Animation_ShowIcon(ICON_SKULL, true);
+        if ((BUTTON_A | BUTTON_B) == pstEvent->u8Buttons)
+        {
+            bShowPet = ! bShowPet;
+            if (bShowPet)
+            {
+                Transition_Start(TRANSITION_SLIDE, Clock_GetBufferAddr(), Animation_GetBufferAddr(), TAMAGO_TRANSITION_FRAMES);
+            }
+            else
+            {
+                Transition_Start(TRANSITION_DISSOLVE, Animation_GetBufferAddr(), Clock_GetBufferAddr(), TAMAGO_TRANSITION_FRAMES);
+            }
+            DMD_SetBuffer(Transition_GetBufferAddr());
+        }
+        return;
     }
-    else
+
+    LifeCycle_Care(pstEvent->u8Gesture, pstEvent->u8Buttons);
+}
+#endif
+
+#ifdef USE_SOUND
+/**
+ * @brief Play sound by pet statistics
+ * @param pstStats
+ *        Pointer to pet statistics
+ * @param u32Changes
+ *        Changed fields (LIFECYCLE_CHANGED_*)
+ */
+static void _PlaySoundByStats(Stats* pstStats, uint32_t u32Changes)
+{
+    static bool     bStarted = false;
+    static uint16_t u16Flags = 0;
+    uint16_t        u16Raised;
+
+    u16Raised = pstStats->u16Flags & ~u16Flags;
+    u16Flags  = pstStats->u16Flags;
+
+    // Stay silent on start-up
+    if (! bStarted)
     {
-        Animation_ShowIcon(ICON_SKULL, false);
+        bStarted = true;
+        return;
     }
 
-    if (LifeCycle_IsFlagSet(IS_SLEEPING))
+    if (u32Changes & LIFECYCLE_CHANGED_EVOLUTION)
     {
-        Animation_ShowIcon(ICON_SLEEP, true);
+        if (OBAKETCHI == pstStats->eEvolution)
+        {
+            Sound_Play(SOUND_DEATH);
+        }
+        else
+        {
+            Sound_Play(SOUND_EVOLUTION);
+        }
     }
-    else
+    else if (u16Raised & (1U << IS_CALLING))
     {
-        Animation_ShowIcon(ICON_SLEEP, false);
+        Sound_Play(SOUND_ATTENTION);
+    }
+}
+#endif
+
+/**
+ * @brief  Sample sensors and time signal, flush the record
+ * @return A time signal frame has been taken
+ */
+static bool _Sample(void)
+{
+    bool bSynced = false;
+
+    #ifdef USE_BMP180
+    int8_t s8Temp = 0;
+    BMP180_ReadTemperature(&s8Temp);
+    Clock_SetTemperature(s8Temp);
+    #endif
+
+    #ifdef USE_DCF77
+    bSynced = DCF77_Synchronise();
+    #endif
+
+    #ifdef USE_ANALOG
+    _AdaptToAnalog();
+    #endif
+
+    #ifdef USE_RECORD
+    Record_Flush();
+    #endif
+
+    return bSynced;
+}
+
+/**
+ * @brief Set animation by pet statistics
+ * @param pstStats
+ *        Pointer to pet statistics
+ * @param u32Changes
+ *        Changed fields (LIFECYCLE_CHANGED_*)
+ */
+static void _SetAnimationByStats(Stats* pstStats, uint32_t u32Changes)
+{
+    if (u32Changes & LIFECYCLE_CHANGED_EVOLUTION)
+    {
+        switch (pstStats->eEvolution)
+        {
+            case EGG:
+                Animation_Set(IDLE_EGG);
+                break;
+            case BABYTCHI:
+                Animation_Set(IDLE_BABYTCHI);
+                break;
+            case MARUTCHI:
+                Animation_Set(IDLE_MARUTCHI);
+                break;
+            case TAMATCHI:
+                Animation_Set(IDLE_TAMATCHI);
+                break;
+            case KUCHITAMATCHI:
+                Animation_Set(IDLE_KUCHITAMATCHI);
+                break;
+            case MAMETCHI:
+                Animation_Set(IDLE_MAMETCHI);
+                break;
+            case GINJIROTCHI:
+                Animation_Set(IDLE_GINJIROTCHI);
+                break;
+            case MASKUTCHI:
+                Animation_Set(IDLE_MASKUTCHI);
+                break;
+            case KUCHIPATCHI:
+                Animation_Set(IDLE_KUCHIPATCHI);
+                break;
+            case NYOROTCHI:
+                Animation_Set(IDLE_NYOROTCHI);
+                break;
+            case TARAKOTCHI:
+                Animation_Set(IDLE_TARAKOTCHI);
+                break;
+            case OYAJITCHI:
+                Animation_Set(IDLE_OYAJITCHI);
+                break;
+            case OBAKETCHI:
+                Animation_Set(IDLE_OBAKETCHI);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (u32Changes & LIFECYCLE_CHANGED_FLAGS)
+    {
+        if (LifeCycle_IsFlagSet(HAS_POOPED))
+        {
+            Animation_ShowIcon(ICON_POO, true);
+        }
+        else
+        {
+            Animation_ShowIcon(ICON_POO, false);
+        }
+
+        if (LifeCycle_IsFlagSet(IS_SICK))
+        {
+            Animation_ShowIcon(ICON_SKULL, true);
+        }
+        else
+        {
+            Animation_ShowIcon(ICON_SKULL, false);
+        }
+
+        if (LifeCycle_IsFlagSet(IS_SLEEPING))
+        {
+            Animation_ShowIcon(ICON_SLEEP, true);
+        }
+        else
+        {
+            Animation_ShowIcon(ICON_SLEEP, false);
+        }
     }
 }
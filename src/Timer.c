@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Timer.c
+ * @brief     Microsecond timer service
+ * @details   One-shot and periodic timers on the TIM3 microsecond clock
+ *            (see @ref MCAL_GetMicroseconds).  The timers are kept in a
+ *            queue sorted by deadline; only the earliest one is armed
+ *            on TIM3 channel 4 (see @ref MCAL_StartAlarm).  Deadlines
+ *            further away than the 16-bit compare range simply match
+ *            early and are re-armed.
+ *
+ *            TIM3 runs above the FreeRTOS syscall priority, so the
+ *            compare interrupt does not run the callbacks itself but
+ *            sets a software interrupt pending, which calls
+ *            @ref Timer_Expire.  Callbacks may therefore use the
+ *            FromISR API, e.g. to wake a task.
+ *
+ *            The timer entries are allocated by the caller and must
+ *            stay valid while they are queued.  TIM3 stops in STOP
+ *            mode, which is not entered while a timer is pending.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "MCAL.h"
+#include "Timer.h"
+#include "semphr.h"
+#include "task.h"
+
+#define TIMER_MAX_DELAY 0x7FFFFFFFUL ///< Max. delay and period in µs (wrap-around safe)
+
+/**
+ * @struct TimerData
+ * @brief  Timer service data
+ */
+typedef struct
+{
+    TimerEntry* pstHead; ///< Deadline queue, earliest first
+
+} TimerData;
+
+/**
+ * @var   _stTimer
+ * @brief Timer service private data
+ */
+static TimerData _stTimer = { 0 };
+
+static void _Arm(void);
+static void _Insert(TimerEntry* pstTimer);
+static bool _IsBefore(uint32_t u32A, uint32_t u32B);
+static void _Remove(TimerEntry* pstTimer);
+static void _Wake(void* pvArg);
+
+/**
+ * @brief Wait for the given time
+ * @note  Short delays and delays before the scheduler has been started
+ *        busy-wait; otherwise the calling task is blocked and other
+ *        tasks may run.  If the timer cannot be started, the delay
+ *        busy-waits as well, so it never ends early.  Reentrant, every
+ *        caller has its own timer.
+ * @param u32DelayInUs
+ *        Delay in µs
+ */
+void Timer_Delay(uint32_t u32DelayInUs)
+{
+    StaticSemaphore_t stSemaphore;
+    SemaphoreHandle_t hDone;
+    TimerEntry        stTimer = { 0 };
+    uint32_t          u32Start;
+
+    if ((TIMER_SPIN_LIMIT < u32DelayInUs) && (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()))
+    {
+        hDone = xSemaphoreCreateBinaryStatic(&stSemaphore);
+
+        if (0 == Timer_Start(&stTimer, u32DelayInUs, 0, _Wake, hDone))
+        {
+            xSemaphoreTake(hDone, portMAX_DELAY);
+            return;
+        }
+    }
+
+    u32Start = MCAL_GetMicroseconds();
+    while (u32DelayInUs > (MCAL_GetMicroseconds() - u32Start));
+}
+
+/**
+ * @brief Run expired timers and arm the next one
+ * @note  Called from the timer service software interrupt.
+ */
+void Timer_Expire(void)
+{
+    for (;;)
+    {
+        UBaseType_t   uxMask   = taskENTER_CRITICAL_FROM_ISR();
+        TimerEntry*   pstTimer = _stTimer.pstHead;
+        uint32_t      u32Now   = MCAL_GetMicroseconds();
+        TimerCallback pfnCallback;
+        void*         pvArg;
+
+        if ((NULL == pstTimer) || _IsBefore(u32Now, pstTimer->u32Deadline))
+        {
+            _Arm();
+            taskEXIT_CRITICAL_FROM_ISR(uxMask);
+            return;
+        }
+
+        _Remove(pstTimer);
+
+        // Periods missed in between are dropped
+        if (0 != pstTimer->u32Period)
+        {
+            pstTimer->u32Deadline += pstTimer->u32Period;
+            if (! _IsBefore(u32Now, pstTimer->u32Deadline))
+            {
+                pstTimer->u32Deadline = u32Now + pstTimer->u32Period;
+            }
+            _Insert(pstTimer);
+        }
+
+        pfnCallback = pstTimer->pfnCallback;
+        pvArg       = pstTimer->pvArg;
+        taskEXIT_CRITICAL_FROM_ISR(uxMask);
+
+        pfnCallback(pvArg);
+    }
+}
+
+/**
+ * @brief  Check if any timer is pending
+ * @return Boolean state
+ */
+bool Timer_IsPending(void)
+{
+    return (NULL != _stTimer.pstHead);
+}
+
+/**
+ * @brief  Start timer
+ * @note   A timer which is already running is restarted.  May be called
+ *         from tasks and from interrupts at or below the FreeRTOS
+ *         syscall priority, including timer callbacks.
+ * @param  pstTimer
+ *         Pointer to timer entry
+ * @param  u32DelayInUs
+ *         Time until the first expiry in µs
+ * @param  u32PeriodInUs
+ *         Period in µs, 0: one-shot
+ * @param  pfnCallback
+ *         Called on expiry
+ * @param  pvArg
+ *         Callback argument
+ * @return Error code
+ * @retval  0: OK
+ * @retval -1: Error
+ */
+int Timer_Start(TimerEntry* pstTimer, uint32_t u32DelayInUs, uint32_t u32PeriodInUs, TimerCallback pfnCallback, void* pvArg)
+{
+    UBaseType_t uxMask;
+
+    if ((NULL == pstTimer) || (NULL == pfnCallback))
+    {
+        return -1;
+    }
+
+    if ((TIMER_MAX_DELAY < u32DelayInUs) || (TIMER_MAX_DELAY < u32PeriodInUs))
+    {
+        return -1;
+    }
+
+    uxMask = taskENTER_CRITICAL_FROM_ISR();
+
+    if (pstTimer->bQueued)
+    {
+        _Remove(pstTimer);
+    }
+
+    pstTimer->pfnCallback = pfnCallback;
+    pstTimer->pvArg       = pvArg;
+    pstTimer->u32Period   = u32PeriodInUs;
+    pstTimer->u32Deadline = MCAL_GetMicroseconds() + u32DelayInUs;
+
+    _Insert(pstTimer);
+    _Arm();
+
+    taskEXIT_CRITICAL_FROM_ISR(uxMask);
+
+    return 0;
+}
+
+/**
+ * @brief Stop timer
+ * @note  Nothing happens if the timer is not running.  The callback
+ *        may still be running when this function returns.
+ * @param pstTimer
+ *        Pointer to timer entry
+ */
+void Timer_Stop(TimerEntry* pstTimer)
+{
+    UBaseType_t uxMask;
+
+    if (NULL == pstTimer)
+    {
+        return;
+    }
+
+    uxMask = taskENTER_CRITICAL_FROM_ISR();
+
+    if (pstTimer->bQueued)
+    {
+        _Remove(pstTimer);
+        _Arm();
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(uxMask);
+}
+
+/**
+ * @brief Arm the hardware timer for the earliest deadline
+ * @note  Must be called with the queue locked.
+ */
+static void _Arm(void)
+{
+    if (NULL == _stTimer.pstHead)
+    {
+        MCAL_StopAlarm();
+    }
+    else
+    {
+        MCAL_StartAlarm(_stTimer.pstHead->u32Deadline);
+    }
+}
+
+/**
+ * @brief Insert timer into the deadline queue
+ * @note  Timers with the same deadline expire in the order they have
+ *        been inserted.
+ * @param pstTimer
+ *        Pointer to timer entry
+ */
+static void _Insert(TimerEntry* pstTimer)
+{
+    TimerEntry** ppstLink = &_stTimer.pstHead;
+
+    while ((NULL != *ppstLink) && (! _IsBefore(pstTimer->u32Deadline, (*ppstLink)->u32Deadline)))
+    {
+        ppstLink = &(*ppstLink)->pstNext;
+    }
+
+    pstTimer->pstNext = *ppstLink;
+    pstTimer->bQueued = true;
+    *ppstLink         = pstTimer;
+}
+
+/**
+ * @brief  Compare two points in time
+ * @param  u32A
+ *         Time in µs
+ * @param  u32B
+ *         Time in µs
+ * @return true if u32A is before u32B
+ */
+static bool _IsBefore(uint32_t u32A, uint32_t u32B)
+{
+    return (0 > (int32_t)(u32A - u32B));
+}
+
+/**
+ * @brief Remove timer from the deadline queue
+ * @param pstTimer
+ *        Pointer to timer entry
+ */
+static void _Remove(TimerEntry* pstTimer)
+{
+    TimerEntry** ppstLink = &_stTimer.pstHead;
+
+    while (NULL != *ppstLink)
+    {
+        if (pstTimer == *ppstLink)
+        {
+            *ppstLink = pstTimer->pstNext;
+            break;
+        }
+        ppstLink = &(*ppstLink)->pstNext;
+    }
+
+    pstTimer->pstNext = NULL;
+    pstTimer->bQueued = false;
+}
+
+/**
+ * @brief Wake task blocked in Timer_Delay()
+ * @param pvArg
+ *        Semaphore handle
+ */
+static void _Wake(void* pvArg)
+{
+    BaseType_t xWoken = pdFALSE;
+
+    xSemaphoreGiveFromISR((SemaphoreHandle_t)pvArg, &xWoken);
+    portYIELD_FROM_ISR(xWoken);
+}
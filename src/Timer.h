@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Timer.h
+ * @brief Microsecond timer service
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TIMER_SPIN_LIMIT
+    #define TIMER_SPIN_LIMIT 50U ///< Delays up to this many µs busy-wait instead of blocking
+#endif
+
+/**
+ * @brief Timer callback
+ * @note  Called from the timer interrupt (FreeRTOS syscall priority);
+ *        only the FromISR API may be used.
+ */
+typedef void (*TimerCallback)(void* pvArg);
+
+/**
+ * @struct TimerEntry
+ * @brief  Timer, allocated by the caller
+ */
+typedef struct TimerEntry
+{
+    struct TimerEntry* pstNext;     ///< Next timer in the deadline queue
+    TimerCallback      pfnCallback; ///< Called on expiry
+    void*              pvArg;       ///< Callback argument
+    uint32_t           u32Deadline; ///< Expiry time in µs (@ref MCAL_GetMicroseconds)
+    uint32_t           u32Period;   ///< Period in µs, 0: one-shot
+    bool               bQueued;     ///< Timer is in the deadline queue
+
+} TimerEntry;
+
+void Timer_Delay(uint32_t u32DelayInUs);
+void Timer_Expire(void);
+bool Timer_IsPending(void);
+int  Timer_Start(TimerEntry* pstTimer, uint32_t u32DelayInUs, uint32_t u32PeriodInUs, TimerCallback pfnCallback, void* pvArg);
+void Timer_Stop(TimerEntry* pstTimer);
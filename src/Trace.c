@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Trace.c
+ * @brief     Event trace buffer
+ * @details   Records task switches (FreeRTOS trace hooks), entry and
+ *            exit of the SPI1, I2C2, RTC and TIM4 interrupt handlers
+ *            and custom markers with a DWT cycle time stamp into a ring
+ *            buffer, which always holds the most recent
+ *            @ref TRACE_BUFFER_EVENTS events.
+ *
+ *            Slots are claimed with an atomic increment (LDREX/STREX),
+ *            so events can be logged from tasks and interrupts without
+ *            locking.  Tracing is stopped before the buffer is read.
+ *
+ *            @ref Trace_Dump writes header and events to the ITM
+ *            stimulus port 1 (SWO); alternatively, the debugger can dump
+ *            @ref _stTrace up to apvTCB.  The host decoder (see
+ *            @ref TraceDecode.c) converts both into Chrome trace JSON.
+ *
+ *            Only built with USE_TRACE; otherwise the probes compile to
+ *            nothing.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_TRACE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "MCAL.h"
+#include "Trace.h"
+
+#if (0 != (TRACE_BUFFER_EVENTS & (TRACE_BUFFER_EVENTS - 1)))
+#error "TRACE_BUFFER_EVENTS must be a power of two"
+#endif
+
+#define TRACE_ITM_PORT 1    ///< ITM stimulus port used by @ref Trace_Dump
+#define TRACE_NO_TASK  0xFF ///< Task index of unnamed tasks
+
+/**
+ * @struct TraceData
+ * @brief  Trace buffer, header and events are laid out as dumped
+ */
+typedef struct
+{
+    TraceHeader   stHeader;                      ///< Dump header
+    TraceEvent    astEvent[TRACE_BUFFER_EVENTS]; ///< Event ring buffer
+    void*         apvTCB[TRACE_MAX_TASKS];       ///< Task control blocks by index
+    uint8_t       u8Tasks;                       ///< Number of named tasks
+    volatile bool bEnabled;                      ///< Tracing is running
+
+} TraceData;
+
+/**
+ * @var   _stTrace
+ * @brief Trace buffer
+ */
+static TraceData _stTrace = { 0 };
+
+static void _SendWord(uint32_t u32Word);
+
+/**
+ * @brief   Dump trace via SWO
+ * @details Stops tracing and writes the header and the events to the
+ *          ITM stimulus port 1.  Does nothing if the port is disabled.
+ *          Call @ref Trace_Init to restart tracing.
+ */
+void Trace_Dump(void)
+{
+    const uint32_t* pu32Data = (const uint32_t*)&_stTrace;
+    uint32_t        u32Words = (sizeof(TraceHeader) + sizeof(_stTrace.astEvent)) / sizeof(uint32_t);
+
+    Trace_Stop();
+
+    if ((0 == (ITM->TCR & ITM_TCR_ITMENA_Msk)) || (0 == (ITM->TER & (1UL << TRACE_ITM_PORT))))
+    {
+        return;
+    }
+
+    for (uint32_t u32Idx = 0; u32Idx < u32Words; u32Idx++)
+    {
+        _SendWord(pu32Data[u32Idx]);
+    }
+}
+
+/**
+ * @brief Initialise and start tracing; enables the DWT cycle counter
+ */
+void Trace_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    _stTrace.stHeader.u32Magic     = TRACE_MAGIC;
+    _stTrace.stHeader.u16Version   = TRACE_VERSION;
+    _stTrace.stHeader.u16Events    = TRACE_BUFFER_EVENTS;
+    _stTrace.stHeader.u32Head      = 0;
+    _stTrace.stHeader.u32CoreClock = SystemCoreClock;
+    _stTrace.bEnabled              = true;
+}
+
+/**
+ * @brief Log event
+ * @note  Interrupt-safe.
+ * @param eType
+ *        Event type
+ * @param u8Id
+ *        Task index, interrupt or marker
+ * @param u16Value
+ *        Marker value
+ */
+void Trace_Log(TraceType eType, uint8_t u8Id, uint16_t u16Value)
+{
+    TraceEvent* pstEvent;
+    uint32_t    u32Slot;
+
+    if (! _stTrace.bEnabled)
+    {
+        return;
+    }
+
+    u32Slot  = __atomic_fetch_add(&_stTrace.stHeader.u32Head, 1, __ATOMIC_RELAXED);
+    pstEvent = &_stTrace.astEvent[u32Slot & (TRACE_BUFFER_EVENTS - 1)];
+
+    pstEvent->u32Cycles = DWT->CYCCNT;
+    pstEvent->u8Type    = (uint8_t)eType;
+    pstEvent->u8Id      = u8Id;
+    pstEvent->u16Value  = u16Value;
+}
+
+/**
+ * @brief Stop tracing
+ */
+void Trace_Stop(void)
+{
+    _stTrace.bEnabled = false;
+}
+
+/**
+ * @brief Register task name
+ * @note  Called by traceTASK_CREATE() inside a critical section.
+ * @param pvTCB
+ *        Pointer to task control block
+ * @param pacName
+ *        Task name
+ */
+void Trace_TaskCreate(void* pvTCB, const char* pacName)
+{
+    char* pacTask;
+
+    if (TRACE_MAX_TASKS <= _stTrace.u8Tasks)
+    {
+        return;
+    }
+
+    pacTask = _stTrace.stHeader.aacTask[_stTrace.u8Tasks];
+    for (uint8_t u8Idx = 0; u8Idx < (TRACE_TASK_NAME_LEN - 1); u8Idx++)
+    {
+        pacTask[u8Idx] = pacName[u8Idx];
+        if ('\0' == pacName[u8Idx])
+        {
+            break;
+        }
+    }
+
+    _stTrace.apvTCB[_stTrace.u8Tasks] = pvTCB;
+    _stTrace.u8Tasks++;
+}
+
+/**
+ * @brief Log task switch
+ * @note  Called by traceTASK_SWITCHED_IN() from the context switch.
+ * @param pvTCB
+ *        Pointer to task control block of the new task
+ */
+void Trace_TaskSwitchedIn(void* pvTCB)
+{
+    uint8_t u8Task = TRACE_NO_TASK;
+
+    for (uint8_t u8Idx = 0; u8Idx < _stTrace.u8Tasks; u8Idx++)
+    {
+        if (pvTCB == _stTrace.apvTCB[u8Idx])
+        {
+            u8Task = u8Idx;
+            break;
+        }
+    }
+
+    Trace_Log(TRACE_EVENT_TASK_IN, u8Task, 0);
+}
+
+/**
+ * @brief Write word to ITM stimulus port
+ * @param u32Word
+ *        Word
+ */
+static void _SendWord(uint32_t u32Word)
+{
+    while (0 == ITM->PORT[TRACE_ITM_PORT].u32);
+
+    ITM->PORT[TRACE_ITM_PORT].u32 = u32Word;
+}
+
+#endif // USE_TRACE
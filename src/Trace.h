@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Trace.h
+ * @brief Event trace buffer
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define TRACE_MAGIC         0x45435254UL ///< Dump header magic ("TRCE")
+#define TRACE_VERSION       1            ///< Dump format version
+#define TRACE_MAX_TASKS     8            ///< Max. number of named tasks
+#define TRACE_TASK_NAME_LEN 16           ///< Max. task name length incl. NUL
+
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 256 ///< Buffered events, must be a power of two
+#endif
+
+/**
+ * @enum  TraceType
+ * @brief Event types
+ */
+typedef enum
+{
+    TRACE_EVENT_TASK_IN = 0, ///< Task switched in, ID is the task index
+    TRACE_EVENT_IRQ_ENTER,   ///< Interrupt handler entered, ID is @ref TraceIrq
+    TRACE_EVENT_IRQ_EXIT,    ///< Interrupt handler left, ID is @ref TraceIrq
+    TRACE_EVENT_BEGIN,       ///< Marker span started, ID is @ref TraceMarker
+    TRACE_EVENT_END,         ///< Marker span ended, ID is @ref TraceMarker
+    TRACE_EVENT_INSTANT      ///< Instant marker with value, ID is @ref TraceMarker
+
+} TraceType;
+
+/**
+ * @enum  TraceIrq
+ * @brief Traced interrupts
+ */
+typedef enum
+{
+    TRACE_IRQ_SPI1 = 0, ///< SPI1 (display)
+    TRACE_IRQ_I2C2_EV,  ///< I2C2 event (BMP180, 24FC256)
+    TRACE_IRQ_I2C2_ER,  ///< I2C2 error
+    TRACE_IRQ_RTC,      ///< RTC second and alarm
+    TRACE_IRQ_TIM4,     ///< TIM4 (HAL tick)
+    NUM_OF_TRACE_IRQS   ///< Total number of traced interrupts
+
+} TraceIrq;
+
+/**
+ * @enum  TraceMarker
+ * @brief Custom markers
+ */
+typedef enum
+{
+    TRACE_MARK_REFRESH = 0, ///< Display scanline refresh
+    TRACE_MARK_I2C_WAIT,    ///< Waiting for an I²C transfer
+    TRACE_MARK_USER,        ///< General purpose
+    NUM_OF_TRACE_MARKERS    ///< Total number of markers
+
+} TraceMarker;
+
+/**
+ * @struct TraceEvent
+ * @brief  Event (little-endian, as dumped)
+ */
+typedef struct
+{
+    uint32_t u32Cycles; ///< Time stamp in CPU cycles (wraps around)
+    uint8_t  u8Type;    ///< Event type (@ref TraceType)
+    uint8_t  u8Id;      ///< Task index, interrupt or marker
+    uint16_t u16Value;  ///< Marker value
+
+} TraceEvent;
+
+/**
+ * @struct TraceHeader
+ * @brief  Dump header
+ */
+typedef struct
+{
+    uint32_t u32Magic;                                      ///< @ref TRACE_MAGIC
+    uint16_t u16Version;                                    ///< @ref TRACE_VERSION
+    uint16_t u16Events;                                     ///< Size of the event buffer
+    uint32_t u32Head;                                       ///< Number of events ever written
+    uint32_t u32CoreClock;                                  ///< CPU clock in Hz
+    char     aacTask[TRACE_MAX_TASKS][TRACE_TASK_NAME_LEN]; ///< Task names by index
+
+} TraceHeader;
+
+#ifdef USE_TRACE
+
+#define TRACE_IRQ_ENTER(eIrq)         Trace_Log(TRACE_EVENT_IRQ_ENTER, (eIrq), 0)            ///< Log interrupt entry
+#define TRACE_IRQ_EXIT(eIrq)          Trace_Log(TRACE_EVENT_IRQ_EXIT, (eIrq), 0)             ///< Log interrupt exit
+#define TRACE_BEGIN(eMarker)          Trace_Log(TRACE_EVENT_BEGIN, (eMarker), 0)             ///< Start marker span
+#define TRACE_END(eMarker)            Trace_Log(TRACE_EVENT_END, (eMarker), 0)               ///< End marker span
+#define TRACE_MARK(eMarker, u16Value) Trace_Log(TRACE_EVENT_INSTANT, (eMarker), (u16Value)) ///< Log instant marker
+
+void Trace_Dump(void);
+void Trace_Init(void);
+void Trace_Log(TraceType eType, uint8_t u8Id, uint16_t u16Value);
+void Trace_Stop(void);
+void Trace_TaskCreate(void* pvTCB, const char* pacName);
+void Trace_TaskSwitchedIn(void* pvTCB);
+
+#else
+
+#define TRACE_IRQ_ENTER(eIrq)         ///< Compiles to nothing without USE_TRACE
+#define TRACE_IRQ_EXIT(eIrq)          ///< Compiles to nothing without USE_TRACE
+#define TRACE_BEGIN(eMarker)          ///< Compiles to nothing without USE_TRACE
+#define TRACE_END(eMarker)            ///< Compiles to nothing without USE_TRACE
+#define TRACE_MARK(eMarker, u16Value) ///< Compiles to nothing without USE_TRACE
+
+#endif // USE_TRACE
@@ -0,0 +1,547 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      TraceDecode.c
+ * @brief     Host decoder of event traces
+ * @details   Converts a trace dump (see @ref Trace.c) into Chrome trace
+ *            JSON, which can be opened in chrome://tracing or Perfetto.
+ *            The dump is either a raw memory image or a SWO capture
+ *            containing ITM packets, of which only stimulus port 1 is
+ *            decoded.
+ *
+ *            Task slices, interrupt handlers and marker spans are shown
+ *            on separate tracks, with time stamps in µs relative to the
+ *            oldest event in the buffer.
+ * @code{.unparsed}
+ * Usage: program -i trace.bin [-o trace.json]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_TRACE_DECODE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Trace.h"
+
+#define TRACE_DECODE_ITM_PORT 1 ///< ITM stimulus port of the dump
+
+/**
+ * @enum  TraceTrack
+ * @brief Chrome trace tracks (thread IDs)
+ */
+typedef enum
+{
+    TRACK_TASKS = 1, ///< Task slices
+    TRACK_IRQS,      ///< Interrupt handlers
+    TRACK_MARKERS    ///< Marker spans and instants
+
+} TraceTrack;
+
+/**
+ * @struct DecodedEvent
+ * @brief  Event with unwrapped time stamp
+ */
+typedef struct
+{
+    TraceEvent stEvent; ///< Event as dumped
+    uint64_t   u64Time; ///< Unwrapped time stamp in CPU cycles
+    size_t     uIndex;  ///< Position in the buffer
+
+} DecodedEvent;
+
+/**
+ * @struct DecodeData
+ * @brief  Decoder data
+ */
+typedef struct
+{
+    TraceHeader   stHeader;                            ///< Dump header
+    DecodedEvent* pstEvent;                            ///< Events, oldest first
+    size_t        uEvents;                             ///< Number of events
+    FILE*         phOut;                               ///< JSON output
+    uint64_t      au64IrqStart[NUM_OF_TRACE_IRQS];     ///< Start of running handlers
+    uint64_t      au64MarkStart[NUM_OF_TRACE_MARKERS]; ///< Start of running spans
+    bool          abIrqRunning[NUM_OF_TRACE_IRQS];     ///< Handler is running
+    bool          abMarkRunning[NUM_OF_TRACE_MARKERS]; ///< Span is running
+    bool          bFirst;                              ///< No JSON event written yet
+
+} DecodeData;
+
+/**
+ * @var   _stDecode
+ * @brief Decoder private data
+ */
+static DecodeData _stDecode = { 0 };
+
+/**
+ * @var   _apacIrq
+ * @brief Interrupt names
+ */
+static const char* const _apacIrq[NUM_OF_TRACE_IRQS] = {
+    "SPI1",
+    "I2C2_EV",
+    "I2C2_ER",
+    "RTC",
+    "TIM4"
+};
+
+/**
+ * @var   _apacMarker
+ * @brief Marker names
+ */
+static const char* const _apacMarker[NUM_OF_TRACE_MARKERS] = {
+    "Refresh",
+    "I2C wait",
+    "User"
+};
+
+static int         _Compare(const void* pA, const void* pB);
+static int         _Decode(const uint8_t* pu8Dump, size_t uSize, const char* pacPath);
+static size_t      _ExtractITM(uint8_t* pu8Data, size_t uSize);
+static void        _Slice(TraceTrack eTrack, const char* pacName, uint64_t u64Start, uint64_t u64End);
+static const char* _TaskName(uint8_t u8Task);
+static double      _ToMicroseconds(uint64_t u64Cycles);
+static void        _WriteJSON(void);
+
+/**
+ * @brief  Decoder entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    const char* pacIn  = NULL;
+    FILE*       phIn;
+    uint8_t*    pu8Dump;
+    long        lSize;
+    int         nOpt;
+
+    _stDecode.phOut = stdout;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "i:o:")))
+    {
+        switch (nOpt)
+        {
+            case 'i':
+                pacIn = optarg;
+                break;
+            case 'o':
+                _stDecode.phOut = fopen(optarg, "w");
+                if (NULL == _stDecode.phOut)
+                {
+                    perror(optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                pacIn = NULL;
+                break;
+        }
+    }
+
+    if (NULL == pacIn)
+    {
+        fprintf(stderr, "Usage: %s -i trace.bin [-o trace.json]\n", apcArgv[0]);
+        return EXIT_FAILURE;
+    }
+
+    phIn = fopen(pacIn, "rb");
+    if (NULL == phIn)
+    {
+        perror(pacIn);
+        return EXIT_FAILURE;
+    }
+
+    fseek(phIn, 0, SEEK_END);
+    lSize = ftell(phIn);
+    fseek(phIn, 0, SEEK_SET);
+
+    pu8Dump = malloc((0 < lSize) ? (size_t)lSize : 1);
+    if ((NULL == pu8Dump) || ((size_t)lSize != fread(pu8Dump, 1, (size_t)lSize, phIn)))
+    {
+        fprintf(stderr, "%s: read error.\n", pacIn);
+        fclose(phIn);
+        return EXIT_FAILURE;
+    }
+    fclose(phIn);
+
+    if (0 != _Decode(pu8Dump, (size_t)lSize, pacIn))
+    {
+        return EXIT_FAILURE;
+    }
+
+    _WriteJSON();
+
+    if (stdout != _stDecode.phOut)
+    {
+        fclose(_stDecode.phOut);
+    }
+
+    fprintf(stderr, "%zu events, %.3f ms\n",
+        _stDecode.uEvents,
+        (0 == _stDecode.uEvents) ? 0.0 : (_ToMicroseconds(_stDecode.pstEvent[_stDecode.uEvents - 1].u64Time) / 1000.0));
+
+    free(pu8Dump);
+    free(_stDecode.pstEvent);
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief  Order events by time, then by buffer position
+ * @return Comparison result for qsort()
+ */
+static int _Compare(const void* pA, const void* pB)
+{
+    const DecodedEvent* pstA = pA;
+    const DecodedEvent* pstB = pB;
+
+    if (pstA->u64Time != pstB->u64Time)
+    {
+        return (pstA->u64Time < pstB->u64Time) ? -1 : 1;
+    }
+
+    return (pstA->uIndex < pstB->uIndex) ? -1 : 1;
+}
+
+/**
+ * @brief   Parse dump and unwrap time stamps
+ * @details An event may be logged by an interrupt between claiming a
+ *          slot and reading the cycle counter of the interrupted event,
+ *          so neighbouring events can be slightly out of order.  The
+ *          signed difference of consecutive time stamps handles both
+ *          this and the counter wrapping around; the events are sorted
+ *          afterwards.
+ * @param   pu8Dump
+ *          Pointer to dump
+ * @param   uSize
+ *          Size of dump in byte
+ * @param   pacPath
+ *          Path, for error messages
+ * @return  Error code
+ * @retval   0: OK
+ * @retval  -1: Error
+ */
+static int _Decode(const uint8_t* pu8Dump, size_t uSize, const char* pacPath)
+{
+    uint8_t*          pu8Data  = malloc((0 < uSize) ? uSize : 1);
+    const TraceEvent* pstEvent;
+    size_t            uOffset  = 0;
+    size_t            uFirst   = 0;
+    uint64_t          u64Time  = 0;
+    uint32_t          u32Last  = 0;
+    uint32_t          u32Magic = TRACE_MAGIC;
+
+    if (NULL == pu8Data)
+    {
+        return -1;
+    }
+    memcpy(pu8Data, pu8Dump, uSize);
+
+    if ((sizeof(u32Magic) > uSize) || (0 != memcmp(pu8Data, &u32Magic, sizeof(u32Magic))))
+    {
+        uSize = _ExtractITM(pu8Data, uSize);
+    }
+
+    // Use the first dump found
+    while (((uOffset + sizeof(u32Magic)) <= uSize) && (0 != memcmp(pu8Data + uOffset, &u32Magic, sizeof(u32Magic))))
+    {
+        uOffset += sizeof(uint32_t);
+    }
+
+    if ((uOffset + sizeof(TraceHeader)) > uSize)
+    {
+        fprintf(stderr, "%s: no trace found.\n", pacPath);
+        free(pu8Data);
+        return -1;
+    }
+
+    memcpy(&_stDecode.stHeader, pu8Data + uOffset, sizeof(TraceHeader));
+    uOffset += sizeof(TraceHeader);
+
+    if ((TRACE_VERSION != _stDecode.stHeader.u16Version) ||
+        (0 == _stDecode.stHeader.u32CoreClock) ||
+        ((uOffset + (_stDecode.stHeader.u16Events * sizeof(TraceEvent))) > uSize))
+    {
+        fprintf(stderr, "%s: invalid or truncated trace.\n", pacPath);
+        free(pu8Data);
+        return -1;
+    }
+
+    pstEvent = (const TraceEvent*)(pu8Data + uOffset);
+
+    _stDecode.uEvents = _stDecode.stHeader.u16Events;
+    if (_stDecode.stHeader.u32Head < _stDecode.uEvents)
+    {
+        _stDecode.uEvents = _stDecode.stHeader.u32Head;
+    }
+    else
+    {
+        uFirst = _stDecode.stHeader.u32Head % _stDecode.stHeader.u16Events;
+    }
+
+    _stDecode.pstEvent = calloc((0 < _stDecode.uEvents) ? _stDecode.uEvents : 1, sizeof(DecodedEvent));
+    if (NULL == _stDecode.pstEvent)
+    {
+        free(pu8Data);
+        return -1;
+    }
+
+    for (size_t uIdx = 0; uIdx < _stDecode.uEvents; uIdx++)
+    {
+        DecodedEvent* pstDecoded = &_stDecode.pstEvent[uIdx];
+
+        pstDecoded->stEvent = pstEvent[(uFirst + uIdx) % _stDecode.stHeader.u16Events];
+        pstDecoded->uIndex  = uIdx;
+
+        if (0 == uIdx)
+        {
+            // Start with an offset, so early events out of order stay positive
+            u64Time = 1ULL << 32;
+        }
+        else
+        {
+            u64Time += (uint64_t)((int64_t)(int32_t)(pstDecoded->stEvent.u32Cycles - u32Last));
+        }
+        u32Last             = pstDecoded->stEvent.u32Cycles;
+        pstDecoded->u64Time = u64Time;
+    }
+
+    qsort(_stDecode.pstEvent, _stDecode.uEvents, sizeof(DecodedEvent), _Compare);
+
+    if (0 != _stDecode.uEvents)
+    {
+        uint64_t u64Base = _stDecode.pstEvent[0].u64Time;
+
+        for (size_t uIdx = 0; uIdx < _stDecode.uEvents; uIdx++)
+        {
+            _stDecode.pstEvent[uIdx].u64Time -= u64Base;
+        }
+    }
+
+    free(pu8Data);
+
+    return 0;
+}
+
+/**
+ * @brief  Extract stimulus port payload from ITM packets in place
+ * @param  pu8Data
+ *         Pointer to SWO capture, overwritten with the payload
+ * @param  uSize
+ *         Size of capture in byte
+ * @return Size of payload in byte
+ */
+static size_t _ExtractITM(uint8_t* pu8Data, size_t uSize)
+{
+    size_t uIn  = 0;
+    size_t uOut = 0;
+
+    while (uIn < uSize)
+    {
+        uint8_t u8Header = pu8Data[uIn++];
+        size_t  uLength;
+
+        if ((0x00 == u8Header) || (0x80 == u8Header))
+        {
+            // Synchronisation
+            continue;
+        }
+
+        if (0 != (u8Header & 0x03))
+        {
+            // Source packet, bit 2 set for hardware source
+            uLength = (0x03 == (u8Header & 0x03)) ? 4 : (u8Header & 0x03);
+            if ((uIn + uLength) > uSize)
+            {
+                break;
+            }
+
+            if ((0 == (u8Header & 0x04)) && (TRACE_DECODE_ITM_PORT == (u8Header >> 3)))
+            {
+                memmove(pu8Data + uOut, pu8Data + uIn, uLength);
+                uOut += uLength;
+            }
+            uIn += uLength;
+        }
+        else if (0 != (u8Header & 0x80))
+        {
+            // Time stamp or extension packet with continuation bytes
+            while ((uIn < uSize) && (0 != (pu8Data[uIn++] & 0x80)));
+        }
+    }
+
+    return uOut;
+}
+
+/**
+ * @brief Write complete event
+ * @param eTrack
+ *        Track
+ * @param pacName
+ *        Slice name
+ * @param u64Start
+ *        Start in cycles
+ * @param u64End
+ *        End in cycles
+ */
+static void _Slice(TraceTrack eTrack, const char* pacName, uint64_t u64Start, uint64_t u64End)
+{
+    fprintf(_stDecode.phOut,
+        "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+        _stDecode.bFirst ? "" : ",",
+        pacName,
+        eTrack,
+        _ToMicroseconds(u64Start),
+        _ToMicroseconds(u64End - u64Start));
+
+    _stDecode.bFirst = false;
+}
+
+/**
+ * @brief  Get task name
+ * @param  u8Task
+ *         Task index
+ * @return Name
+ */
+static const char* _TaskName(uint8_t u8Task)
+{
+    if ((TRACE_MAX_TASKS <= u8Task) || ('\0' == _stDecode.stHeader.aacTask[u8Task][0]))
+    {
+        return "(unknown)";
+    }
+
+    return _stDecode.stHeader.aacTask[u8Task];
+}
+
+/**
+ * @brief  Convert CPU cycles to µs
+ * @param  u64Cycles
+ *         CPU cycles
+ * @return Microseconds
+ */
+static double _ToMicroseconds(uint64_t u64Cycles)
+{
+    return ((double)u64Cycles * 1000000.0) / (double)_stDecode.stHeader.u32CoreClock;
+}
+
+/**
+ * @brief   Write Chrome trace JSON
+ * @details Slices still running at the end of the buffer are closed at
+ *          the last event; ends without a start (older than the
+ *          buffer) are dropped.
+ */
+static void _WriteJSON(void)
+{
+    uint64_t u64TaskStart = 0;
+    uint64_t u64End       = 0;
+    uint8_t  u8Task       = 0;
+    bool     bTaskRunning = false;
+
+    static const char* const apacTrack[] = { NULL, "Tasks", "Interrupts", "Markers" };
+
+    _stDecode.bFirst = true;
+
+    fprintf(_stDecode.phOut, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (int nTrack = TRACK_TASKS; nTrack <= TRACK_MARKERS; nTrack++)
+    {
+        fprintf(_stDecode.phOut,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            _stDecode.bFirst ? "" : ",",
+            nTrack,
+            apacTrack[nTrack]);
+        _stDecode.bFirst = false;
+    }
+
+    for (size_t uIdx = 0; uIdx < _stDecode.uEvents; uIdx++)
+    {
+        const DecodedEvent* pstDecoded = &_stDecode.pstEvent[uIdx];
+        uint8_t             u8Id       = pstDecoded->stEvent.u8Id;
+        uint64_t            u64Time    = pstDecoded->u64Time;
+
+        switch (pstDecoded->stEvent.u8Type)
+        {
+            case TRACE_EVENT_TASK_IN:
+                if (bTaskRunning)
+                {
+                    _Slice(TRACK_TASKS, _TaskName(u8Task), u64TaskStart, u64Time);
+                }
+                u8Task       = u8Id;
+                u64TaskStart = u64Time;
+                bTaskRunning = true;
+                break;
+            case TRACE_EVENT_IRQ_ENTER:
+                if (NUM_OF_TRACE_IRQS > u8Id)
+                {
+                    _stDecode.au64IrqStart[u8Id] = u64Time;
+                    _stDecode.abIrqRunning[u8Id] = true;
+                }
+                break;
+            case TRACE_EVENT_IRQ_EXIT:
+                if ((NUM_OF_TRACE_IRQS > u8Id) && _stDecode.abIrqRunning[u8Id])
+                {
+                    _Slice(TRACK_IRQS, _apacIrq[u8Id], _stDecode.au64IrqStart[u8Id], u64Time);
+                    _stDecode.abIrqRunning[u8Id] = false;
+                }
+                break;
+            case TRACE_EVENT_BEGIN:
+                if (NUM_OF_TRACE_MARKERS > u8Id)
+                {
+                    _stDecode.au64MarkStart[u8Id] = u64Time;
+                    _stDecode.abMarkRunning[u8Id] = true;
+                }
+                break;
+            case TRACE_EVENT_END:
+                if ((NUM_OF_TRACE_MARKERS > u8Id) && _stDecode.abMarkRunning[u8Id])
+                {
+                    _Slice(TRACK_MARKERS, _apacMarker[u8Id], _stDecode.au64MarkStart[u8Id], u64Time);
+                    _stDecode.abMarkRunning[u8Id] = false;
+                }
+                break;
+            case TRACE_EVENT_INSTANT:
+                if (NUM_OF_TRACE_MARKERS > u8Id)
+                {
+                    fprintf(_stDecode.phOut,
+                        ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%u}}",
+                        _apacMarker[u8Id],
+                        TRACK_MARKERS,
+                        _ToMicroseconds(u64Time),
+                        pstDecoded->stEvent.u16Value);
+                }
+                break;
+            default:
+                break;
+        }
+        u64End = u64Time;
+    }
+
+    if (bTaskRunning)
+    {
+        _Slice(TRACK_TASKS, _TaskName(u8Task), u64TaskStart, u64End);
+    }
+
+    for (uint8_t u8Idx = 0; u8Idx < NUM_OF_TRACE_IRQS; u8Idx++)
+    {
+        if (_stDecode.abIrqRunning[u8Idx])
+        {
+            _Slice(TRACK_IRQS, _apacIrq[u8Idx], _stDecode.au64IrqStart[u8Idx], u64End);
+        }
+    }
+
+    for (uint8_t u8Idx = 0; u8Idx < NUM_OF_TRACE_MARKERS; u8Idx++)
+    {
+        if (_stDecode.abMarkRunning[u8Idx])
+        {
+            _Slice(TRACK_MARKERS, _apacMarker[u8Idx], _stDecode.au64MarkStart[u8Idx], u64End);
+        }
+    }
+
+    fprintf(_stDecode.phOut, "\n]}\n");
+}
+
+#endif // USE_TRACE_DECODE
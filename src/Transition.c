@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      Transition.c
+ * @brief     Screen transitions
+ * @details   Blends two frame buffers over a number of frames into a
+ *            single transition buffer.  Every frame is composed from
+ *            the live source buffers, so a running clock keeps ticking
+ *            during the transition, and each row is handled as one
+ *            32-bit word: a slide is a 64-bit shift of the row pair,
+ *            wipe and dissolve select pixels by a mask.  A frame costs
+ *            the same few instructions per row whatever the effect and
+ *            progress; it is measured by the host benchmark
+ *            (TransitionBench.c) and on the target by the
+ *            PROFILE_TRANSITION probe.
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "DMD.h"
+#include "Profile.h"
+#include "Transition.h"
+
+#if 32 != DMD_WIDTH
+#error "Transitions expect one 32-bit word per frame buffer row"
+#endif
+
+#define TRANSITION_ROW_BYTES (DMD_WIDTH / 8) ///< Frame buffer bytes per row
+#define TRANSITION_LEVELS    16U             ///< Number of dissolve thresholds
+#define TRANSITION_REPEAT    0x11111111UL    ///< Repeats a nibble across a row
+
+/**
+ * @struct TransitionData
+ * @brief  Transition data
+ */
+typedef struct
+{
+    uint8_t          au8Buffer[TRANSITION_ROW_BYTES * DMD_HEIGHT]; ///< Composed frame
+    uint8_t*         pu8From;                                      ///< Old screen
+    uint8_t*         pu8To;                                        ///< New screen
+    TransitionEffect eEffect;                                      ///< Effect
+    uint8_t          u8Frame;                                      ///< Frames composed so far
+    uint8_t          u8Frames;                                     ///< Total number of frames
+
+} TransitionData;
+
+/**
+ * @var   _stTransition
+ * @brief Transition private data
+ */
+static TransitionData _stTransition = { 0 };
+
+/**
+ * @var   _au8Bayer
+ * @brief 4x4 ordered dither thresholds
+ * @note  Half of the levels form a checkerboard.
+ */
+static const uint8_t _au8Bayer[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+static uint32_t _LoadRow(const uint8_t* pu8Buffer, uint8_t u8Row);
+static void     _StoreRow(uint8_t* pu8Buffer, uint8_t u8Row, uint32_t u32Bits);
+
+/**
+ * @brief  Get transition buffer address
+ * @return Pointer to the composed frame
+ */
+uint8_t* Transition_GetBufferAddr(void)
+{
+    return _stTransition.au8Buffer;
+}
+
+/**
+ * @brief  Check if a transition is running
+ * @return Boolean state
+ */
+bool Transition_IsRunning(void)
+{
+    return (_stTransition.u8Frame < _stTransition.u8Frames);
+}
+
+/**
+ * @brief Start transition
+ * @note  The first frame is composed right away, so the transition
+ *        buffer can be displayed immediately.  A running transition is
+ *        replaced.
+ * @param eEffect
+ *        Effect
+ * @param pu8From
+ *        Pointer to the frame buffer of the old screen
+ * @param pu8To
+ *        Pointer to the frame buffer of the new screen
+ * @param u8Frames
+ *        Number of frames until the new screen is shown completely,
+ *        at least 1
+ */
+void Transition_Start(TransitionEffect eEffect, uint8_t* pu8From, uint8_t* pu8To, uint8_t u8Frames)
+{
+    _stTransition.pu8From  = pu8From;
+    _stTransition.pu8To    = pu8To;
+    _stTransition.eEffect  = eEffect;
+    _stTransition.u8Frame  = 0;
+    _stTransition.u8Frames = (0 == u8Frames) ? 1U : u8Frames;
+
+    (void)Transition_Step();
+}
+
+/**
+ * @brief  Compose next frame
+ * @return Frame buffer to be displayed: the transition buffer while
+ *         the transition is running, the new screen once it is done
+ */
+uint8_t* Transition_Step(void)
+{
+    uint32_t au32Mask[4] = { UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX };
+    uint8_t  u8Rows      = DMD_HEIGHT;
+    uint8_t  u8Frame;
+
+    PROFILE_SCOPE(PROFILE_TRANSITION);
+
+    if (! Transition_IsRunning())
+    {
+        return _stTransition.pu8To;
+    }
+
+    _stTransition.u8Frame++;
+    u8Frame = _stTransition.u8Frame;
+
+    if (TRANSITION_SLIDE == _stTransition.eEffect)
+    {
+        uint8_t u8Shift = (uint8_t)((DMD_WIDTH * u8Frame) / _stTransition.u8Frames);
+
+        for (uint8_t u8Row = 0; u8Row < DMD_HEIGHT; u8Row++)
+        {
+            uint64_t u64Pair = ((uint64_t)_LoadRow(_stTransition.pu8From, u8Row) << 32) | _LoadRow(_stTransition.pu8To, u8Row);
+
+            _StoreRow(_stTransition.au8Buffer, u8Row, (uint32_t)((u64Pair << u8Shift) >> 32));
+        }
+    }
+    else
+    {
+        if (TRANSITION_WIPE == _stTransition.eEffect)
+        {
+            u8Rows = (uint8_t)((DMD_HEIGHT * u8Frame) / _stTransition.u8Frames);
+        }
+        else if (TRANSITION_DISSOLVE == _stTransition.eEffect)
+        {
+            uint8_t u8Level = (uint8_t)((TRANSITION_LEVELS * u8Frame) / _stTransition.u8Frames);
+
+            for (uint8_t u8Y = 0; u8Y < 4U; u8Y++)
+            {
+                uint32_t u32Nibble = 0;
+
+                for (uint8_t u8X = 0; u8X < 4U; u8X++)
+                {
+                    if (_au8Bayer[u8Y][u8X] < u8Level)
+                    {
+                        u32Nibble |= 8UL >> u8X;
+                    }
+                }
+                au32Mask[u8Y] = u32Nibble * TRANSITION_REPEAT;
+            }
+        }
+
+        // Pixels of the new screen: the first u8Rows rows, where the
+        // dither pattern of the row is set
+        for (uint8_t u8Row = 0; u8Row < DMD_HEIGHT; u8Row++)
+        {
+            uint32_t u32From = _LoadRow(_stTransition.pu8From, u8Row);
+            uint32_t u32To   = _LoadRow(_stTransition.pu8To, u8Row);
+            uint32_t u32Mask = au32Mask[u8Row & 3U] & ((u8Row < u8Rows) ? UINT32_MAX : 0);
+
+            _StoreRow(_stTransition.au8Buffer, u8Row, u32From ^ ((u32From ^ u32To) & u32Mask));
+        }
+    }
+
+    if (Transition_IsRunning())
+    {
+        return _stTransition.au8Buffer;
+    }
+
+    return _stTransition.pu8To;
+}
+
+/**
+ * @brief  Load frame buffer row
+ * @param  pu8Buffer
+ *         Pointer to frame buffer
+ * @param  u8Row
+ *         Row
+ * @return Pixels, MSB left
+ */
+static uint32_t _LoadRow(const uint8_t* pu8Buffer, uint8_t u8Row)
+{
+    uint32_t u32Bits;
+
+    // Single load and byte reversal (LDR + REV on the Cortex-M3)
+    memcpy(&u32Bits, &pu8Buffer[u8Row * TRANSITION_ROW_BYTES], sizeof(u32Bits));
+
+    return __builtin_bswap32(u32Bits);
+}
+
+/**
+ * @brief Store frame buffer row
+ * @param pu8Buffer
+ *        Pointer to frame buffer
+ * @param u8Row
+ *        Row
+ * @param u32Bits
+ *        Pixels, MSB left
+ */
+static void _StoreRow(uint8_t* pu8Buffer, uint8_t u8Row, uint32_t u32Bits)
+{
+    u32Bits = __builtin_bswap32(u32Bits);
+    memcpy(&pu8Buffer[u8Row * TRANSITION_ROW_BYTES], &u32Bits, sizeof(u32Bits));
+}
@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file  Transition.h
+ * @brief Screen transitions
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @enum  TransitionEffect
+ * @brief Transition effects
+ */
+typedef enum
+{
+    TRANSITION_SLIDE = 0, ///< New screen pushes the old one out to the left
+    TRANSITION_WIPE,      ///< New screen is revealed from top to bottom
+    TRANSITION_DISSOLVE,  ///< New screen fades in by an ordered checkerboard pattern
+    NUM_OF_TRANSITIONS    ///< Total number of transition effects
+
+} TransitionEffect;
+
+uint8_t* Transition_GetBufferAddr(void);
+bool     Transition_IsRunning(void);
+void     Transition_Start(TransitionEffect eEffect, uint8_t* pu8From, uint8_t* pu8To, uint8_t u8Frames);
+uint8_t* Transition_Step(void);
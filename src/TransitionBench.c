@@ -0,0 +1,353 @@
+// SPDX-License-Identifier: Beerware
+/**
+ * @file      TransitionBench.c
+ * @brief     Host benchmark of the screen transitions
+ * @details   Checks every frame of every effect against a per-pixel
+ *            reference for all frame counts from 1 to
+ *            @ref BENCH_MAX_FRAMES, then measures the time of
+ *            @ref Transition_Step per effect.  Fails if a frame differs
+ *            from the reference or if the median time of a frame
+ *            exceeds the budget.
+ *
+ *            The effects run the same instruction sequence whatever
+ *            their progress, so the budget guards against regressions
+ *            which would scale with the content or the frame count.
+ * @code{.unparsed}
+ * Usage: program [-n frames] [-b budget in ns]
+ * @endcode
+ * @author    Michael Fitzmayer
+ * @copyright "THE BEER-WARE LICENCE" (Revision 42)
+ */
+
+#ifdef USE_TRANSITIONBENCH
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "DMD.h"
+#include "Transition.h"
+
+#define BENCH_BUFFER_SIZE ((DMD_WIDTH / 8) * DMD_HEIGHT) ///< Frame buffer size in bytes
+#define BENCH_MAX_FRAMES  32U                           ///< Max. frame count checked
+#define BENCH_SAMPLES     65536                         ///< Timing samples kept per effect
+
+/**
+ * @struct BenchData
+ * @brief  Benchmark data
+ */
+typedef struct
+{
+    uint8_t  au8From[BENCH_BUFFER_SIZE]; ///< Old screen
+    uint8_t  au8To[BENCH_BUFFER_SIZE];   ///< New screen
+    uint32_t au32Time[BENCH_SAMPLES];    ///< Frame times in ns
+    uint32_t u32Overhead;                ///< Cost of a time stamp pair in ns
+    uint32_t u32Errors;                  ///< Frames differing from the reference
+
+} BenchData;
+
+/**
+ * @var   _stBench
+ * @brief Benchmark private data
+ */
+static BenchData _stBench;
+
+/**
+ * @var   _apacEffect
+ * @brief Effect names
+ */
+static const char* const _apacEffect[NUM_OF_TRANSITIONS] = {
+    "Slide",
+    "Wipe",
+    "Dissolve"
+};
+
+/**
+ * @var   _au8Bayer
+ * @brief 4x4 ordered dither thresholds, see Transition.c
+ */
+static const uint8_t _au8Bayer[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+static void     _Check(TransitionEffect eEffect, uint8_t u8Frames);
+static int      _Compare(const void* pvA, const void* pvB);
+static bool     _GetPixel(const uint8_t* pu8Buffer, uint8_t u8X, uint8_t u8Y);
+static uint64_t _Now(void);
+static uint32_t _Random(uint64_t* pu64State);
+static bool     _Reference(TransitionEffect eEffect, uint8_t u8Frame, uint8_t u8Frames, uint8_t u8X, uint8_t u8Y);
+static uint32_t _Run(TransitionEffect eEffect, uint32_t u32Frames);
+
+/**
+ * @brief  Transition benchmark entry point
+ * @return Exit code
+ */
+int main(int nArgc, char* apcArgv[])
+{
+    uint64_t u64Seed   = 0x5EEDULL;
+    uint32_t u32Frames = 1000000;
+    uint32_t u32Budget = 1000;
+    uint32_t u32Min    = UINT32_MAX;
+    uint32_t u32Failed = 0;
+    int      nOpt;
+
+    while (-1 != (nOpt = getopt(nArgc, apcArgv, "n:b:")))
+    {
+        switch (nOpt)
+        {
+            case 'n':
+                u32Frames = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                u32Budget = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n frames] [-b budget in ns]\n", apcArgv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (0 == u32Frames)
+    {
+        fprintf(stderr, "Number of frames must not be 0\n");
+        return EXIT_FAILURE;
+    }
+
+    for (uint8_t u8Idx = 0; u8Idx < BENCH_BUFFER_SIZE; u8Idx++)
+    {
+        _stBench.au8From[u8Idx] = (uint8_t)_Random(&u64Seed);
+        _stBench.au8To[u8Idx]   = (uint8_t)_Random(&u64Seed);
+    }
+
+    for (uint8_t u8Effect = 0; u8Effect < NUM_OF_TRANSITIONS; u8Effect++)
+    {
+        for (uint8_t u8Frames = 1; u8Frames <= BENCH_MAX_FRAMES; u8Frames++)
+        {
+            _Check((TransitionEffect)u8Effect, u8Frames);
+        }
+    }
+    printf("Reference check: %u frames differ\n", _stBench.u32Errors);
+
+    for (uint32_t u32Idx = 0; u32Idx < 1000; u32Idx++)
+    {
+        uint64_t u64Start = _Now();
+        uint32_t u32Cost  = (uint32_t)(_Now() - u64Start);
+
+        if (u32Min > u32Cost)
+        {
+            u32Min = u32Cost;
+        }
+    }
+    _stBench.u32Overhead = u32Min;
+
+    printf("%u frames per effect, budget %u ns per frame\n", u32Frames, u32Budget);
+    for (uint8_t u8Effect = 0; u8Effect < NUM_OF_TRANSITIONS; u8Effect++)
+    {
+        uint32_t u32Median = _Run((TransitionEffect)u8Effect, u32Frames);
+        bool     bOver     = (u32Median > u32Budget);
+
+        printf("%-9s median %5u ns per frame%s\n", _apacEffect[u8Effect], u32Median, bOver ? "  OVER BUDGET" : "");
+        if (bOver)
+        {
+            u32Failed++;
+        }
+    }
+
+    return ((0 == _stBench.u32Errors) && (0 == u32Failed)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Compare every frame of a transition with the reference
+ * @param eEffect
+ *        Effect
+ * @param u8Frames
+ *        Number of frames
+ */
+static void _Check(TransitionEffect eEffect, uint8_t u8Frames)
+{
+    uint8_t* pu8Buffer = Transition_GetBufferAddr();
+    uint8_t* pu8Shown  = pu8Buffer;
+
+    Transition_Start(eEffect, _stBench.au8From, _stBench.au8To, u8Frames);
+
+    for (uint8_t u8Frame = 1; u8Frame <= u8Frames; u8Frame++)
+    {
+        bool bSame = true;
+
+        for (uint8_t u8Y = 0; u8Y < DMD_HEIGHT; u8Y++)
+        {
+            for (uint8_t u8X = 0; u8X < DMD_WIDTH; u8X++)
+            {
+                if (_GetPixel(pu8Buffer, u8X, u8Y) != _Reference(eEffect, u8Frame, u8Frames, u8X, u8Y))
+                {
+                    bSame = false;
+                }
+            }
+        }
+
+        if (! bSame)
+        {
+            _stBench.u32Errors++;
+        }
+
+        if (u8Frame < u8Frames)
+        {
+            pu8Shown = Transition_Step();
+        }
+    }
+
+    // Transition_Start() has composed the only frame already
+    if (1U == u8Frames)
+    {
+        pu8Shown = Transition_Step();
+    }
+
+    if ((Transition_IsRunning()) || (_stBench.au8To != pu8Shown))
+    {
+        _stBench.u32Errors++;
+    }
+}
+
+/**
+ * @brief  Compare two timing samples
+ * @param  pvA
+ *         Pointer to first sample
+ * @param  pvB
+ *         Pointer to second sample
+ * @return Comparison result for qsort()
+ */
+static int _Compare(const void* pvA, const void* pvB)
+{
+    uint32_t u32A = *(const uint32_t*)pvA;
+    uint32_t u32B = *(const uint32_t*)pvB;
+
+    return (u32A > u32B) - (u32A < u32B);
+}
+
+/**
+ * @brief  Get pixel
+ * @param  pu8Buffer
+ *         Pointer to frame buffer
+ * @param  u8X
+ *         Column
+ * @param  u8Y
+ *         Row
+ * @return Pixel state
+ */
+static bool _GetPixel(const uint8_t* pu8Buffer, uint8_t u8X, uint8_t u8Y)
+{
+    return (0 != (pu8Buffer[(u8Y * (DMD_WIDTH / 8)) + (u8X / 8)] & (0x80 >> (u8X % 8))));
+}
+
+/**
+ * @brief  Get monotonic time
+ * @return Time in ns
+ */
+static uint64_t _Now(void)
+{
+    struct timespec stTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &stTime);
+
+    return ((uint64_t)stTime.tv_sec * 1000000000ULL) + (uint64_t)stTime.tv_nsec;
+}
+
+/**
+ * @brief  xorshift64* pseudo random number generator
+ * @param  pu64State
+ *         Pointer to generator state
+ * @return Random number
+ */
+static uint32_t _Random(uint64_t* pu64State)
+{
+    *pu64State ^= *pu64State >> 12;
+    *pu64State ^= *pu64State << 25;
+    *pu64State ^= *pu64State >> 27;
+
+    return (uint32_t)((*pu64State * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief  Reference pixel of a transition frame
+ * @param  eEffect
+ *         Effect
+ * @param  u8Frame
+ *         Frame (1 to u8Frames)
+ * @param  u8Frames
+ *         Number of frames
+ * @param  u8X
+ *         Column
+ * @param  u8Y
+ *         Row
+ * @return Pixel state
+ */
+static bool _Reference(TransitionEffect eEffect, uint8_t u8Frame, uint8_t u8Frames, uint8_t u8X, uint8_t u8Y)
+{
+    switch (eEffect)
+    {
+        case TRANSITION_SLIDE:
+        {
+            uint8_t u8Source = u8X + (uint8_t)((DMD_WIDTH * u8Frame) / u8Frames);
+
+            if (u8Source < DMD_WIDTH)
+            {
+                return _GetPixel(_stBench.au8From, u8Source, u8Y);
+            }
+            return _GetPixel(_stBench.au8To, u8Source - DMD_WIDTH, u8Y);
+        }
+        case TRANSITION_WIPE:
+            if (u8Y < ((DMD_HEIGHT * u8Frame) / u8Frames))
+            {
+                return _GetPixel(_stBench.au8To, u8X, u8Y);
+            }
+            return _GetPixel(_stBench.au8From, u8X, u8Y);
+        case TRANSITION_DISSOLVE:
+        default:
+            if (_au8Bayer[u8Y % 4][u8X % 4] < ((16U * u8Frame) / u8Frames))
+            {
+                return _GetPixel(_stBench.au8To, u8X, u8Y);
+            }
+            return _GetPixel(_stBench.au8From, u8X, u8Y);
+    }
+}
+
+/**
+ * @brief  Measure frames of one effect
+ * @param  eEffect
+ *         Effect
+ * @param  u32Frames
+ *         Number of frames
+ * @return Median time of a frame in ns
+ */
+static uint32_t _Run(TransitionEffect eEffect, uint32_t u32Frames)
+{
+    uint32_t u32Samples = (u32Frames < BENCH_SAMPLES) ? u32Frames : BENCH_SAMPLES;
+
+    for (uint32_t u32Idx = 0; u32Idx < u32Frames; u32Idx++)
+    {
+        uint64_t u64Start;
+        uint32_t u32Time;
+
+        if (! Transition_IsRunning())
+        {
+            Transition_Start(eEffect, _stBench.au8From, _stBench.au8To, UINT8_MAX);
+        }
+
+        u64Start = _Now();
+        (void)Transition_Step();
+        u32Time  = (uint32_t)(_Now() - u64Start);
+
+        _stBench.au32Time[u32Idx % BENCH_SAMPLES] = (u32Time > _stBench.u32Overhead) ? (u32Time - _stBench.u32Overhead) : 0;
+    }
+
+    qsort(_stBench.au32Time, u32Samples, sizeof(uint32_t), _Compare);
+
+    return _stBench.au32Time[u32Samples / 2U];
+}
+
+#endif // USE_TRANSITIONBENCH